@@ -0,0 +1,113 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string.h"
+
+// the lock-free implementation packs a node pointer and a count into one
+// 64-bit word, which needs pointers of no more than 48 significant bits
+#if defined(__x86_64__)  ||  defined(_M_X64)  ||  defined(__aarch64__)  ||  defined(_M_ARM64)
+#define HAS_SPLIT_REFERENCE_COUNT 1
+#endif
+
+namespace cdmh {
+
+namespace detail {
+
+template<typename T>
+struct atomic_cell_node
+{
+    explicit atomic_cell_node(std::shared_ptr<T const> const &value) : value(value), refs(0) { }
+
+    std::shared_ptr<T const>    value;
+    std::atomic<std::int64_t>   refs;   // references released after the node left the cell, less those it had
+};
+
+}   // namespace detail
+
+// a cell holding an immutable string that can be read and replaced
+// concurrently, for values such as configuration that are read on every
+// request and occasionally reloaded. load() returns a shared reference to
+// the current value, which remains valid after the cell is changed; the old
+// value is freed when its last reader releases it.
+//
+// the cell uses split reference counting: a reader increments a count kept
+// in the same word as the node pointer with a single atomic add, copies the
+// shared reference and gives its count back. a writer swaps the word and
+// hands the count of readers still in flight to the old node, which is
+// deleted by whichever of them releases it last. neither readers nor
+// writers take a lock. the count allows up to 65535 loads in flight at once
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_atomic_immutable_string
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc> value_type;
+    typedef std::shared_ptr<value_type const>           pointer;
+
+    basic_atomic_immutable_string();
+    explicit basic_atomic_immutable_string(value_type value);
+    explicit basic_atomic_immutable_string(pointer const &value);
+    ~basic_atomic_immutable_string();
+
+    pointer     load(void)                                                      const;
+    void        store(value_type value);
+    void        store(pointer const &value);
+    pointer     exchange(pointer const &value);
+
+    // replaces the value if it is still the one that expected refers to, in
+    // the manner of std::atomic; otherwise loads the current value into expected
+    bool  const compare_exchange(pointer &expected, pointer const &desired);
+
+    static bool const is_lock_free(void) noexcept;
+
+  private:
+#if HAS_SPLIT_REFERENCE_COUNT
+    typedef detail::atomic_cell_node<value_type> node;
+
+    static std::uint64_t const count_shift = 48;
+    static std::uint64_t const one         = std::uint64_t(1) << count_shift;
+    static std::uint64_t const node_mask   = one - 1;
+
+    static node          *to_node(std::uint64_t word) noexcept { return reinterpret_cast<node *>(static_cast<std::uintptr_t>(word & node_mask)); }
+    static std::uint64_t  to_word(node *n);
+
+    node *acquire(void)                                                         const;
+    void  release(node *n)                                                      const;
+    static void retire(node *n, std::uint64_t word);
+
+    mutable std::atomic<std::uint64_t> word_;
+#else
+    pointer value_;
+#endif
+
+    basic_atomic_immutable_string(basic_atomic_immutable_string const &);
+    basic_atomic_immutable_string &operator=(basic_atomic_immutable_string const &);
+};
+
+typedef basic_atomic_immutable_string<char>    atomic_immutable_string;
+typedef basic_atomic_immutable_string<wchar_t> atomic_immutable_wstring;
+
+}   // namespace cdmh
+
+#include "atomic_immutable_string.inl"
@@ -0,0 +1,231 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_atomic_immutable_string<Char, Traits, Alloc>::is_lock_free(void) noexcept
+{
+#if HAS_SPLIT_REFERENCE_COUNT
+    return std::atomic<std::uint64_t>().is_lock_free();
+#else
+    return false;
+#endif
+}
+
+#if HAS_SPLIT_REFERENCE_COUNT
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string()
+  : word_(to_word(new node(std::make_shared<value_type const>())))
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string(value_type value)
+  : word_(to_word(new node(std::make_shared<value_type const>(std::move(value)))))
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string(pointer const &value)
+  : word_(to_word(new node(value)))
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::~basic_atomic_immutable_string()
+{
+    std::uint64_t const word = word_.load(std::memory_order_acquire);
+    retire(to_node(word), word);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::uint64_t basic_atomic_immutable_string<Char, Traits, Alloc>::to_word(node *n)
+{
+    std::uint64_t const word = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(n));
+    assert((word & ~node_mask) == 0);
+    return word;
+}
+
+// takes a reference to the current node by counting it in the cell
+template<typename Char, typename Traits, typename Alloc>
+typename basic_atomic_immutable_string<Char, Traits, Alloc>::node *
+basic_atomic_immutable_string<Char, Traits, Alloc>::acquire(void) const
+{
+    return to_node(word_.fetch_add(one, std::memory_order_acquire));
+}
+
+// gives a reference back to the cell if the node is still current, or to
+// the node if it has been replaced since the reference was taken
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::release(node *n) const
+{
+    std::uint64_t word = word_.load(std::memory_order_relaxed);
+    while (to_node(word) == n)
+    {
+        if (word_.compare_exchange_weak(word, word - one, std::memory_order_release, std::memory_order_relaxed))
+            return;
+    }
+
+    if (n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete n;
+}
+
+// hands the count of a word that has been swapped out of the cell to its
+// node; the readers it counts will release their references to the node
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::retire(node *n, std::uint64_t word)
+{
+    std::int64_t const count = static_cast<std::int64_t>(word >> count_shift);
+    if (n->refs.fetch_add(count, std::memory_order_acq_rel) == -count)
+        delete n;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_atomic_immutable_string<Char, Traits, Alloc>::pointer
+basic_atomic_immutable_string<Char, Traits, Alloc>::load(void) const
+{
+    node *const n = acquire();
+    pointer result(n->value);
+    release(n);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::store(value_type value)
+{
+    exchange(std::make_shared<value_type const>(std::move(value)));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::store(pointer const &value)
+{
+    exchange(value);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_atomic_immutable_string<Char, Traits, Alloc>::pointer
+basic_atomic_immutable_string<Char, Traits, Alloc>::exchange(pointer const &value)
+{
+    node *const replacement = new node(value);
+    std::uint64_t const old = word_.exchange(to_word(replacement), std::memory_order_acq_rel);
+
+    // the cell's own reference keeps the old node alive until it is retired
+    node *const n = to_node(old);
+    pointer result(n->value);
+    retire(n, old);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_atomic_immutable_string<Char, Traits, Alloc>::compare_exchange(pointer &expected, pointer const &desired)
+{
+    node *const n = acquire();
+    if (n->value != expected)
+    {
+        expected = n->value;
+        release(n);
+        return false;
+    }
+
+    // the word changes as readers come and go, so retry while it still
+    // holds the same node
+    node *const replacement = new node(desired);
+    std::uint64_t word = word_.load(std::memory_order_relaxed);
+    while (to_node(word) == n)
+    {
+        if (word_.compare_exchange_weak(word, to_word(replacement), std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            retire(n, word);
+            release(n);
+            return true;
+        }
+    }
+
+    // another writer replaced the value first, so n no longer holds the
+    // current value
+    delete replacement;
+    release(n);
+    expected = load();
+    return false;
+}
+#else
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string()
+  : value_(std::make_shared<value_type const>())
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string(value_type value)
+  : value_(std::make_shared<value_type const>(std::move(value)))
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::basic_atomic_immutable_string(pointer const &value)
+  : value_(value)
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_atomic_immutable_string<Char, Traits, Alloc>::~basic_atomic_immutable_string()
+{
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_atomic_immutable_string<Char, Traits, Alloc>::pointer
+basic_atomic_immutable_string<Char, Traits, Alloc>::load(void) const
+{
+    return std::atomic_load(&value_);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::store(value_type value)
+{
+    std::atomic_store(&value_, std::make_shared<value_type const>(std::move(value)));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_atomic_immutable_string<Char, Traits, Alloc>::store(pointer const &value)
+{
+    std::atomic_store(&value_, value);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_atomic_immutable_string<Char, Traits, Alloc>::pointer
+basic_atomic_immutable_string<Char, Traits, Alloc>::exchange(pointer const &value)
+{
+    return std::atomic_exchange(&value_, value);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_atomic_immutable_string<Char, Traits, Alloc>::compare_exchange(pointer &expected, pointer const &desired)
+{
+    return std::atomic_compare_exchange_strong(&value_, &expected, desired);
+}
+#endif
+
+}   // namespace cdmh
@@ -0,0 +1,122 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string.h"
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace cdmh {
+
+namespace detail {
+
+// a small, fast LZ77 block codec in the style of LZ4. a block is a sequence
+// of (literals, match) pairs; each pair starts with a token byte holding the
+// literal count in the high nibble and the match length - 4 in the low
+// nibble, where 15 means that more length bytes follow. the decompressed
+// size is stored separately, so the final pair holds literals only
+inline void lz_compress(unsigned char const *src, std::size_t n, std::vector<unsigned char> &out);
+inline bool const lz_decompress(unsigned char const *src, std::size_t n, unsigned char *dst, std::size_t dst_n);
+
+// immutable, shared compressed representation of a string
+struct compressed_block
+{
+    std::uint64_t              id;          // cache key, unique for the life of the process
+    std::size_t                length;      // in characters
+    bool                       raw;         // stored uncompressed because it didn't shrink
+    std::vector<unsigned char> bytes;
+};
+
+}   // namespace detail
+
+// an immutable string held in compressed form. the characters are
+// decompressed on demand into a small process-wide cache of recently used
+// strings, so find and compare work on the string transparently
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_compressed_immutable_string
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc> string_type;
+    typedef typename string_type::size_type             size_type;
+
+    static size_type const npos = string_type::npos;
+
+    explicit basic_compressed_immutable_string(string_type const &str);
+    basic_compressed_immutable_string(basic_compressed_immutable_string const &other) : block_(other.block_)             { }
+    basic_compressed_immutable_string(basic_compressed_immutable_string &&other) noexcept : block_(std::move(other.block_)) { }
+
+    // Capacity
+    bool        const empty(void)                                                                            const noexcept { return size() == 0;                   }
+    size_type   const length(void)                                                                           const noexcept { return size();                        }
+    size_type   const size(void)                                                                             const noexcept { return block_->length;                }
+
+    // memory accounting, in bytes
+    std::size_t const compressed_size(void)                                                                  const noexcept { return block_->bytes.size();          }
+    std::size_t const uncompressed_size(void)                                                                const noexcept { return size() * sizeof(Char);         }
+    string_footprint const footprint(void)                                                                   const noexcept;
+
+    // the decompressed string is shared with the cache, and remains valid for
+    // as long as the caller holds the pointer
+    std::shared_ptr<string_type const> decompress(void)                                                      const;
+    string_type                        str(void)                                                             const          { return *decompress();                 }
+
+    int const compare(basic_compressed_immutable_string const &str)                                          const;
+    int const compare(string_type const &str)                                                                const          { return decompress()->compare(str);    }
+    int const compare(Char const *s)                                                                         const          { return decompress()->compare(s);      }
+
+    size_type const find(string_type const &str, size_type pos=0)                                            const          { return decompress()->find(str, pos);  }
+    size_type const find(Char const *s, size_type pos=0)                                                     const          { return decompress()->find(s, pos);    }
+    size_type const find(Char const *s, size_type pos, size_type n)                                          const          { return decompress()->find(s, pos, n); }
+    size_type const find(Char c, size_type pos=0)                                                            const          { return decompress()->find(c, pos);    }
+
+    size_type const rfind(string_type const &str, size_type pos=npos)                                        const          { return decompress()->rfind(str, pos); }
+    size_type const rfind(Char const *s, size_type pos=npos)                                                 const          { return decompress()->rfind(s, pos);   }
+    size_type const rfind(Char const *s, size_type pos, size_type n)                                         const          { return decompress()->rfind(s, pos, n);}
+    size_type const rfind(Char c, size_type pos=npos)                                                        const          { return decompress()->rfind(c, pos);   }
+
+    // the decompression cache is shared by all strings of this type. the
+    // capacity is the total number of decompressed bytes that it may hold
+    static void        set_cache_capacity(std::size_t bytes);
+    static std::size_t cache_capacity(void);
+
+  private:
+    class cache;
+
+    std::shared_ptr<detail::compressed_block const> block_;
+
+#if defined(_MSC_VER)  &&  _MSC_VER < 1800
+    basic_compressed_immutable_string &operator=(basic_compressed_immutable_string);
+#else
+    basic_compressed_immutable_string &operator=(basic_compressed_immutable_string) = delete;
+#endif
+};
+
+typedef basic_compressed_immutable_string<char>    compressed_immutable_string;
+typedef basic_compressed_immutable_string<wchar_t> compressed_immutable_wstring;
+
+}   // namespace cdmh
+
+#include "compressed_immutable_string.inl"
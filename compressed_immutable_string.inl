@@ -0,0 +1,326 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+namespace cdmh {
+
+namespace detail {
+
+inline std::uint32_t lz_read32(unsigned char const *p)
+{
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void lz_write_length(std::vector<unsigned char> &out, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+        out.push_back(255);
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+inline void lz_compress(unsigned char const *src, std::size_t n, std::vector<unsigned char> &out)
+{
+    static std::size_t const min_match  = 4;
+    static std::size_t const max_offset = 65535;
+    static unsigned    const hash_bits  = 12;
+
+    out.clear();
+    out.reserve(n + n / 255 + 16);
+
+    std::vector<std::size_t> table(std::size_t(1) << hash_bits, std::size_t(-1));
+    std::size_t anchor = 0;
+    std::size_t pos    = 0;
+
+    // a match must end at least min_match bytes before the end of the input
+    // so that the final sequence always holds some literals
+    std::size_t const limit = (n > min_match * 2)? n - min_match * 2 : 0;
+    while (pos < limit)
+    {
+        std::uint32_t const sequence = lz_read32(src + pos);
+        std::size_t   const slot     = (sequence * 2654435761u) >> (32 - hash_bits);
+        std::size_t   const candidate = table[slot];
+        table[slot] = pos;
+
+        if (candidate == std::size_t(-1)  ||  pos - candidate > max_offset  ||  lz_read32(src + candidate) != sequence)
+        {
+            ++pos;
+            continue;
+        }
+
+        std::size_t length = min_match;
+        while (pos + length < n - min_match  &&  src[candidate + length] == src[pos + length])
+            ++length;
+
+        std::size_t const literals = pos - anchor;
+        std::size_t const extra    = length - min_match;
+        out.push_back(static_cast<unsigned char>(((literals < 15)? literals : 15) << 4 | ((extra < 15)? extra : 15)));
+        if (literals >= 15)
+            lz_write_length(out, literals - 15);
+        out.insert(out.end(), src + anchor, src + pos);
+
+        std::size_t const offset = pos - candidate;
+        out.push_back(static_cast<unsigned char>(offset & 0xff));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (extra >= 15)
+            lz_write_length(out, extra - 15);
+
+        pos   += length;
+        anchor = pos;
+    }
+
+    std::size_t const literals = n - anchor;
+    out.push_back(static_cast<unsigned char>(((literals < 15)? literals : 15) << 4));
+    if (literals >= 15)
+        lz_write_length(out, literals - 15);
+    out.insert(out.end(), src + anchor, src + n);
+}
+
+inline bool const lz_read_length(unsigned char const *&src, unsigned char const *end, std::size_t &length)
+{
+    unsigned char byte;
+    do
+    {
+        if (src == end)
+            return false;
+        byte    = *src++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// returns false if the block is malformed or doesn't decompress to exactly
+// dst_n bytes; never reads or writes outside of the buffers
+inline bool const lz_decompress(unsigned char const *src, std::size_t n, unsigned char *dst, std::size_t dst_n)
+{
+    unsigned char const *const end = src + n;
+    std::size_t out = 0;
+    while (src != end)
+    {
+        unsigned const token = *src++;
+        std::size_t literals = token >> 4;
+        if (literals == 15  &&  !lz_read_length(src, end, literals))
+            return false;
+        if (literals > std::size_t(end - src)  ||  literals > dst_n - out)
+            return false;
+        std::memcpy(dst + out, src, literals);
+        src += literals;
+        out += literals;
+
+        if (src == end)
+            break;
+
+        if (end - src < 2)
+            return false;
+        std::size_t const offset = src[0] | (std::size_t(src[1]) << 8);
+        src += 2;
+        std::size_t length = token & 0x0f;
+        if (length == 15  &&  !lz_read_length(src, end, length))
+            return false;
+        length += 4;
+        if (offset == 0  ||  offset > out  ||  length > dst_n - out)
+            return false;
+
+        // byte by byte, as the match may overlap the bytes it produces
+        for (unsigned char const *from = dst + out - offset; length != 0; --length)
+            dst[out++] = *from++;
+    }
+    return out == dst_n;
+}
+
+inline std::uint64_t const next_compressed_block_id(void)
+{
+    static std::atomic<std::uint64_t> id(0);
+    return ++id;
+}
+
+}   // namespace detail
+
+// least recently used cache of decompressed strings, keyed by block id
+template<typename Char, typename Traits, typename Alloc>
+class basic_compressed_immutable_string<Char, Traits, Alloc>::cache
+{
+  public:
+    static cache &instance(void)
+    {
+        static cache the_cache;
+        return the_cache;
+    }
+
+    std::shared_ptr<string_type const> find(std::uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(id);
+        if (it == index_.end())
+            return std::shared_ptr<string_type const>();
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    void insert(std::uint64_t id, std::shared_ptr<string_type const> const &str)
+    {
+        std::size_t const bytes = str->size() * sizeof(Char);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (bytes > capacity_  ||  index_.find(id) != index_.end())
+            return;
+        entries_.push_front(std::make_pair(id, str));
+        index_[id] = entries_.begin();
+        size_ += bytes;
+        evict();
+    }
+
+    void capacity(std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = bytes;
+        evict();
+    }
+
+    std::size_t const capacity(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+  private:
+    typedef std::list<std::pair<std::uint64_t, std::shared_ptr<string_type const>>> entries_type;
+
+    cache() : capacity_(16 * 1024 * 1024), size_(0) { }
+
+    void evict(void)
+    {
+        while (size_ > capacity_)
+        {
+            size_ -= entries_.back().second->size() * sizeof(Char);
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    std::mutex                                                          mutex_;
+    std::size_t                                                         capacity_;
+    std::size_t                                                         size_;
+    entries_type                                                        entries_;
+    std::unordered_map<std::uint64_t, typename entries_type::iterator> index_;
+};
+
+template<typename Char, typename Traits, typename Alloc>
+basic_compressed_immutable_string<Char, Traits, Alloc>::basic_compressed_immutable_string(string_type const &str)
+{
+    auto block = std::make_shared<detail::compressed_block>();
+    block->id     = detail::next_compressed_block_id();
+    block->length = str.size();
+
+    unsigned char const *const src   = reinterpret_cast<unsigned char const *>(str.c_str());
+    std::size_t          const bytes = str.size() * sizeof(Char);
+    detail::lz_compress(src, bytes, block->bytes);
+    block->raw = (block->bytes.size() >= bytes);
+    if (block->raw)
+        block->bytes.assign(src, src + bytes);
+    block->bytes.shrink_to_fit();
+    block_ = block;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::shared_ptr<typename basic_compressed_immutable_string<Char, Traits, Alloc>::string_type const>
+basic_compressed_immutable_string<Char, Traits, Alloc>::decompress(void) const
+{
+    cache &c = cache::instance();
+    auto str = c.find(block_->id);
+    if (str)
+        return str;
+
+    std::basic_string<Char, Traits, Alloc> buffer(block_->length, Char());
+    if (block_->raw)
+    {
+        if (!block_->bytes.empty())
+            std::memcpy(&buffer[0], block_->bytes.data(), block_->bytes.size());
+    }
+    else if (!detail::lz_decompress(block_->bytes.data(), block_->bytes.size(), reinterpret_cast<unsigned char *>(&buffer[0]), block_->length * sizeof(Char)))
+        throw std::runtime_error("corrupt compressed string");
+
+    str = std::make_shared<string_type const>(std::move(buffer));
+    c.insert(block_->id, str);
+    return str;
+}
+
+// copies share the compressed block; the decompression cache is not counted
+template<typename Char, typename Traits, typename Alloc>
+string_footprint const basic_compressed_immutable_string<Char, Traits, Alloc>::footprint(void) const noexcept
+{
+    std::size_t const count = static_cast<std::size_t>(block_.use_count());
+    string_footprint const result = { block_.get(), sizeof(detail::compressed_block) + block_->bytes.capacity(), count > 1, count };
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+int const basic_compressed_immutable_string<Char, Traits, Alloc>::compare(basic_compressed_immutable_string const &str) const
+{
+    if (block_ == str.block_)
+        return 0;
+    return decompress()->compare(*str.decompress());
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_compressed_immutable_string<Char, Traits, Alloc>::set_cache_capacity(std::size_t bytes)
+{
+    cache::instance().capacity(bytes);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t basic_compressed_immutable_string<Char, Traits, Alloc>::cache_capacity(void)
+{
+    return cache::instance().capacity();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_compressed_immutable_string<Char, Traits, Alloc> const &lhs, basic_compressed_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.size() == rhs.size()  &&  lhs.compare(rhs) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator!=(basic_compressed_immutable_string<Char, Traits, Alloc> const &lhs, basic_compressed_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator<(basic_compressed_immutable_string<Char, Traits, Alloc> const &lhs, basic_compressed_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_compressed_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.size() == rhs.size()  &&  lhs.compare(rhs) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_compressed_immutable_string<Char, Traits, Alloc> const &lhs, Char const *rhs)
+{
+    return lhs.compare(rhs) == 0;
+}
+
+}   // namespace cdmh
@@ -19,10 +19,35 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#ifdef IMMUTABLE_STRING_STATISTICS
+#include "immutable_string_statistics.h"   // must compile ahead of immutable_string.h
+#endif
 #include "immutable_string.h"
+#include "atomic_immutable_string.h"
+#include "immutable_string_allocator.h"
+#include "compressed_immutable_string.h"
+#include "immutable_string_column.h"
+#include "immutable_string_deduplicator.h"
+#include "immutable_string_distance.h"
+#include "immutable_string_format.h"
+#include "immutable_string_parallel.h"
+#include "immutable_string_regex.h"
+#include "immutable_string_segment.h"
+#include "immutable_string_set.h"
+#include "immutable_string_sort.h"
+#include "immutable_string_switch.h"
+#include "segmented_immutable_string.h"
+#include "immutable_string_snapshot.h"
 #include <cassert>
 #include <iostream>
 #include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 //#define TEST_COMPILER_ERRORS
 
 int main(int, char *[])
@@ -142,6 +167,1076 @@ int main(int, char *[])
     assert(pangram1.replace(pangram1.cbegin()+4, pangram1.cbegin()+9, {'s','l','o','w'}) == "the slow brown fox jumps over the lazy dog");
 #endif
 
+    assert(pangram1.replace_all(immutable_string("the"), immutable_string("a")) == "a quick brown fox jumps over a lazy dog");
+    assert(pangram1.replace_all(std::string("o"), std::string("0")) == "the quick br0wn f0x jumps 0ver the lazy d0g");
+    assert(pangram1.replace_all("the ", "") == "quick brown fox jumps over lazy dog");
+    assert(pangram1.replace_all("the lazy cat", 8, "a sleepy", 8) == "the quick brown fox jumps over a sleepy dog");
+    assert(pangram1.replace_all(' ', '_') == "the_quick_brown_fox_jumps_over_the_lazy_dog");
+    assert(pangram1.replace_all("cat", "dog") == pangram1);
+    assert(pangram1.replace_all("", "dog") == pangram1);
+    assert(immutable_string("aaaa").replace_all("aa", "b") == "bb");
+    {
+        std::vector<std::pair<std::string, std::string>> escapes;
+        escapes.push_back(std::make_pair("&", "&amp;"));
+        escapes.push_back(std::make_pair("<", "&lt;"));
+        escapes.push_back(std::make_pair(">", "&gt;"));
+        assert(immutable_string("<a href=\"x&y\">").replace_all(escapes) == "&lt;a href=\"x&amp;y\"&gt;");
+    }
+#if HAS_INITIALIZER_LIST
+    assert(pangram1.replace_all({ {"quick", "slow"}, {"the", "a"}, {"the quick", "one speedy"} }) == "one speedy brown fox jumps over a lazy dog");
+#endif
+
+    assert(pangram3.to_lower() == "bored? craving a pub quiz fix? why, just come to the royal oak!");
+    assert(pangram3.to_upper() == "BORED? CRAVING A PUB QUIZ FIX? WHY, JUST COME TO THE ROYAL OAK!");
+    assert(pangram1.to_lower() == pangram1);
+    assert(immutable_string("\xC3\x89t\xC3\xA9 @[`{").to_upper() == "\xC3\x89T\xC3\xA9 @[`{");
+    assert(cdmh::immutable_wstring(L"MiXeD").to_lower() == L"mixed");
+    assert(immutable_string(" \t trimmed \r\n").trim() == "trimmed");
+    assert(immutable_string(" \t trimmed \r\n").ltrim() == "trimmed \r\n");
+    assert(immutable_string(" \t trimmed \r\n").rtrim() == " \t trimmed");
+    assert(immutable_string("   ").trim().empty());
+    assert(pangram1.trim() == pangram1);
+
+    {
+        using cdmh::ci_immutable_string;
+        assert(ci_immutable_string("Hello, World!") == "hELLO, wORLD!");
+        assert(ci_immutable_string("The Quick Brown Fox Jumps Over The Lazy Dog") == pangram1.c_str());
+        assert(ci_immutable_string("The Quick Brown Fox Jumps Over The Lazy Cat") < pangram1.c_str());
+        assert(ci_immutable_string("apple") < ci_immutable_string("BANANA"));
+        assert(ci_immutable_string("0123456789abcdef0123456789ABCDEF!") == "0123456789ABCDEF0123456789abcdef!");
+        assert(ci_immutable_string("0123456789abcdef0123456789aBCDEF!") < "0123456789ABCDEF0123456789BBCDEF!");
+        assert(ci_immutable_string("Hello, World!").find("WORLD") == 7);
+        assert(ci_immutable_string("Hello, World!").find(", w") == 5  &&  ci_immutable_string("Hello\0, World!") == "HELLO");
+        assert(std::hash<ci_immutable_string>()("Hello, World!") == std::hash<ci_immutable_string>()("HELLO, world!"));
+
+        std::unordered_set<ci_immutable_string> keywords;
+        keywords.insert("SELECT");
+        keywords.insert("From");
+        assert(keywords.count("select") == 1);
+        assert(keywords.count("FROM") == 1);
+        assert(keywords.count("where") == 0);
+    }
+
+    // Unicode properties and transcoding
+    assert(pangram1.is_valid_utf()  &&  pangram1.is_ascii()  &&  pangram1.code_points() == pangram1.size());
+    {
+        immutable_string const utf8("na\xC3\xAFve caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 the quick brown fox");
+        assert(utf8.is_valid_utf()  &&  !utf8.is_ascii());
+        assert(utf8.code_points() == 34);
+        assert(immutable_string(utf8).code_points() == 34);
+
+        cdmh::immutable_u16string const utf16 = cdmh::to_utf16(utf8);
+        cdmh::immutable_u32string const utf32 = cdmh::to_utf32(utf8);
+        assert(utf16.size() == 35  &&  utf16.code_points() == 34);
+        assert(utf32.size() == 34  &&  utf32[2] == 0xef  &&  utf32[13] == 0x1f600);
+        assert(utf16[13] == 0xd83d  &&  utf16[14] == 0xde00);
+        assert(cdmh::to_utf8(utf16) == utf8);
+        assert(cdmh::to_utf8(utf32) == utf8);
+        assert(cdmh::to_utf16(utf32) == utf16);
+        assert(cdmh::to_utf32(utf16) == utf32);
+        assert(cdmh::to_utf16(pangram1).size() == pangram1.size());
+
+        char const *const invalid[] = { "\x80", "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF0\x9F\x98", "abc\xFF" };
+        for (std::size_t i=0; i<sizeof(invalid)/sizeof(invalid[0]); ++i)
+        {
+            immutable_string const bad(invalid[i]);
+            assert(!bad.is_valid_utf()  &&  !bad.is_ascii()  &&  bad.code_points() == immutable_string::npos);
+            bool thrown = false;
+            try { cdmh::to_utf16(bad); } catch (std::range_error const &) { thrown = true; }
+            assert(thrown);
+        }
+        assert(!cdmh::immutable_u16string(1, char16_t(0xdc00)).is_valid_utf());
+        assert(!cdmh::immutable_u32string(1, char32_t(0x110000)).is_valid_utf());
+    }
+
+    // compressed storage
+    {
+        std::string text;
+        for (int i=0; i<1000; ++i)
+            text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 17) + "\n";
+        immutable_string const large(text);
+        cdmh::compressed_immutable_string const compressed(large);
+        assert(compressed.size() == large.size()  &&  compressed.uncompressed_size() == large.size());
+        assert(compressed.compressed_size() < compressed.uncompressed_size() / 4);
+        assert(compressed == large  &&  compressed.str() == large);
+        assert(compressed.decompress() == compressed.decompress());
+        assert(compressed.find("dog 16") == large.find("dog 16"));
+        assert(compressed.rfind('\n') == large.size() - 1);
+        assert(cdmh::compressed_immutable_string(compressed) == compressed);
+
+        cdmh::compressed_immutable_string const tiny(pangram1);
+        assert(tiny == pangram1  &&  tiny.compressed_size() == pangram1.size());
+        assert(tiny < compressed  &&  tiny != compressed);
+        assert(cdmh::compressed_immutable_string(immutable_string()).empty());
+        assert(cdmh::compressed_immutable_wstring(cdmh::immutable_wstring(L"wide wide wide wide wide")) == L"wide wide wide wide wide");
+
+        std::size_t const capacity = cdmh::compressed_immutable_string::cache_capacity();
+        cdmh::compressed_immutable_string::set_cache_capacity(0);
+        assert(compressed.decompress() != compressed.decompress()  &&  compressed == large);
+        cdmh::compressed_immutable_string::set_cache_capacity(capacity);
+    }
+
+    // modifiers of temporaries
+    {
+        auto const temp = [&pangram1]{ return immutable_string(pangram1); };
+        std::string const str("abc");
+        immutable_string const imm("abc");
+        char const abc[] = { 'a', 'b', 'c' };
+        assert(temp().append(imm) == pangram1.append(imm)  &&  temp().append(str) == pangram1.append(str));
+        assert(temp().append(imm, 1, 1) == pangram1.append(imm, 1, 1)  &&  temp().append(str, 1, 1) == pangram1.append(str, 1, 1));
+        assert(temp().append("abc") == pangram1.append("abc")  &&  temp().append("abc", 2) == pangram1.append("abc", 2));
+        assert(temp().append(3, 'x') == pangram1.append(3, 'x')  &&  temp().append('x') == pangram1.append('x'));
+        assert(temp().append(abc, abc + 3) == pangram1.append(abc, abc + 3));
+        assert(temp().insert(4, imm) == pangram1.insert(4, imm)  &&  temp().insert(4, str) == pangram1.insert(4, str));
+        assert(temp().insert(4, imm, 1, 1) == pangram1.insert(4, imm, 1, 1)  &&  temp().insert(4, str, 1, 1) == pangram1.insert(4, str, 1, 1));
+        assert(temp().insert(4, "abc") == pangram1.insert(4, "abc")  &&  temp().insert(4, "abc", 2) == pangram1.insert(4, "abc", 2));
+        assert(temp().insert(4, 3, 'x') == pangram1.insert(4, 3, 'x'));
+        {
+            immutable_string t1 = temp(), t2 = temp(), t3 = temp();
+            assert(std::move(t1).insert(t1.cbegin() + 4, 3, 'x') == pangram1.insert(4, 3, 'x'));
+            assert(std::move(t2).insert(t2.cbegin() + 4, 'x') == pangram1.insert(4, 1, 'x'));
+            assert(std::move(t3).insert(t3.cbegin() + 4, abc, abc + 3) == pangram1.insert(4, "abc"));
+        }
+        assert(temp().erase(4, 6) == pangram1.erase(4, 6));
+        {
+            immutable_string t1 = temp(), t2 = temp();
+            assert(std::move(t1).erase(t1.cbegin() + 4) == pangram1.erase(4, 1));
+            assert(std::move(t2).erase(t2.cbegin() + 4, t2.cbegin() + 10) == pangram1.erase(4, 6));
+        }
+        assert(temp().replace(4, 5, imm) == pangram1.replace(4, 5, imm)  &&  temp().replace(4, 5, str) == pangram1.replace(4, 5, str));
+        assert(temp().replace(4, 5, imm, 1, 1) == pangram1.replace(4, 5, imm, 1, 1)  &&  temp().replace(4, 5, str, 1, 1) == pangram1.replace(4, 5, str, 1, 1));
+        assert(temp().replace(4, 5, "abc") == pangram1.replace(4, 5, "abc")  &&  temp().replace(4, 5, "abc", 2) == pangram1.replace(4, 5, "abc", 2));
+        assert(temp().replace(4, 5, 3, 'x') == pangram1.replace(4, 5, 3, 'x'));
+        {
+            immutable_string t[7] = { temp(), temp(), temp(), temp(), temp(), temp(), temp() };
+            assert(std::move(t[0]).replace(t[0].cbegin() + 4, t[0].cbegin() + 9, imm) == pangram1.replace(4, 5, imm));
+            assert(std::move(t[1]).replace(t[1].cbegin() + 4, t[1].cbegin() + 9, str) == pangram1.replace(4, 5, str));
+            assert(std::move(t[2]).replace(t[2].cbegin() + 4, t[2].cbegin() + 9, "abc") == pangram1.replace(4, 5, "abc"));
+            assert(std::move(t[3]).replace(t[3].cbegin() + 4, t[3].cbegin() + 9, "abc", 2) == pangram1.replace(4, 5, "abc", 2));
+            assert(std::move(t[4]).replace(t[4].cbegin() + 4, t[4].cbegin() + 9, 3, 'x') == pangram1.replace(4, 5, 3, 'x'));
+            assert(std::move(t[5]).replace(t[5].cbegin() + 4, t[5].cbegin() + 9, abc, abc + 3) == pangram1.replace(4, 5, "abc"));
+#if HAS_INITIALIZER_LIST
+            assert(std::move(t[6]).replace(t[6].cbegin() + 4, t[6].cbegin() + 9, { 'a', 'b', 'c' }) == pangram1.replace(4, 5, "abc"));
+            assert(temp().append({ 'a', 'b', 'c' }) == pangram1.append("abc"));
+            immutable_string t7 = temp();
+            assert(std::move(t7).insert(t7.cbegin() + 4, { 'a', 'b', 'c' }) == pangram1.insert(4, "abc"));
+#endif
+        }
+
+        // the object itself as the argument
+        immutable_string self("abc");
+        assert(std::move(self).append(self) == "abcabc");
+        assert(self == "abc"  &&  self.code_points() == 3);
+
+        // characters of the object itself as the argument
+        assert(std::move(self).append(self.c_str()) == "abcabc");
+        assert(std::move(self).append(self.data() + 1, 2) == "abcbc");
+        assert(std::move(self).append(self.cbegin(), self.cend()) == "abcabc");
+        assert(std::move(self).append(self.crbegin(), self.crend()) == "abccba");
+        assert(std::move(self).insert(0, self.c_str()) == "abcabc");
+        assert(std::move(self).insert(1, self.data(), 2) == "aabbc");
+        assert(std::move(self).insert(self.cend(), self.cbegin(), self.cend()) == "abcabc");
+        assert(std::move(self).replace(0, 1, self.c_str()) == "abcbc");
+        assert(std::move(self).replace(self.cbegin(), self.cbegin() + 1, self.data() + 1, 2) == "bcbc");
+        assert(std::move(self).replace(self.cbegin(), self.cend(), self.crbegin(), self.crend()) == "cba");
+        assert(self == "abc");
+
+        // a chain reuses one buffer
+        immutable_string large(std::string(1000, 'x'));
+        char const *const buffer = large.data();
+        immutable_string const edited = std::move(large).erase(0, 10).replace(0, 5, "abcde").insert(0, 1, '-');
+        assert(edited.data() == buffer  &&  edited.size() == 991  &&  edited.substr(0, 6) == "-abcde");
+        std::string const moved = immutable_string(pangram1).mutable_string();
+        assert(moved == pangram1);
+
+        assert(immutable_string("abc") + immutable_string("def") + "ghi" + 'j' + std::string("kl") == "abcdefghijkl");
+        assert('a' + immutable_string("bc") == "abc"  &&  "ab" + immutable_string("c") == "abc");
+        assert(std::string("ab") + immutable_string("c") == "abc"  &&  str + immutable_string("def") == "abcdef");
+    }
+
+    // atomic cells
+    {
+        cdmh::atomic_immutable_string cell(immutable_string("v0"));
+        assert(*cell.load() == "v0"  &&  cdmh::atomic_immutable_string().load()->empty());
+
+        auto const v0 = cell.load();
+        cell.store(immutable_string("v1"));
+        assert(*v0 == "v0"  &&  *cell.load() == "v1");
+        assert(*cell.exchange(std::make_shared<immutable_string const>("v2")) == "v1");
+
+        auto expected = v0;
+        assert(!cell.compare_exchange(expected, std::make_shared<immutable_string const>("v3"))  &&  *expected == "v2");
+        assert(cell.compare_exchange(expected, std::make_shared<immutable_string const>("v3"))  &&  *cell.load() == "v3");
+
+        std::atomic<bool> done(false);
+        std::atomic<int>  errors(0);
+        std::vector<std::thread> readers;
+        for (int i=0; i<4; ++i)
+        {
+            readers.push_back(std::thread([&cell, &done, &errors]{
+                while (!done.load())
+                {
+                    auto const value = cell.load();
+                    if (value->size() < 2  ||  (*value)[0] != 'v')
+                        ++errors;
+                }
+            }));
+        }
+        for (int i=0; i<2000; ++i)
+        {
+            if (i % 2)
+                cell.store(immutable_string("v").append(std::to_string(i)));
+            else
+            {
+                auto current = cell.load();
+                while (!cell.compare_exchange(current, std::make_shared<immutable_string const>(immutable_string("v").append(std::to_string(i)))))
+                    ;
+            }
+        }
+        done = true;
+        for (auto &reader : readers)
+            reader.join();
+        assert(errors == 0  &&  *cell.load() == "v1999");
+
+        // a failed exchange leaves expected holding a newer value, so a
+        // retry never repeats one that is known to be stale
+        cdmh::atomic_immutable_string counter(immutable_string("0"));
+        std::vector<std::thread> writers;
+        for (int i=0; i<4; ++i)
+        {
+            writers.push_back(std::thread([&counter, &errors]{
+                for (int j=0; j<50000; ++j)
+                {
+                    auto current = counter.load();
+                    for (;;)
+                    {
+                        auto const tried = current;
+                        if (counter.compare_exchange(current, std::make_shared<immutable_string const>(std::to_string(std::stoi(current->c_str()) + 1))))
+                            break;
+                        if (current == tried)
+                            ++errors;
+                    }
+                }
+            }));
+        }
+        for (auto &writer : writers)
+            writer.join();
+        assert(errors == 0  &&  *counter.load() == "200000");
+    }
+
+    // deduplication of cells
+    {
+        std::string const payload(100, 'p');
+        std::vector<std::shared_ptr<cdmh::atomic_immutable_string>> cells;
+        for (int i=0; i<3; ++i)
+            cells.push_back(std::make_shared<cdmh::atomic_immutable_string>(immutable_string(payload)));
+        auto const small = std::make_shared<cdmh::atomic_immutable_string>(immutable_string("abc"));
+        auto const before = small->load();
+
+        cdmh::string_deduplicator deduplicator;
+        for (auto const &cell : cells)
+            deduplicator.track(cell);
+        deduplicator.track(small);
+        deduplicator.flush();
+        assert(cells[0]->load() == cells[1]->load()  &&  cells[1]->load() == cells[2]->load()  &&  *cells[0]->load() == payload);
+        assert(small->load() == before);
+        assert(deduplicator.stats().inspected == 3  &&  deduplicator.stats().deduplicated == 2  &&  deduplicator.stats().bytes_saved > 200);
+
+        cells[1]->store(immutable_string(payload));
+        deduplicator.rescan();
+        deduplicator.flush();
+        assert(cells[1]->load() == cells[0]->load()  &&  deduplicator.stats().deduplicated == 3);
+        auto const interned = std::make_shared<immutable_string const>(payload);
+        assert(deduplicator.canonical(interned) == cells[0]->load());
+    }
+
+    // shared memory segments
+    {
+        char const *const name = "/cdmh_immutable_string_test";
+        cdmh::shared_string_segment writer = cdmh::shared_string_segment::create(name, 4096);
+        cdmh::shared_string_ref const hello = writer.allocate(immutable_string("hello"));
+        std::vector<immutable_string> const words = { "red", "", "green" };
+        cdmh::shared_string_table_ref const table = writer.allocate_table(words.begin(), words.end());
+        writer.set_root(0, table.offset);
+        assert(writer.writable()  &&  writer.view(hello) == "hello"  &&  writer.view(hello).data()[5] == 0);
+
+        cdmh::shared_string_segment const reader = cdmh::shared_string_segment::open(name);
+        assert(!reader.writable()  &&  reader.capacity() == 4096  &&  reader.used() == writer.used());
+        assert(reader.view(hello).str() == "hello");
+        cdmh::shared_string_table_ref const root = { reader.root(0) };
+        cdmh::shared_string_table const strings = reader.table<char>(root);
+        assert(strings.size() == 3  &&  strings[0] == "red"  &&  strings[1].empty()  &&  strings.at(2) == "green");
+
+        bool thrown = false;
+        try { writer.allocate(std::string(8192, 'x').c_str(), 8192); } catch (std::bad_alloc &) { thrown = true; }
+        assert(thrown);
+        thrown = false;
+        cdmh::shared_string_ref const invalid = { 1 << 20 };
+        try { reader.view(invalid); } catch (std::runtime_error &) { thrown = true; }
+        assert(thrown);
+        cdmh::shared_string_segment::remove(name);
+    }
+
+    // memory accounting
+    {
+        immutable_string const small("abc");
+        immutable_string const large(std::string(1000, 'x'));
+        assert(small.footprint().heap_bytes == 0  &&  small.footprint().buffer == nullptr);
+        assert(large.footprint().heap_bytes > 1000  &&  large.footprint().buffer == large.data());
+        assert(!large.footprint().shared  &&  large.footprint().share_count == 1);
+
+        std::vector<immutable_string> strings(3, large);
+        strings.push_back(small);
+        cdmh::memory_usage const usage = cdmh::measure_memory(strings.begin(), strings.end());
+        assert(usage.strings == 4  &&  usage.buffers == 3  &&  usage.shared_bytes == 0  &&  usage.saved_bytes == 0);
+        assert(usage.unique_bytes == 3 * large.footprint().heap_bytes);
+        assert(usage.total_bytes == usage.unique_bytes + 4 * sizeof(immutable_string));
+
+        cdmh::compressed_immutable_string const compressed(large);
+        std::vector<cdmh::compressed_immutable_string> copies(4, compressed);
+        assert(compressed.footprint().shared  &&  compressed.footprint().share_count == 5);
+        cdmh::memory_usage const shared = cdmh::measure_memory(copies.begin(), copies.end());
+        assert(shared.buffers == 1  &&  shared.unique_bytes == 0);
+        assert(shared.shared_bytes == compressed.footprint().heap_bytes  &&  shared.saved_bytes == 3 * shared.shared_bytes);
+    }
+
+    // literal hashes and string switches
+    {
+#if HAS_CONSTEXPR
+        using namespace cdmh::literals;
+        static_assert(cdmh::hash_literal("get") == "get"_hash, "literal hashes differ");
+        static_assert(cdmh::hash_literal("a\0b") == cdmh::hash_literal("a")  &&  "a\0b"_hash == "a"_hash, "literals end at a terminator");
+        assert(immutable_string("a\0b").hash() == cdmh::hash_literal("a\0b")  &&  cdmh::immutable_wstring(L"a\0b").hash() == L"a\0b"_hash);
+        immutable_string const command("set");
+        assert(command.hash() == cdmh::hash_literal("set")  &&  command.hash() == std::hash<immutable_string>()(command));
+        assert(cdmh::immutable_wstring(L"set").hash() == L"set"_hash  &&  immutable_string("").hash() == ""_hash);
+        switch (command.hash())
+        {
+            case "get"_hash:                  assert(false);                break;
+            case cdmh::hash_literal("set"):   assert(command == "set");     break;
+            default:                          assert(false);                break;
+        }
+#endif
+
+        static cdmh::string_switch const commands = { "get", "set", "delete", "" };
+        assert(commands.size() == 4  &&  commands.key(2) == "delete");
+        assert(commands.index(immutable_string("get")) == 0  &&  commands.index(immutable_string("delete")) == 2);
+        assert(commands.index("set") == 1  &&  commands.index("") == 3  &&  commands.index("sets") == cdmh::string_switch::npos);
+
+        std::vector<std::string> names;
+        for (int i=0; i<50000; ++i)
+            names.push_back("field" + std::to_string(i));
+        cdmh::string_switch const fields(names.begin(), names.end());
+        for (int i=0; i<50000; ++i)
+            assert(fields.index(immutable_string(names[i])) == static_cast<std::size_t>(i));
+        assert(fields.index("field50000") == cdmh::string_switch::npos);
+        assert(cdmh::string_switch(names.begin(), names.begin()).index("field0") == cdmh::string_switch::npos);
+
+        bool thrown = false;
+        try { cdmh::string_switch duplicates = { "a", "a" }; } catch (std::invalid_argument &) { thrown = true; }
+        assert(thrown);
+    }
+
+    // string literals are measured at compile time, other arrays and pointers with strlen
+    {
+        immutable_string const hello("Hello");
+        assert(hello == "Hello"  &&  "Hello" == hello  &&  hello != "Hell"  &&  hello < "Help"  &&  "Hell" < hello);
+        assert(hello.compare("Hello") == 0  &&  hello.compare(1, 2, "el") == 0  &&  hello.find("lo") == 3  &&  hello.rfind("l") == 3);
+        assert(hello.find_first_of("lo") == 2  &&  hello.find_last_not_of("o") == 3  &&  hello.find("x") == immutable_string::npos);
+        assert(hello.append(", World!") == "Hello, World!"  &&  hello.insert(0, ">") == ">Hello"  &&  hello.replace(0, 1, "J") == "Jello");
+        assert(hello + "!" == "Hello!"  &&  "Oh, " + hello == "Oh, Hello"  &&  immutable_string("Hello") + "!" == "Hello!");
+
+        char buffer[16] = "Hello";
+        buffer[7] = 'x';
+        char const padded[8] = "Hell";
+        char const *pointer = buffer;
+        assert(hello == buffer  &&  buffer == hello  &&  immutable_string(buffer).length() == 5  &&  hello.find(buffer) == 0);
+        assert(immutable_string(padded).length() == 4  &&  hello.compare(padded) > 0  &&  hello.find(padded) == 0);
+        assert(hello == pointer  &&  immutable_string(pointer) == hello  &&  hello.append(pointer) == "HelloHello");
+
+        immutable_string const nul(std::string("a\0b", 3));
+        assert(nul != "a\0b"  &&  nul.compare(0, 1, "a\0b") == 0  &&  immutable_string("a\0b").length() == 1  &&  immutable_string("a\0b") == "a");
+    }
+
+    // numeric conversion
+    {
+        assert(immutable_string::from(0) == "0"  &&  immutable_string::from(-42) == "-42"  &&  immutable_string::from(1234567u) == "1234567");
+        assert(immutable_string::from(std::numeric_limits<long long>::min()) == std::to_string(std::numeric_limits<long long>::min()));
+        assert(immutable_string::from(std::numeric_limits<unsigned long long>::max()) == std::to_string(std::numeric_limits<unsigned long long>::max()));
+        assert(cdmh::immutable_wstring::from(-7) == L"-7"  &&  immutable_string::from(static_cast<signed char>(-128)) == "-128");
+        assert(immutable_string::from(0.1) == "0.1"  &&  immutable_string::from(-2.5f) == "-2.5"  &&  immutable_string::from(1e300) == "1e+300");
+        assert(immutable_string::from(1.0 / 3).to_double() == 1.0 / 3  &&  immutable_string::from(0.1f).to_float() == 0.1f);
+        assert(immutable_string::from(std::numeric_limits<double>::infinity()) == "inf");
+        assert(immutable_string::from(123.456) == "123.456"  &&  immutable_string::from(-0.0) == "-0"  &&  immutable_string::from(0.0001) == "0.0001");
+        assert(immutable_string::from(0.00001) == "1e-05"  &&  immutable_string::from(1e15) == "1e+15"  &&  immutable_string::from(999999999999999.0) == "999999999999999");
+        assert(immutable_string::from(0.1 + 0.2) == "0.30000000000000004"  &&  immutable_string::from(1e-4f) == "0.0001"  &&  immutable_string::from(16777216.0f) == "16777216");
+
+        std::size_t idx = 0;
+        assert(immutable_string("  -123abc").to_int(&idx) == -123  &&  idx == 6);
+        assert(immutable_string("0x1F").to_int(nullptr, 16) == 31  &&  immutable_string("0x1F").to_long(nullptr, 0) == 31  &&  immutable_string("017").to_int(nullptr, 0) == 15);
+        assert(immutable_string("0xg").to_int(&idx, 16) == 0  &&  idx == 1);
+        assert(immutable_string("-9223372036854775808").to_long_long() == std::numeric_limits<long long>::min());
+        assert(immutable_string("-1").to_unsigned_long_long() == std::numeric_limits<unsigned long long>::max());
+        assert(cdmh::immutable_wstring(L"+25 ").to_unsigned_long(&idx) == 25  &&  idx == 3);
+        assert(immutable_string(" 2.5e3x").to_double(&idx) == 2500.0  &&  idx == 6  &&  immutable_string("-0x1p4").to_long_double() == -16.0L);
+        assert(immutable_string("1e+").to_double(&idx) == 1.0  &&  idx == 1  &&  immutable_string("-.5.5").to_double(&idx) == -0.5  &&  idx == 3);
+        assert(immutable_string("000.1000").to_double() == 0.1  &&  immutable_string("0e999").to_double() == 0.0  &&  std::signbit(immutable_string("-0").to_double()));
+        assert(immutable_string("12345678901234567890123").to_double() == 12345678901234567890123.0  &&  immutable_string("0.3").to_float() == 0.3f);
+
+        bool invalid = false, range = false;
+        try { immutable_string("x1").to_int(); } catch (std::invalid_argument &) { invalid = true; }
+        try { immutable_string("2147483648").to_int(); } catch (std::out_of_range &) { range = true; }
+        assert(invalid  &&  range);
+        invalid = range = false;
+        try { immutable_string(".").to_double(); } catch (std::invalid_argument &) { invalid = true; }
+        try { immutable_string("1e999").to_double(); } catch (std::out_of_range &) { range = true; }
+        assert(invalid  &&  range);
+    }
+
+#if HAS_VARIADIC_TEMPLATES
+    // formatting
+    {
+        immutable_string const path("/var/log/messages");
+        std::string const unit("bytes");
+        char buffer[16] = "x";
+        char const *pointer = "ptr";
+        assert(cdmh::format("{} of {} {} from {}", 10, 20u, unit, path) == "10 of 20 bytes from /var/log/messages");
+        assert(cdmh::format("{1}{0}{1} {{}} {}", 'a', "b") == "bab {} a"  &&  cdmh::format("") == ""  &&  cdmh::format("plain") == "plain");
+        assert(cdmh::format("{}|{}|{}|{}|{}", true, false, -1.5, buffer, pointer) == "true|false|-1.5|x|ptr");
+        assert(cdmh::format(L"{}={}", cdmh::immutable_wstring(L"w"), 7) == L"w=7");
+
+        // a buffer that isn't const is a C string, whatever follows its terminator
+        char reused[8] = "abcdefg";
+        std::strcpy(reused, "ab");
+        assert(cdmh::format("[{}]", reused) == "[ab]"  &&  cdmh::string_format("[{}]")(reused) == "[ab]");
+        assert(cdmh::format(path, 1) == path  &&  cdmh::format("{}", cdmh::immutable_string_view(path.data() + 5, 3)) == "log");
+
+        bool invalid = false, range = false;
+        try { cdmh::format("{", 1); } catch (std::invalid_argument &) { invalid = true; }
+        try { cdmh::format("{1}", 1); } catch (std::out_of_range &) { range = true; }
+        assert(invalid  &&  range);
+        invalid = false;
+        try { cdmh::format("a}b"); } catch (std::invalid_argument &) { invalid = true; }
+        assert(invalid);
+
+        static cdmh::string_format const line("{}: {}\n");
+        assert(line.arguments() == 2  &&  line.str() == "{}: {}\n");
+        assert(line("name", 42) == "name: 42\n"  &&  line(path, 0.25) == "/var/log/messages: 0.25\n");
+        range = false;
+        try { line("name"); } catch (std::out_of_range &) { range = true; }
+        assert(range);
+        assert(cdmh::wstring_format(L"{{{0}}}")(L'x') == L"{x}");
+    }
+#endif
+
+    // segmented storage
+    {
+        std::string text;
+        for (int i=0; i<200; ++i)
+            text += "ab" + std::to_string(i % 13) + (i % 7 ? "ba" : "a\n");
+        std::istringstream in(text);
+        cdmh::segmented_immutable_string const segmented = cdmh::segmented_immutable_string::read(in, 7);
+        assert(segmented.size() == text.size()  &&  segmented.segment_count() == (text.size() + 6) / 7  &&  segmented.segment(0).size() == 7);
+        assert(segmented == immutable_string(text)  &&  segmented.str() == text  &&  segmented.c_str() == text  &&  segmented.c_str() == segmented.data());
+        assert(std::equal(segmented.begin(), segmented.end(), text.begin())  &&  segmented.end() - segmented.begin() == static_cast<std::ptrdiff_t>(text.size()));
+        assert(segmented[9] == text[9]  &&  segmented.at(text.size() - 1) == text.back());
+
+        char const *const needles[] = { "a", "ab", "ba1", "12ba", "ab0aab", "\nab1", "a\nab12ba", "x", "" };
+        for (auto needle : needles)
+        {
+            for (std::size_t pos=0; pos<=text.size() + 1; pos+=5)
+            {
+                assert(segmented.find(needle, pos) == text.find(needle, pos));
+                assert(segmented.rfind(needle, pos) == text.rfind(needle, pos));
+            }
+            assert(segmented.rfind(needle) == text.rfind(needle));
+        }
+        assert(segmented.find('\n', 10) == text.find('\n', 10)  &&  segmented.rfind('\n', 50) == text.rfind('\n', 50));
+
+        char const *const sets[] = { "\n", "0123456789", "ab", "ab\n", "ab0123456789", "ab\n0123456789", "x", "" };
+        for (auto set : sets)
+        {
+            for (std::size_t pos=0; pos<=text.size() + 1; pos+=3)
+            {
+                assert(segmented.find_first_of(set, pos) == text.find_first_of(set, pos)  &&  segmented.find_last_of(set, pos) == text.find_last_of(set, pos));
+                assert(segmented.find_first_not_of(set, pos) == text.find_first_not_of(set, pos)  &&  segmented.find_last_not_of(set, pos) == text.find_last_not_of(set, pos));
+            }
+            assert(segmented.find_last_of(set) == text.find_last_of(set)  &&  segmented.find_last_not_of(set) == text.find_last_not_of(set));
+        }
+        assert(segmented.find_first_of('\n', 10) == text.find_first_of('\n', 10)  &&  segmented.find_last_not_of('a') == text.find_last_not_of('a'));
+        assert(segmented.find_first_not_of(immutable_string("ab"), 7) == text.find_first_not_of("ab", 7));
+
+        cdmh::segmented_immutable_string::builder builder(5);
+        for (std::size_t pos=0; pos<text.size(); pos+=3)
+            builder.append(immutable_string(text.substr(pos, 3)));
+        assert(builder.size() == text.size());
+        cdmh::segmented_immutable_string const built = builder.finish();
+        assert(built == segmented  &&  built.compare(segmented) == 0  &&  builder.size() == 0  &&  built.segment(0).size() == 5);
+        assert(built.compare(text.c_str()) == 0  &&  segmented.compare(immutable_string(text + "a")) < 0  &&  !(built < segmented));
+        assert(cdmh::segmented_immutable_string(immutable_string("abcdef"), 4) < cdmh::segmented_immutable_string(immutable_string("abd"), 2));
+        assert(cdmh::segmented_immutable_string(immutable_string("")).empty()  &&  cdmh::segmented_immutable_string(immutable_string("")).c_str() == std::string());
+
+        cdmh::segmented_immutable_string moved(built);
+        cdmh::segmented_immutable_string const taken(std::move(moved));
+        assert(taken == segmented  &&  moved.empty()  &&  moved.size() == 0  &&  moved.begin() == moved.end());
+        assert(moved.compare(segmented) < 0  &&  moved.compare("") == 0  &&  moved.c_str() == std::string()  &&  moved.find('a') == moved.npos);
+    }
+
+    // columnar storage
+    {
+        std::vector<immutable_string> values;
+        for (int i=0; i<1000; ++i)
+            values.push_back(immutable_string((i % 3 == 0)? "" : (i % 5 == 0)? "GET" : "POST /" + std::to_string(i)));
+        cdmh::immutable_string_column const column(values.begin(), values.end());
+        assert(column.size() == values.size()  &&  column[1] == "POST /1"  &&  column[5].str() == "GET"  &&  column.at(0).empty());
+        assert(std::equal(column.begin(), column.end(), values.begin(), [](cdmh::immutable_string_view const &a, immutable_string const &b) { return a == b.c_str(); }));
+        assert(column.end() - column.begin() == 1000  &&  column.begin()[7] == "POST /7");
+
+        std::size_t gets = 0;
+        for (auto const &value : values)
+            gets += (value == "GET");
+        assert(column.count_equal("GET") == gets  &&  column.rows_equal("GET").size() == gets  &&  column.rows_equal("GET")[0] == 5);
+        assert(column.count_equal("") == 334  &&  column.count_equal("POST") == 0);
+
+        std::vector<std::size_t> const found = column.find("/1");
+        std::vector<std::size_t> const rows  = column.rows_containing("/1");
+        std::vector<std::size_t> expected;
+        for (std::size_t i=0; i<values.size(); ++i)
+        {
+            assert(found[i] == values[i].find("/1"));
+            if (values[i].find("/1") != immutable_string::npos)
+                expected.push_back(i);
+        }
+        assert(rows == expected  &&  column.rows_containing("T /").size() == column.size() - gets - 334);
+        assert(column.rows_containing("GETPOST").empty()  &&  column.rows_containing("").size() == column.size());
+
+        std::vector<std::size_t> const hashes = column.hashes();
+        assert(hashes[4] == values[4].hash()  &&  hashes[0] == values[0].hash());
+        assert(cdmh::immutable_string_column({ "a", "", "b" }).size() == 3  &&  cdmh::immutable_string_column().empty());
+        assert(column.heap_bytes() < values.size() * sizeof(immutable_string));
+    }
+
+    // pooled allocation
+    {
+        cdmh::pooled_immutable_string const hello("Hello, World! A string too long for the small buffer");
+        assert(hello.append(hello).size() == 2 * hello.size()  &&  hello.substr(0, 5) == "Hello"  &&  hello.find("World") == 7);
+
+        // a freed block is reused by the next allocation of its class on the same thread
+        void const *first;
+        {
+            cdmh::pooled_immutable_string const a(std::string(100, 'a').c_str());
+            first = a.data();
+        }
+        cdmh::pooled_immutable_string const b(std::string(100, 'b').c_str());
+        assert(b.data() == first);
+        assert(cdmh::pooled_immutable_string(std::string(5000, 'c').c_str()).size() == 5000);
+
+        // strings made on one thread and freed on others
+        std::vector<std::unique_ptr<cdmh::pooled_immutable_string>> strings;
+        std::thread maker([&strings]{
+            for (int i=0; i<4000; ++i)
+                strings.emplace_back(new cdmh::pooled_immutable_string(std::string(16 + i % 300, char('a' + i % 26)).c_str()));
+        });
+        maker.join();
+
+        std::vector<std::thread> freers;
+        for (int t=0; t<4; ++t)
+        {
+            freers.emplace_back([&strings, t]{
+                for (std::size_t i=t; i<strings.size(); i+=4)
+                {
+                    assert(strings[i]->size() == 16 + i % 300  &&  (*strings[i])[0] == char('a' + i % 26));
+                    strings[i].reset();
+                    cdmh::pooled_immutable_string const local(std::string(40, 'x').c_str());
+                    assert(local.size() == 40);
+                }
+            });
+        }
+        for (auto &freer : freers)
+            freer.join();
+
+        std::thread reuser([]{
+            std::vector<cdmh::pooled_immutable_wstring> wide;
+            for (int i=0; i<1000; ++i)
+                wide.push_back(cdmh::pooled_immutable_wstring(std::wstring(20 + i % 50, L'w').c_str()));
+            assert(wide[999].size() == 20 + 999 % 50);
+        });
+        reuser.join();
+        assert(cdmh::pooled_allocator<char>() == cdmh::pooled_allocator<int>());
+    }
+
+    // regular expressions
+    {
+        using cdmh::string_regex;
+        using cdmh::immutable_string_view;
+
+        string_regex const date("[0-9]{4}-[0-9]{2}-[0-9]{2}");
+        assert(date.matches("2013-10-19"));
+        assert(!date.matches("2013-10-19 "));
+        assert(!date.matches("13-10-19"));
+        assert(date.contains("on 2013-10-19."));
+
+        immutable_string const text("key=value; other=thing;");
+        auto const match = string_regex("\\w+").find(text, 4);
+        assert(match == "value");
+        assert(match.data() == text.data() + 4);
+        assert(string_regex("x").find(text).data() == nullptr);
+        assert(string_regex("\\w+").find(text, text.size()).data() == nullptr);
+
+        auto const pairs = string_regex("(\\w+)=(\\w+)").find_all(text);
+        assert(pairs.size() == 2  &&  pairs[0] == "key=value"  &&  pairs[1] == "other=thing");
+        auto const empties = string_regex("a*").find_all(immutable_string_view("baa"));
+        assert(empties.size() == 3  &&  empties[0].empty()  &&  empties[1] == "aa"  &&  empties[2].empty());
+
+        // leftmost, then the preference of a backtracking matcher
+        assert(string_regex("<.+>").find("<a><b>") == "<a><b>");
+        assert(string_regex("<.+?>").find("<a><b>") == "<a>");
+        assert(string_regex("a|ab").find("xab") == "a");
+        assert(string_regex("ab|a").find("xab") == "ab");
+        assert(string_regex("a{2,3}").find("aaaa") == "aaa");
+        assert(string_regex("a{2,3}?").find("aaaa") == "aa");
+        assert(string_regex("(?:ab){2,}").find("abababx") == "ababab");
+        assert(string_regex("a{3}").matches("aaa")  &&  !string_regex("a{3}").matches("aa"));
+        assert(string_regex("colou?r").matches("color")  &&  string_regex("colou?r").matches("colour"));
+
+        // anchors, classes and escapes
+        assert(string_regex("^ab").find("abab") == "ab");
+        assert(string_regex("^ab").find_all(immutable_string_view("abab")).size() == 1);
+        assert(string_regex("ab$").find("abab").data() == immutable_string_view("abab").data() + 2);
+        assert(string_regex("[^a-c]+").find("abcdefa") == "def");
+        assert(string_regex("[-a]+").matches("a-a")  &&  string_regex("[a-]+").matches("-a"));
+        assert(string_regex("[]a]+").matches("]a]"));
+        assert(string_regex("\\d+\\s\\D+").matches("42 apples"));
+        assert(string_regex("[\\W]+").matches("*&^")  &&  !string_regex("[\\W]+").matches("*a"));
+        assert(string_regex("a\\.b\\\\").matches("a.b\\")  &&  !string_regex("a\\.b").matches("axb"));
+        assert(string_regex("a.b").matches("axb")  &&  !string_regex("a.b").matches("a\nb"));
+        assert(string_regex("").matches("")  &&  string_regex("").find("abc").size() == 0);
+
+        // no pattern takes exponential time
+        immutable_string const as(std::string(5000, 'a'));
+        assert(!string_regex("(a*)*b").contains(as));
+        assert(!string_regex("(a|a)*b").matches(as));
+        assert(string_regex("(a|aa)*").matches(as));
+
+        // each thread reuses its match lists, so a small program run after a
+        // larger one, or alongside it on other threads, sees no stale state
+        string_regex const large("(?:[a-z]+[0-9]{1,3}|[0-9]+[a-z]{2,4}){1,8}");
+        string_regex const small("a?b");
+        assert(large.matches("ab12cd345ef6")  &&  small.matches("b")  &&  !small.matches("ab12"));
+        std::atomic<int> mismatches(0);
+        std::vector<std::thread> matchers;
+        for (int i=0; i<4; ++i)
+        {
+            matchers.push_back(std::thread([&large, &small, &mismatches]{
+                for (int j=0; j<1000; ++j)
+                {
+                    if (!large.matches("x1y22z333")  ||  large.matches("x1y22z3333")
+                     ||  !small.matches("ab")  ||  small.matches("aab")  ||  small.find("xxbx") != "b")
+                        ++mismatches;
+                }
+            }));
+        }
+        for (auto &matcher : matchers)
+            matcher.join();
+        assert(mismatches == 0);
+
+        char const *const invalid[] = { "(ab", "ab)", "[ab", "*a", "a**", "a{2,1}", "a{1001}", "(?=a)", "\\q", "[z-a]", "a\\" };
+        for (auto pattern : invalid)
+        {
+            bool thrown = false;
+            try { string_regex r(pattern); }
+            catch (std::invalid_argument const &) { thrown = true; }
+            assert(thrown);
+        }
+
+        auto const cached = string_regex::cached("[a-z]+");
+        assert(cached == string_regex::cached("[a-z]+"));
+        assert(cached->find("123abc456") == "abc");
+        std::size_t const capacity = string_regex::cache_capacity();
+        string_regex::set_cache_capacity(0);
+        assert(string_regex::cached("[a-z]+") != cached);
+        string_regex::set_cache_capacity(capacity);
+
+        cdmh::wstring_regex const wide(L"\\w+");
+        assert(wide.find(L"  wide  ") == L"wide");
+    }
+
+    // collation keys
+    {
+        // orders as the classic locale does, without regard to ASCII case
+        struct folding_collate : std::collate<char>
+        {
+            std::string do_transform(char const *low, char const *high) const override
+            {
+                std::string key(low, high);
+                for (auto &c : key)
+                    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                return key;
+            }
+        };
+        std::locale const folding(std::locale::classic(), new folding_collate);
+
+        immutable_string const alpha("Alpha");
+        assert(alpha.collation_key(folding) == "alpha");
+        assert(&alpha.collation_key(folding) == &alpha.collation_key(std::locale(folding)));
+        assert(alpha.collation_key(std::locale::classic()) == std::use_facet<std::collate<char>>(std::locale::classic()).transform(alpha.data(), alpha.data() + alpha.size()));
+        assert(&alpha.collation_key(std::locale::classic()) == &alpha.collation_key(std::locale("C")));
+        assert(&alpha.collation_key(folding) != &alpha.collation_key(std::locale::classic()));
+
+        immutable_string copy(alpha);
+        assert(copy.collation_key(folding) == "alpha"  &&  &copy.collation_key(folding) != &alpha.collation_key(folding));
+        std::string const *const key = &copy.collation_key(folding);
+        immutable_string const moved(std::move(copy));
+        assert(&moved.collation_key(folding) == key);
+
+        // a temporary's value taken by a modifier takes its keys with it
+        immutable_string released(std::string(45, 'z'));
+        assert(released.collation_key(folding).size() == 45);
+        assert(std::move(released).mutable_string().size() == 45);
+        assert(released.collation_key(folding).empty());
+        assert(!cdmh::collate_less(folding)(immutable_string(), released));
+
+        cdmh::collate_less const less(folding);
+        assert(less(immutable_string("alpha"), immutable_string("Beta")));
+        assert(!less(immutable_string("Beta"), immutable_string("alpha")));
+        assert(immutable_string("Beta") < immutable_string("alpha"));
+        assert(cdmh::collate_less()(immutable_string("Beta"), immutable_string("alpha")));
+
+        std::set<immutable_string, cdmh::collate_less> names(less);
+        char const *const values[] = { "delta", "Gamma", "beta", "Alpha", "epsilon" };
+        for (auto value : values)
+            names.insert(immutable_string(value));
+        std::string joined;
+        for (auto const &name : names)
+            joined += name.c_str();
+        assert(joined == "AlphabetadeltaepsilonGamma");
+
+        std::vector<immutable_string> words;
+        for (unsigned i=0; i<40000; ++i)
+        {
+            std::string word;
+            for (unsigned n=i * 2654435761u; n; n/=7)
+                word += static_cast<char>((n % 7 == 0? 'A' : 'a') + (n / 7) % 26);
+            words.push_back(immutable_string(word));
+        }
+        cdmh::sort_strings(words.begin(), words.end(), less, 4);
+        for (std::size_t i=1; i<words.size(); ++i)
+            assert(!less(words[i], words[i - 1]));
+
+        cdmh::wcollate_less const wide;
+        assert(wide(cdmh::immutable_wstring(L"abc"), cdmh::immutable_wstring(L"abd")));
+        assert(!wide(cdmh::immutable_wstring(L"abd"), cdmh::immutable_wstring(L"abc")));
+    }
+
+    // edit distance and approximate search
+    {
+        auto const levenshtein = [](std::string const &a, std::string const &b) {
+            std::vector<std::size_t> row(b.size() + 1);
+            for (std::size_t j=0; j<=b.size(); ++j)
+                row[j] = j;
+            for (std::size_t i=1; i<=a.size(); ++i)
+            {
+                std::size_t diagonal = row[0];
+                row[0] = i;
+                for (std::size_t j=1; j<=b.size(); ++j)
+                {
+                    std::size_t const above = row[j];
+                    row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + (a[i - 1] == b[j - 1]? 0 : 1));
+                    diagonal = above;
+                }
+            }
+            return row[b.size()];
+        };
+
+        assert(cdmh::edit_distance(immutable_string("kitten"), "sitting") == 3);
+        assert(cdmh::edit_distance(immutable_string(""), "abc") == 3);
+        assert(cdmh::edit_distance(immutable_string("abc"), "") == 3);
+        assert(cdmh::edit_distance(immutable_string("same"), "same") == 0);
+        assert(cdmh::edit_distance(immutable_string("kitten"), "sitting", 2) == 3);
+        assert(cdmh::edit_distance(immutable_string("kitten"), "sitting", 3) == 3);
+        assert(cdmh::edit_distance(immutable_string("a"), "abcdef", 2) == 3);
+        assert(cdmh::edit_distance(cdmh::ci_immutable_string("Kitten"), "KITTEN") == 0);
+        assert(cdmh::edit_distance(cdmh::immutable_u32string(U"\u4e2d\u6587x"), U"\u4e2d\u6588x") == 1);
+
+        // strings of several blocks of 64 characters, against the textbook
+        // algorithm
+        std::vector<std::string> samples;
+        std::uint32_t seed = 12345;
+        for (int i=0; i<60; ++i)
+        {
+            std::string sample;
+            std::size_t const length = (i * 37) % 200;
+            for (std::size_t n=0; n<length; ++n)
+            {
+                seed = seed * 1103515245 + 12345;
+                sample += static_cast<char>('a' + (seed >> 16) % 4);
+            }
+            samples.push_back(sample);
+        }
+        for (std::size_t i=0; i<samples.size(); i+=3)
+        {
+            for (std::size_t j=0; j<samples.size(); j+=5)
+            {
+                std::size_t const expected = levenshtein(samples[i], samples[j]);
+                assert(cdmh::edit_distance(immutable_string(samples[i]), samples[j].c_str()) == expected);
+                assert(cdmh::edit_distance(immutable_string(samples[i]), samples[j].c_str(), 40) == std::min<std::size_t>(expected, 41));
+            }
+        }
+
+        std::vector<immutable_string> names;
+        for (auto const &sample : samples)
+            names.push_back(immutable_string(sample.substr(0, sample.size() % 40)));
+        char const *const queries[] = { "", "abcd", "abcdabcdabcdabcdabcdabcdabcdabcd", "abcdabcdabcdabcdabcdabcdabcdabcda" };
+        for (auto query : queries)
+        {
+            auto const distances  = cdmh::edit_distances(immutable_string(query), names.begin(), names.end());
+            auto const bounded    = cdmh::edit_distances(immutable_string(query), names.begin(), names.end(), 12, 2);
+            for (std::size_t i=0; i<names.size(); ++i)
+            {
+                std::size_t const expected = levenshtein(query, names[i].c_str());
+                assert(distances[i] == expected);
+                assert(bounded[i] == std::min<std::size_t>(expected, 13));
+            }
+        }
+
+        immutable_string const text("the quick brown fox jumps over the lazy dog");
+        auto match = cdmh::find_approx(text, "quikc", 2);
+        assert(match.position == 4  &&  match.length == 4  &&  match.errors == 1);   // "quic"
+        match = cdmh::find_approx(text, "brwn", 1);
+        assert(text.substr(match.position, match.length) == "brown"  &&  match.errors == 1);
+        match = cdmh::find_approx(text, "lazy", 0);
+        assert(match.position == 35  &&  match.length == 4  &&  match.errors == 0);
+        match = cdmh::find_approx(text, "the", 0, 1);
+        assert(match.position == 31);
+        assert(cdmh::find_approx(text, "zebra", 1).position == std::size_t(-1));
+        assert(cdmh::find_approx(text, "", 0, 3).position == 3);
+        assert(cdmh::find_approx(text, "dog", 0, 100).position == std::size_t(-1));
+        match = cdmh::find_approx(immutable_string("xabc"), "abc", 1);
+        assert(match.position == 1  &&  match.length == 3  &&  match.errors == 0);
+    }
+
+    // prefix keys and sorting
+    {
+        assert(immutable_string("abc").prefix_key() == 0x6162630000000000ull);
+        assert(immutable_string("\xff").prefix_key() > immutable_string("abcdefghij").prefix_key());
+        assert(immutable_string("ab") < immutable_string(std::string("ab\0", 3))  &&  immutable_string("abcdefgh1") < immutable_string("abcdefgh2"));
+        assert(cdmh::immutable_wstring(L"abc").prefix_key() == 0  &&  cdmh::immutable_wstring(L"abc") < cdmh::immutable_wstring(L"abd"));
+
+        std::vector<std::string> expected;
+        for (std::size_t i=0; i<70000; ++i)
+        {
+            std::size_t const n = (i * 2654435761u) % 100000;
+            expected.push_back(((i % 3)? "https://example.com/" : "") + std::to_string(n) + std::string(i % 11, '/'));
+        }
+        expected.push_back(std::string("a\0b", 3));
+        expected.push_back("a");
+        expected.push_back("");
+
+        for (unsigned threads=1; threads<=4; threads+=3)
+        {
+            std::vector<immutable_string> strings(expected.begin(), expected.end());
+            cdmh::sort_strings(strings.begin(), strings.end(), threads);
+            std::vector<std::string> sorted(expected);
+            std::sort(sorted.begin(), sorted.end());
+            assert(std::equal(sorted.begin(), sorted.end(), strings.begin()));
+        }
+
+        // long equal strings are compared eight characters at a time to
+        // their ends
+        std::string const payload(16 * 1024 * 1024, 'x');
+        std::vector<immutable_string> payloads;
+        payloads.push_back(immutable_string(payload + "b"));
+        payloads.push_back(immutable_string(payload));
+        payloads.push_back(immutable_string(payload + "a"));
+        payloads.push_back(immutable_string(payload));
+        cdmh::sort_strings(payloads.begin(), payloads.end());
+        assert(payloads[0].size() == payload.size()  &&  payloads[1].size() == payload.size());
+        assert(payloads[2].back() == 'a'  &&  payloads[3].back() == 'b');
+
+        std::vector<cdmh::immutable_wstring> wide = { L"pear", L"apple", L"fig", L"apple" };
+        cdmh::sort_strings(wide.begin(), wide.end(), 0);
+        assert(wide[0] == L"apple"  &&  wide[1] == L"apple"  &&  wide[2] == L"fig"  &&  wide[3] == L"pear");
+    }
+
+    // parallel searches
+    {
+        std::string text(3 * 1024 * 1024, '.');
+        std::size_t const chunk = cdmh::detail::search_chunks::min_chunk;
+        std::size_t const positions[] = { 100, chunk - 2, chunk - 1, 2 * chunk - 3, 2 * chunk + 1, 2 * chunk + 3, text.size() - 4 };
+        for (auto pos : positions)
+            text.replace(pos, 4, "abab");
+        immutable_string const haystack(text);
+
+        std::vector<std::size_t> expected;
+        for (std::size_t pos=text.find("ab"); pos!=std::string::npos; pos=text.find("ab", pos + 1))
+            expected.push_back(pos);
+        for (unsigned threads=1; threads<=4; threads+=3)
+        {
+            assert(cdmh::parallel_find(haystack, "ab", 0, threads) == 100);
+            assert(cdmh::parallel_find(haystack, "ab", 101, threads) == 102  &&  cdmh::parallel_find(haystack, "ab", 2 * chunk + 6, threads) == text.size() - 4);
+            assert(cdmh::parallel_find(haystack, "abc", 0, threads) == immutable_string::npos);
+            assert(cdmh::parallel_count(haystack, "ab", threads) == expected.size()  &&  cdmh::parallel_count(haystack, "bab", threads) == 7);
+            assert(cdmh::parallel_find_all(haystack, "ab", threads) == expected);
+        }
+        assert(cdmh::parallel_find(immutable_string("abc"), "c") == 2  &&  cdmh::parallel_count(immutable_string("aaa"), "aa") == 2);
+        assert(cdmh::parallel_find_all(cdmh::immutable_string_view("abc"), "").size() == 4);
+
+        // the pool's threads are reused by later calls, each task runs once,
+        // and an exception thrown by any task reaches the caller
+        std::mutex mutex;
+        std::set<std::thread::id> workers;
+        std::vector<int> runs(64);
+        for (int call=0; call<10; ++call)
+        {
+            cdmh::detail::run_parallel(runs.size(), 4, [&](std::size_t task) {
+                std::lock_guard<std::mutex> lock(mutex);
+                workers.insert(std::this_thread::get_id());
+                ++runs[task];
+            });
+        }
+        assert(workers.size() <= 4  &&  std::count(runs.begin(), runs.end(), 10) == 64);
+
+        for (std::size_t failing=0; failing<64; failing+=21)
+        {
+            bool thrown = false;
+            try
+            {
+                cdmh::detail::run_parallel(64, 4, [failing](std::size_t task) {
+                    if (task == failing)
+                        throw std::runtime_error("task failed");
+                });
+            }
+            catch (std::runtime_error const &)
+            {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+
+    // front coded sets
+    {
+        std::vector<immutable_string> paths;
+        for (int i=999; i>=0; --i)
+            paths.push_back(immutable_string("/usr/share/doc/package-").append(std::to_string(i % 500)).append("/readme.txt"));
+        paths.push_back("/etc/hosts");
+        cdmh::immutable_string_set const set(paths.begin(), paths.end());
+        std::set<immutable_string> const expected(paths.begin(), paths.end());
+        assert(set.size() == expected.size()  &&  std::equal(expected.begin(), expected.end(), set.begin()));
+        assert(set[0] == "/etc/hosts"  &&  set.at(set.size() - 1) == *expected.rbegin());
+        assert(set.contains("/usr/share/doc/package-42/readme.txt")  &&  !set.contains("/usr/share/doc/package-42"));
+        assert(*set.lower_bound("/usr/share/doc/package-42") == "/usr/share/doc/package-42/readme.txt");
+        assert(*set.upper_bound("/usr/share/doc/package-42/readme.txt") == *expected.upper_bound("/usr/share/doc/package-42/readme.txt"));
+        assert(set.lower_bound("/zzz") == set.end()  &&  set.find("/a") == set.end());
+
+        auto const range = set.prefix_range("/usr/share/doc/package-4");
+        assert(std::distance(range.first, range.second) == 111);
+        for (auto it=range.first; it!=range.second; ++it)
+            assert(it.view().substr(0, 24) == "/usr/share/doc/package-4");
+        auto const none = set.prefix_range("/usr/local");
+        assert(none.first == none.second);
+        assert(std::distance(set.prefix_range("").first, set.prefix_range("").second) == 501);
+
+        cdmh::memory_usage const usage = cdmh::measure_memory(expected.begin(), expected.end());
+        assert(set.heap_bytes() * 3 < usage.total_bytes);
+        assert(cdmh::immutable_string_set().begin() == cdmh::immutable_string_set().end());
+    }
+
+    // views and snapshots
+    {
+        cdmh::immutable_string_view const view(pangram1);
+        assert(view == pangram1  &&  view.data() == pangram1.data());
+        assert(view.substr(4, 5) == "quick"  &&  view.substr(4, 5).str() == immutable_string("quick"));
+        assert(view.find("fox") == pangram1.find("fox")  &&  view.find('z') == pangram1.find('z')  &&  view.find("cat") == immutable_string::npos);
+        assert(std::hash<cdmh::immutable_string_view>()(view) == std::hash<immutable_string>()(pangram1));
+
+        std::vector<immutable_string> table;
+        for (int i=0; i<500; ++i)
+            table.push_back(immutable_string("symbol_").append(std::to_string(i * 7)));
+        table.push_back(immutable_string());
+
+        for (int with_hashes=0; with_hashes<2; ++with_hashes)
+        {
+            std::ostringstream os;
+            cdmh::write_snapshot(os, table.begin(), table.end(), with_hashes != 0);
+            std::string const bytes = os.str();
+            std::vector<std::uint64_t> aligned((bytes.size() + 7) / 8);
+            memcpy(aligned.data(), bytes.data(), bytes.size());
+
+            cdmh::immutable_string_snapshot const snapshot(aligned.data(), bytes.size());
+            assert(snapshot.size() == table.size()  &&  snapshot.has_hashes() == (with_hashes != 0));
+            for (std::size_t i=0; i<table.size(); ++i)
+            {
+                assert(snapshot[i] == table[i]  &&  snapshot[i].data()[snapshot[i].size()] == 0);
+                assert(snapshot.hash(i) == std::hash<immutable_string>()(table[i]));
+                assert(snapshot.find(table[i]) == i);
+            }
+            assert(snapshot.find("symbol_1") == cdmh::immutable_string_snapshot::npos);
+            assert(reinterpret_cast<char const *>(snapshot[0].data()) > reinterpret_cast<char const *>(aligned.data()));
+
+            bool thrown = false;
+            try { cdmh::immutable_string_snapshot(aligned.data(), 16); } catch (std::runtime_error const &) { thrown = true; }
+            assert(thrown);
+        }
+
+        char const *const path = "immutable_string_snapshot.test";
+        {
+            std::ofstream file(path, std::ios::binary);
+            cdmh::write_snapshot(file, table.begin(), table.end());
+        }
+        {
+            cdmh::immutable_string_snapshot const snapshot = cdmh::immutable_string_snapshot::map(path);
+            assert(snapshot.size() == table.size()  &&  snapshot.at(42) == table[42]);
+            assert(snapshot.find(table[123]) == 123);
+        }
+        std::remove(path);
+    }
+
+#ifdef IMMUTABLE_STRING_STATISTICS
+    // allocation statistics
+    {
+        namespace statistics = cdmh::statistics;
+        statistics::reset();
+        immutable_string const base(std::string(100, 'x'));
+        {
+            immutable_string const copy(base);
+            immutable_string const appended = base.append(base);
+            immutable_string const small = base.substr(0, 3);
+            immutable_string const erased = base.erase(0, 10);
+            assert(copy == base  &&  appended.size() == 200  &&  small == "xxx"  &&  erased.size() == 90);
+        }
+        statistics::report const report = statistics::collect();
+        assert(report.operations[statistics::construct].allocations == 1);
+        assert(report.operations[statistics::construct].bytes_copied == 0);
+        assert(report.operations[statistics::copy_construct].allocations == 1);
+        assert(report.operations[statistics::copy_construct].bytes_copied == 100);
+        assert(report.operations[statistics::append].allocations == 1);
+        assert(report.operations[statistics::append].bytes_allocated > 200);
+        assert(report.operations[statistics::append].bytes_copied == 200);
+        assert(report.operations[statistics::substr].allocations == 0);
+        assert(report.operations[statistics::substr].bytes_copied == 3);
+        assert(report.operations[statistics::erase].bytes_copied == 90);
+        assert(report.operations[statistics::destruct].deallocations == 3);
+        assert(report.total().allocations == 4  &&  report.total().deallocations == 3);
+
+        std::thread([&base]{ immutable_string const copy(base); }).join();
+        assert(statistics::collect().operations[statistics::copy_construct].allocations == 2);
+        assert(statistics::collect().total().deallocations == 4);
+        statistics::reset();
+        assert(statistics::collect().total().allocations == 0);
+
+        // a temporary modified in place allocates and copies nothing
+        immutable_string large(std::string(1000, 'x'));
+        immutable_string const erased = std::move(large).erase(0, 10);
+        assert(erased.size() == 990);
+        statistics::counters const in_place = statistics::collect().operations[statistics::erase];
+        assert(in_place.allocations == 0  &&  in_place.bytes_allocated == 0  &&  in_place.bytes_copied == 0);
+        immutable_string const grown = std::move(immutable_string(erased)).append(std::string(5000, 'y'));
+        statistics::counters const reallocated = statistics::collect().operations[statistics::append];
+        assert(reallocated.allocations == 1  &&  reallocated.bytes_copied == grown.size());
+    }
+#endif
+
     assert(pangram1.c_str() == pangram1.data());
     assert(pangram1.get_allocator() == std::allocator<char>());
     char buffer[44] = { 0 };
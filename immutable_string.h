@@ -19,8 +19,28 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <functional>
+#include <iterator>
+#include <locale>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // "MSVC2013 Preview" didn't have initializer_list but _MSC_VER was defined 1800,
 // so if you are using that compiler, you'll need to modify this condition
@@ -29,6 +49,46 @@
 #include <initializer_list>
 #endif
 
+// MSVC2013 doesn't support ref-qualified member functions
+#if !defined(_MSC_VER)  ||  _MSC_VER >= 1900
+#define HAS_REF_QUALIFIERS 1
+#define CONST_LVALUE const &
+#else
+#define CONST_LVALUE const
+#endif
+
+// MSVC2013 doesn't support constexpr functions
+#if !defined(_MSC_VER)  ||  _MSC_VER >= 1900
+#define HAS_CONSTEXPR 1
+#endif
+
+// MSVC2012 doesn't support variadic templates
+#if !defined(_MSC_VER)  ||  _MSC_VER >= 1800
+#define HAS_VARIADIC_TEMPLATES 1
+#endif
+
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+#define HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// floating point operations are evaluated at the precision of their type,
+// so one operation on exact values is rounded once, correctly
+#if defined(FLT_EVAL_METHOD)  &&  FLT_EVAL_METHOD == 0
+#define HAS_EXACT_FLOATING_ARITHMETIC 1
+#endif
+
+#include "immutable_string_config.h"
+
+#ifdef IMMUTABLE_STRING_STATISTICS
+#include "immutable_string_statistics.h"
+#else
+#define IMMUTABLE_STRING_OPERATION(op)
+#define IMMUTABLE_STRING_RECORD(op)
+#define IMMUTABLE_STRING_RECORD_MOVE(op)
+#define IMMUTABLE_STRING_RECORD_ADOPTION(buffer)
+#endif
+
 #ifdef __GNUC__
 #define GCC_VERSION (__GNUC__ * 10000 \
                    + __GNUC_MINOR__ * 100 \
@@ -40,10 +100,208 @@
 
 namespace cdmh {
 
-#if !defined(_MSC_VER)  ||  _MSC_VER <= 1800
+#if defined(_MSC_VER)  &&  _MSC_VER <= 1800
 #define noexcept throw()
 #endif
 
+namespace detail {
+
+// one entry of a replace_all() substitution table
+template<typename Char>
+struct substitution
+{
+    Char const  *from;
+    std::size_t  from_len;
+    Char const  *to;
+    std::size_t  to_len;
+};
+
+// a collation key cached by basic_immutable_string::collation_key(). the
+// keys of a string, one per locale, are held in a list that only grows
+// while the string lives
+struct collation_node
+{
+    collation_node() noexcept : next(nullptr)                                                                  { }
+    virtual ~collation_node()                                                                                  { }
+
+    collation_node *next;
+};
+
+template<typename Char>
+struct collation_key_node : collation_node
+{
+    std::locale               locale;   // keeps the facet alive, so that its address identifies it
+    std::collate<Char> const *facet;
+    std::string               name;     // of the locale, or "*" if it has none
+    std::basic_string<Char>   key;
+};
+
+// lazily computed properties of a string value. the value never changes, so
+// threads that race to compute a property all store the same result, and a
+// relaxed atomic is enough to make that well defined
+class string_metadata
+{
+  public:
+    enum { utf_computed=1, utf_valid=2, utf_ascii=4, prefix_computed=8, hash_computed=16, utf_count_shift=5 };
+
+    string_metadata() noexcept : utf(0), prefix(0), hash(0), collation(nullptr)                                { }
+    string_metadata(string_metadata const &other) noexcept
+      : utf(other.utf.load(std::memory_order_acquire)),
+        prefix(other.prefix.load(std::memory_order_relaxed)),
+        hash(other.hash.load(std::memory_order_relaxed)),
+        collation(nullptr)                                                                                     { }
+
+    // a string is not read by other threads while it is moved from or
+    // destroyed, so plain loads and stores are enough to take its metadata
+    string_metadata(string_metadata &&other) noexcept
+      : utf(other.utf.load(std::memory_order_acquire)),
+        prefix(other.prefix.load(std::memory_order_relaxed)),
+        hash(other.hash.load(std::memory_order_relaxed)),
+        collation(other.collation.load(std::memory_order_relaxed))
+    {
+        other.utf.store(0, std::memory_order_relaxed);
+        other.collation.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~string_metadata()                                                                                         { drop_collation(); }
+
+    // frees the collation keys, as when the value is moved out
+    void drop_collation(void) noexcept
+    {
+        collation_node *node = collation.load(std::memory_order_relaxed);
+        if (!node)
+            return;
+
+        collation.store(nullptr, std::memory_order_relaxed);
+        while (node)
+        {
+            collation_node *const next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // flags are only ever added with fetch_or(), and prefix_computed and
+    // hash_computed with release order, so a thread that sees one of them
+    // with acquire order sees the value it flags
+    mutable std::atomic<std::uint64_t>    utf;        // utf_* flags, *_computed flags, and the code point count
+    mutable std::atomic<std::uint64_t>    prefix;     // the prefix key, once prefix_computed is set
+    mutable std::atomic<std::uint64_t>    hash;       // the hash, once hash_computed is set
+    mutable std::atomic<collation_node *> collation;  // the collation keys; a copy computes its own
+
+  private:
+    string_metadata &operator=(string_metadata const &);
+};
+
+// packs the first characters of a string into an integer that orders as
+// the string does under Traits, for sorting and comparing without reading
+// the characters. the key is only defined where the order of Traits is
+// that of the unsigned character values; elsewhere enabled is false and
+// the key is always zero
+template<typename Char, typename Traits>
+struct prefix_key
+{
+    static bool const enabled = false;
+    static std::size_t const chars = 0;
+
+    static std::uint64_t const pack(Char const *, std::size_t) noexcept { return 0; }
+};
+
+// the characters, zero padded, in the most significant bits first. equal
+// keys leave the order to the characters that follow, and to the length
+template<typename Char>
+struct big_endian_prefix_key
+{
+    static bool const enabled = true;
+    static std::size_t const chars = sizeof(std::uint64_t) / sizeof(Char);
+
+    static std::uint64_t const pack(Char const *s, std::size_t n) noexcept
+    {
+        typedef typename std::make_unsigned<Char>::type unsigned_char;
+
+        std::uint64_t key = 0;
+        if (n >= chars)
+        {
+            for (std::size_t i=0; i<chars; ++i)
+                key = (key << (8 * sizeof(Char))) | static_cast<unsigned_char>(s[i]);
+        }
+        else
+        {
+            for (std::size_t i=0; i<chars; ++i)
+                key = (key << (8 * sizeof(Char))) | (i < n? static_cast<unsigned_char>(s[i]) : 0);
+        }
+        return key;
+    }
+};
+
+template<> struct prefix_key<char,     std::char_traits<char>>     : big_endian_prefix_key<char>     { };
+template<> struct prefix_key<char16_t, std::char_traits<char16_t>> : big_endian_prefix_key<char16_t> { };
+template<> struct prefix_key<char32_t, std::char_traits<char32_t>> : big_endian_prefix_key<char32_t> { };
+
+// the overloads taking a C string are templates that take any pointer to
+// a character by value, so that the overloads taking a const character
+// array, such as a string literal, are more specialized and are chosen for
+// one. an array that isn't const is a buffer, which is measured as a C
+// string
+template<typename T, typename Char, typename Result>
+struct if_c_string : std::enable_if<std::is_pointer<T>::value  &&  std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, Char>::value, Result>
+{
+};
+
+template<typename T, typename Char, typename Result>
+struct if_literal : std::enable_if<std::is_same<T, Char const>::value, Result>
+{
+};
+
+// the length of a string literal, up to its first terminator as for a C
+// string. the terminator is looked for only within the array, so that an
+// optimizing compiler can fold the length of a literal to a constant; it
+// is not a constant expression. an array with no terminator is all
+// characters but the last, as it would be if the last were the terminator
+template<typename Traits, typename Char, std::size_t N>
+std::size_t const literal_length(Char const (&s)[N]) noexcept
+{
+    Char const *const terminator = Traits::find(s, N, Char());
+    return terminator? static_cast<std::size_t>(terminator - s) : N - 1;
+}
+
+// whether an iterator refers to characters in memory, which may be those
+// of the string that it is passed to
+template<typename Iterator, typename Char>
+struct refers_to_chars : std::integral_constant<bool, std::is_lvalue_reference<typename std::iterator_traits<Iterator>::reference>::value
+                                                  &&  std::is_same<typename std::remove_cv<typename std::remove_reference<typename std::iterator_traits<Iterator>::reference>::type>::type, Char>::value>
+{
+};
+
+// the types that from() formats: integers and floating point, but not bool
+template<typename T, typename Result>
+struct if_number : std::enable_if<std::is_arithmetic<T>::value  &&  !std::is_same<T, bool>::value, Result>
+{
+};
+
+}   // namespace detail
+
+// the memory used by the characters of a string, as reported by footprint()
+struct string_footprint
+{
+    void const  *buffer;        // identifies the storage, or nullptr if it is held within the object
+    std::size_t  heap_bytes;    // bytes allocated for the storage
+    bool         shared;        // whether other strings use the same storage
+    std::size_t  share_count;   // the number of strings using the storage
+};
+
+// the memory used by a population of strings, from measure_memory()
+struct memory_usage
+{
+    std::size_t strings;        // the number of strings measured
+    std::size_t buffers;        // distinct heap buffers
+    std::size_t object_bytes;   // the string objects themselves
+    std::size_t unique_bytes;   // buffers used by a single string
+    std::size_t shared_bytes;   // buffers used by more than one string, each counted once
+    std::size_t saved_bytes;    // shared bytes that would be duplicated if each string had a copy
+    std::size_t total_bytes;    // object_bytes + unique_bytes + shared_bytes
+};
+
 template<typename Char,
          typename Traits = std::char_traits<Char>,    // basic_string::traits_type
          typename Alloc = std::allocator<Char>>       // basic_string::allocator_type
@@ -73,50 +331,65 @@ class basic_immutable_string
       constructors
     */
     // default
-    explicit basic_immutable_string(allocator_type const &alloc = allocator_type()) : string_(alloc)                           { }
+    explicit basic_immutable_string(allocator_type const &alloc = allocator_type()) : string_(alloc)                           { IMMUTABLE_STRING_RECORD(construct); }
 
     // copy
-    basic_immutable_string(basic_immutable_string const &str) : string_(str.string_)                                           { }
+    basic_immutable_string(basic_immutable_string const &str) : string_(str.string_), meta_(str.meta_)                         { IMMUTABLE_STRING_RECORD(copy_construct); }
 #ifndef _LIBSTDC_BUG_53221_WORKAROUND
-    basic_immutable_string(basic_immutable_string const &str, allocator_type const &alloc) : string_(str.string_, alloc)       { }
+    basic_immutable_string(basic_immutable_string const &str, allocator_type const &alloc)
+      : string_(str.string_, alloc), meta_(str.meta_)                                                                          { IMMUTABLE_STRING_RECORD(copy_construct); }
 #endif
 
     // substring
     basic_immutable_string(basic_immutable_string const &str, size_type pos, size_type len = npos,
-                           allocator_type const &alloc = allocator_type()) : string_(str.string_, pos, len, alloc)             { }
+                           allocator_type const &alloc = allocator_type()) : string_(str.string_, pos, len, alloc)             { IMMUTABLE_STRING_RECORD(construct); }
 
     // from c-string
-    basic_immutable_string(Char const * const s, allocator_type const &alloc = allocator_type()) : string_(s, alloc)          { }
+    template<typename T>
+    basic_immutable_string(T s, allocator_type const &alloc = allocator_type(),
+                           typename detail::if_c_string<T, Char, int>::type = 0) : string_(s, alloc)                          { IMMUTABLE_STRING_RECORD(construct); }
+
+    // from string literal
+    template<typename T, std::size_t N>
+    basic_immutable_string(T (&s)[N], allocator_type const &alloc = allocator_type(),
+                           typename detail::if_literal<T, Char, int>::type = 0)
+      : string_(s, detail::literal_length<Traits>(s), alloc)                                                                    { IMMUTABLE_STRING_RECORD(construct); }
 
     // from buffer
     basic_immutable_string(Char const * const s, size_type n,
-                           allocator_type const &alloc = allocator_type()) : string_(s, n, alloc)                              { }
+                           allocator_type const &alloc = allocator_type()) : string_(s, n, alloc)                              { IMMUTABLE_STRING_RECORD(construct); }
 
     // fill
     basic_immutable_string(size_type n, Char c,
-                           allocator_type const &alloc = allocator_type()) : string_(n, c, alloc)                              { }
+                           allocator_type const &alloc = allocator_type()) : string_(n, c, alloc)                              { IMMUTABLE_STRING_RECORD(construct); }
 
-    basic_immutable_string(Char c, allocator_type const &alloc = allocator_type()) : string_(1, c, alloc)                     { }
+    basic_immutable_string(Char c, allocator_type const &alloc = allocator_type()) : string_(1, c, alloc)                     { IMMUTABLE_STRING_RECORD(construct); }
 
     // range
     template<typename InputIterator>
     basic_immutable_string(InputIterator first, InputIterator last,
-                           allocator_type const &alloc = allocator_type()) : string_(first, last, alloc)                       { }
+                           allocator_type const &alloc = allocator_type()) : string_(first, last, alloc)                       { IMMUTABLE_STRING_RECORD(construct); }
 #if HAS_INITIALIZER_LIST
     // initializer list
     basic_immutable_string(std::initializer_list<Char> il,
-                           allocator_type const &alloc = allocator_type()) : string_(il, alloc)                                { }
+                           allocator_type const &alloc = allocator_type()) : string_(il, alloc)                                { IMMUTABLE_STRING_RECORD(construct); }
 #endif
 
     // move
-    basic_immutable_string(basic_immutable_string &&str) noexcept : string_(std::move(str.string_))                            { }
+    basic_immutable_string(basic_immutable_string &&str) noexcept
+      : string_(std::move(str.string_)), meta_(std::move(str.meta_))                                                          { }
 #ifndef _LIBSTDC_BUG_53221_WORKAROUND
-    basic_immutable_string(basic_immutable_string &&str, allocator_type const &alloc) : string_(std::move(str.string_), alloc) { }
+    basic_immutable_string(basic_immutable_string &&str, allocator_type const &alloc)
+      : string_(std::move(str.string_), alloc), meta_(std::move(str.meta_))                                                   { }
 #endif
 
     // custom ctors (i.e. not from the C++ std::basic_string
-    basic_immutable_string(std::basic_string<Char, Traits, Alloc> const &str) : string_(str)                                  { }
-    basic_immutable_string(std::basic_string<Char, Traits, Alloc> &&str) : string_(std::forward<std::basic_string<Char, Traits, Alloc>>(str)) { }
+    basic_immutable_string(std::basic_string<Char, Traits, Alloc> const &str) : string_(str)                                  { IMMUTABLE_STRING_RECORD(construct); }
+    basic_immutable_string(std::basic_string<Char, Traits, Alloc> &&str) : string_(std::forward<std::basic_string<Char, Traits, Alloc>>(str)) { IMMUTABLE_STRING_RECORD_MOVE(construct); }
+
+#ifdef IMMUTABLE_STRING_STATISTICS
+    ~basic_immutable_string()                                                                                                   { statistics::detail::record_deallocation(heap_bytes()); }
+#endif
 
     int const compare(basic_immutable_string const &str)                                                     const noexcept { return string_.compare(str.string_);                       }
     int const compare(std::basic_string<Char, Traits, Alloc> const &str)                                     const noexcept { return string_.compare(str);                               }
@@ -127,8 +400,14 @@ class basic_immutable_string
                       size_type subpos, size_type sublen)                                                    const          { return string_.compare(pos,len,str.string_,subpos,sublen); }
     int const compare(size_type pos, size_type len, std::basic_string<Char, Traits, Alloc> const &str,        
                       size_type subpos, size_type sublen)                                                    const          { return string_.compare(pos,len,str,subpos,sublen);         }
-    int const compare(Char const *s)                                                                         const          { return string_.compare(s);                                 }
-    int const compare(size_type pos, size_type len, Char const *s)                                           const          { return string_.compare(pos,len,s);                         }
+    template<typename T>
+    typename detail::if_c_string<T, Char, int const>::type compare(T s)                                     const          { return string_.compare(s);                                 }
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, int const>::type  compare(T (&s)[N])                                const          { return string_.compare(0,size(),s,detail::literal_length<Traits>(s)); }
+    template<typename T>
+    typename detail::if_c_string<T, Char, int const>::type compare(size_type pos, size_type len, T s)       const          { return string_.compare(pos,len,s);                         }
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, int const>::type  compare(size_type pos, size_type len, T (&s)[N])  const          { return string_.compare(pos,len,s,detail::literal_length<Traits>(s)); }
     int const compare(size_type pos, size_type len, Char const *s, size_type n)                              const          { return string_.compare(pos,len,s,n);                       }
                                                                                                              
     // Iterators                                                                                             
@@ -143,6 +422,7 @@ class basic_immutable_string
     size_type        const size(void)                                                                        const noexcept { return string_.size();                                     }
     size_type        const max_size(void)                                                                    const noexcept { return string_.max_size();                                 }
     size_type        const capacity(void)                                                                    const noexcept { return string_.capacity();                                 }
+    string_footprint const footprint(void)                                                                   const noexcept;
                                                                                                                                                                                          
     // Element access                                                                                                                                                                    
     const_reference         operator[](size_type pos)                                                        const          { return string_[pos];                                       }
@@ -153,126 +433,363 @@ class basic_immutable_string
     /*                                                                                                       
       Modifiers                                                                                              
     */                                                                                                       
-    basic_immutable_string substr(size_type pos=0, size_type len=npos)                                       const          { return basic_immutable_string(*this, pos, len);            }
+    basic_immutable_string substr(size_type pos=0, size_type len=npos)                                       const          { IMMUTABLE_STRING_OPERATION(substr); return basic_immutable_string(*this, pos, len); }
 
-    basic_immutable_string append(basic_immutable_string const &str)                                         const;    // immutable string
-    basic_immutable_string append(std::basic_string<Char, Traits, Alloc> const &str)                         const;    // string
+    basic_immutable_string append(basic_immutable_string const &str)                                         CONST_LVALUE;    // immutable string
+    basic_immutable_string append(std::basic_string<Char, Traits, Alloc> const &str)                         CONST_LVALUE;    // string
     basic_immutable_string append(basic_immutable_string const &str,                                         
-                                  size_type subpos, size_type sublen)                                        const;    // substring (immutable source)
+                                  size_type subpos, size_type sublen)                                        CONST_LVALUE;    // substring (immutable source)
     basic_immutable_string append(std::basic_string<Char, Traits, Alloc> const &str,                        
-                                  size_type subpos, size_type sublen)                                        const;    // substring
-    basic_immutable_string append(Char const * const s)                                                      const;    // c-string
-    basic_immutable_string append(Char const * const s, size_type n)                                         const;    // buffer
-    basic_immutable_string append(size_type n, Char c)                                                       const;    // fill
-    basic_immutable_string append(Char c)                                                                    const;
+                                  size_type subpos, size_type sublen)                                        CONST_LVALUE;    // substring
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type append(T s)                         CONST_LVALUE;    // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  append(T (&s)[N])                    CONST_LVALUE { return append(s, detail::literal_length<Traits>(s)); } // literal
+    basic_immutable_string append(Char const * const s, size_type n)                                         CONST_LVALUE;    // buffer
+    basic_immutable_string append(size_type n, Char c)                                                       CONST_LVALUE;    // fill
+    basic_immutable_string append(Char c)                                                                    CONST_LVALUE;
     template<typename InputIterator>                                                                           
-    basic_immutable_string append(InputIterator first, InputIterator last)                                   const;    // range
+    basic_immutable_string append(InputIterator first, InputIterator last)                                   CONST_LVALUE;    // range
 #if HAS_INITIALIZER_LIST                                                                                     
-    basic_immutable_string append(std::initializer_list<Char> il)                                            const;    // initializer list
+    basic_immutable_string append(std::initializer_list<Char> il)                                            CONST_LVALUE;    // initializer list
 #endif                                                                                                       
                                                                                                              
-    basic_immutable_string insert(size_type pos, basic_immutable_string const &str)                          const;    // immutable string
-    basic_immutable_string insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str)          const;    // string
+    basic_immutable_string insert(size_type pos, basic_immutable_string const &str)                          CONST_LVALUE;    // immutable string
+    basic_immutable_string insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str)          CONST_LVALUE;    // string
     basic_immutable_string insert(size_type pos, basic_immutable_string const &str,                                    // substring (immutable source)
-                                  size_type subpos, size_type sublen)                                        const;    // substring
+                                  size_type subpos, size_type sublen)                                        CONST_LVALUE;    // substring
     basic_immutable_string insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str,         
-                                  size_type subpos, size_type sublen)                                        const;    // substring
-    basic_immutable_string insert(size_type pos, Char const *s)                                              const;    // c-string
-    basic_immutable_string insert(size_type pos, Char const *s, size_type n)                                 const;    // buffer
-    basic_immutable_string insert(size_type pos,   size_type n, Char c)                                      const;    // fill
-    basic_immutable_string insert(const_iterator p, size_type n, Char c)                                     const;    // fill
-    basic_immutable_string insert(const_iterator p, Char c)                                                  const;    // single character
+                                  size_type subpos, size_type sublen)                                        CONST_LVALUE;    // substring
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type insert(size_type pos, T s)          CONST_LVALUE;    // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  insert(size_type pos, T (&s)[N])     CONST_LVALUE { return insert(pos, s, detail::literal_length<Traits>(s)); } // literal
+    basic_immutable_string insert(size_type pos, Char const *s, size_type n)                                 CONST_LVALUE;    // buffer
+    basic_immutable_string insert(size_type pos,   size_type n, Char c)                                      CONST_LVALUE;    // fill
+    basic_immutable_string insert(const_iterator p, size_type n, Char c)                                     CONST_LVALUE;    // fill
+    basic_immutable_string insert(const_iterator p, Char c)                                                  CONST_LVALUE;    // single character
     template<typename InputIterator>                                                                           
-    basic_immutable_string insert(const_iterator p, InputIterator first, InputIterator last)                 const;    // range
+    basic_immutable_string insert(const_iterator p, InputIterator first, InputIterator last)                 CONST_LVALUE;    // range
 #if HAS_INITIALIZER_LIST                                                                                     
-    basic_immutable_string insert(const_iterator p, std::initializer_list<Char> il)                          const;    // initializer list
+    basic_immutable_string insert(const_iterator p, std::initializer_list<Char> il)                          CONST_LVALUE;    // initializer list
 #endif                                                                                                       
                                                                                                              
-    basic_immutable_string erase(size_type pos=0, size_type len=npos)                                        const;    // sequence
-    basic_immutable_string erase(const_iterator p)                                                           const;    // character
-    basic_immutable_string erase(const_iterator first, const_iterator last)                                  const;    // range
+    basic_immutable_string erase(size_type pos=0, size_type len=npos)                                        CONST_LVALUE;    // sequence
+    basic_immutable_string erase(const_iterator p)                                                           CONST_LVALUE;    // character
+    basic_immutable_string erase(const_iterator first, const_iterator last)                                  CONST_LVALUE;    // range
                                                                                                              
                                                                                                              
-    basic_immutable_string replace(size_type pos, size_type len, basic_immutable_string const &str)          const;    // string
+    basic_immutable_string replace(size_type pos, size_type len, basic_immutable_string const &str)          CONST_LVALUE;    // string
     basic_immutable_string replace(size_type pos, size_type len,                                             
-                                   std::basic_string<Char, Traits, Alloc> const &str)                        const;    // string
+                                   std::basic_string<Char, Traits, Alloc> const &str)                        CONST_LVALUE;    // string
     basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
-                                   basic_immutable_string const &str)                                        const;    // string
+                                   basic_immutable_string const &str)                                        CONST_LVALUE;    // string
     basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
-                                   std::basic_string<Char, Traits, Alloc> const &str)                        const;    // string
+                                   std::basic_string<Char, Traits, Alloc> const &str)                        CONST_LVALUE;    // string
                                                                                                              
     basic_immutable_string replace(size_type pos, size_type len,                                             
                                    basic_immutable_string const &str,                                        
-                                   size_type subpos, size_type sublen)                                       const;    // substring
+                                   size_type subpos, size_type sublen)                                       CONST_LVALUE;    // substring
     basic_immutable_string replace(size_type pos, size_type len,                                             
                                    std::basic_string<Char, Traits, Alloc> const &str,                       
-                                   size_type subpos, size_type sublen)                                       const;    // substring
+                                   size_type subpos, size_type sublen)                                       CONST_LVALUE;    // substring
                                                                                                              
-    basic_immutable_string replace(size_type pos,     size_type len,     Char const *s)                      const;    // c-string
-    basic_immutable_string replace(const_iterator i1, const_iterator i2, Char const *s)                      const;    // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type replace(size_type pos, size_type len, T s) CONST_LVALUE; // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  replace(size_type pos, size_type len, T (&s)[N]) CONST_LVALUE { return replace(pos, len, s, detail::literal_length<Traits>(s)); } // literal
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type replace(const_iterator i1, const_iterator i2, T s) CONST_LVALUE; // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  replace(const_iterator i1, const_iterator i2, T (&s)[N]) CONST_LVALUE { return replace(i1, i2, s, detail::literal_length<Traits>(s)); } // literal
                                                                                                               
-    basic_immutable_string replace(size_type pos,     size_type len,     Char const *s, size_type n)         const;    // buffer
-    basic_immutable_string replace(const_iterator i1, const_iterator i2, Char const *s, size_type n)         const;    // buffer
+    basic_immutable_string replace(size_type pos,     size_type len,     Char const *s, size_type n)         CONST_LVALUE;    // buffer
+    basic_immutable_string replace(const_iterator i1, const_iterator i2, Char const *s, size_type n)         CONST_LVALUE;    // buffer
                                                                                                               
-    basic_immutable_string replace(size_type pos,     size_type len,     size_type n, Char c)                const;    // fill
-    basic_immutable_string replace(const_iterator i1, const_iterator i2, size_type n, Char c)                const;    // fill
+    basic_immutable_string replace(size_type pos,     size_type len,     size_type n, Char c)                CONST_LVALUE;    // fill
+    basic_immutable_string replace(const_iterator i1, const_iterator i2, size_type n, Char c)                CONST_LVALUE;    // fill
                                                                                                              
     template<typename InputIterator>                                                                           
     basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
-                                   InputIterator first, InputIterator last)                                  const;    // range
+                                   InputIterator first, InputIterator last)                                  CONST_LVALUE;    // range
                                                                                                              
 #if HAS_INITIALIZER_LIST                                                                                     
     basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
-                                   std::initializer_list<Char> il)                                           const;    // initializer list
+                                   std::initializer_list<Char> il)                                           CONST_LVALUE;    // initializer list
+#endif
+
+#if HAS_REF_QUALIFIERS
+    // the modifiers of a temporary edit its buffer in place rather than copying
+    // it, so a chain such as s.append(a).insert(0, b).erase(5) copies s once
+    basic_immutable_string append(basic_immutable_string const &str)                                         &&;       // immutable string
+    basic_immutable_string append(std::basic_string<Char, Traits, Alloc> const &str)                         &&;       // string
+    basic_immutable_string append(basic_immutable_string const &str,                                         
+                                  size_type subpos, size_type sublen)                                        &&;       // substring (immutable source)
+    basic_immutable_string append(std::basic_string<Char, Traits, Alloc> const &str,                        
+                                  size_type subpos, size_type sublen)                                        &&;       // substring
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type append(T s)                         &&;       // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  append(T (&s)[N])                    && { return std::move(*this).append(s, detail::literal_length<Traits>(s)); } // literal
+    basic_immutable_string append(Char const * const s, size_type n)                                         &&;       // buffer
+    basic_immutable_string append(size_type n, Char c)                                                       &&;       // fill
+    basic_immutable_string append(Char c)                                                                    &&;
+    template<typename InputIterator>                                                                           
+    basic_immutable_string append(InputIterator first, InputIterator last)                                   &&;       // range
+#if HAS_INITIALIZER_LIST                                                                                     
+    basic_immutable_string append(std::initializer_list<Char> il)                                            &&;       // initializer list
+#endif                                                                                                       
+                                                                                                             
+    basic_immutable_string insert(size_type pos, basic_immutable_string const &str)                          &&;       // immutable string
+    basic_immutable_string insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str)          &&;       // string
+    basic_immutable_string insert(size_type pos, basic_immutable_string const &str,                                    // substring (immutable source)
+                                  size_type subpos, size_type sublen)                                        &&;       // substring
+    basic_immutable_string insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str,         
+                                  size_type subpos, size_type sublen)                                        &&;       // substring
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type insert(size_type pos, T s)          &&;       // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  insert(size_type pos, T (&s)[N])     && { return std::move(*this).insert(pos, s, detail::literal_length<Traits>(s)); } // literal
+    basic_immutable_string insert(size_type pos, Char const *s, size_type n)                                 &&;       // buffer
+    basic_immutable_string insert(size_type pos,   size_type n, Char c)                                      &&;       // fill
+    basic_immutable_string insert(const_iterator p, size_type n, Char c)                                     &&;       // fill
+    basic_immutable_string insert(const_iterator p, Char c)                                                  &&;       // single character
+    template<typename InputIterator>                                                                           
+    basic_immutable_string insert(const_iterator p, InputIterator first, InputIterator last)                 &&;       // range
+#if HAS_INITIALIZER_LIST                                                                                     
+    basic_immutable_string insert(const_iterator p, std::initializer_list<Char> il)                          &&;       // initializer list
 #endif                                                                                                       
                                                                                                              
+    basic_immutable_string erase(size_type pos=0, size_type len=npos)                                        &&;       // sequence
+    basic_immutable_string erase(const_iterator p)                                                           &&;       // character
+    basic_immutable_string erase(const_iterator first, const_iterator last)                                  &&;       // range
+                                                                                                             
+                                                                                                             
+    basic_immutable_string replace(size_type pos, size_type len, basic_immutable_string const &str)          &&;       // string
+    basic_immutable_string replace(size_type pos, size_type len,                                             
+                                   std::basic_string<Char, Traits, Alloc> const &str)                        &&;       // string
+    basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
+                                   basic_immutable_string const &str)                                        &&;       // string
+    basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
+                                   std::basic_string<Char, Traits, Alloc> const &str)                        &&;       // string
+                                                                                                             
+    basic_immutable_string replace(size_type pos, size_type len,                                             
+                                   basic_immutable_string const &str,                                        
+                                   size_type subpos, size_type sublen)                                       &&;       // substring
+    basic_immutable_string replace(size_type pos, size_type len,                                             
+                                   std::basic_string<Char, Traits, Alloc> const &str,                       
+                                   size_type subpos, size_type sublen)                                       &&;       // substring
+                                                                                                             
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type replace(size_type pos, size_type len, T s) &&; // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  replace(size_type pos, size_type len, T (&s)[N]) && { return std::move(*this).replace(pos, len, s, detail::literal_length<Traits>(s)); } // literal
+    template<typename T>
+    typename detail::if_c_string<T, Char, basic_immutable_string>::type replace(const_iterator i1, const_iterator i2, T s) &&; // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, basic_immutable_string>::type  replace(const_iterator i1, const_iterator i2, T (&s)[N]) && { return std::move(*this).replace(i1, i2, s, detail::literal_length<Traits>(s)); } // literal
+                                                                                                              
+    basic_immutable_string replace(size_type pos,     size_type len,     Char const *s, size_type n)         &&;       // buffer
+    basic_immutable_string replace(const_iterator i1, const_iterator i2, Char const *s, size_type n)         &&;       // buffer
+                                                                                                              
+    basic_immutable_string replace(size_type pos,     size_type len,     size_type n, Char c)                &&;       // fill
+    basic_immutable_string replace(const_iterator i1, const_iterator i2, size_type n, Char c)                &&;       // fill
+                                                                                                             
+    template<typename InputIterator>                                                                           
+    basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
+                                   InputIterator first, InputIterator last)                                  &&;       // range
+                                                                                                             
+#if HAS_INITIALIZER_LIST                                                                                     
+    basic_immutable_string replace(const_iterator i1, const_iterator i2,                                     
+                                   std::initializer_list<Char> il)                                           &&;       // initializer list
+#endif
+#endif
+
+    // replace every non-overlapping occurrence, scanning left to right; the
+    // result is sized before it is built, so it is allocated exactly once
+    basic_immutable_string replace_all(basic_immutable_string const &from,
+                                       basic_immutable_string const &to)                                     const;    // string
+    basic_immutable_string replace_all(std::basic_string<Char, Traits, Alloc> const &from,
+                                       std::basic_string<Char, Traits, Alloc> const &to)                     const;    // string
+    basic_immutable_string replace_all(Char const *from, Char const *to)                                     const;    // c-string
+    basic_immutable_string replace_all(Char const *from, size_type from_len,
+                                       Char const *to,   size_type to_len)                                   const;    // buffer
+    basic_immutable_string replace_all(Char from, Char to)                                                   const;    // character
+    template<typename Substitutions>
+    basic_immutable_string replace_all(Substitutions const &substitutions)                                   const;    // table of (from, to) pairs
+#if HAS_INITIALIZER_LIST
+    basic_immutable_string replace_all(std::initializer_list<std::pair<basic_immutable_string,
+                                                                       basic_immutable_string>> il)          const;    // initializer list of pairs
+#endif
+
+    // ASCII case conversion; all other characters are copied unchanged
+    basic_immutable_string to_lower(void)                                                                    const;
+    basic_immutable_string to_upper(void)                                                                    const;
+
+    // remove leading and/or trailing white space (space, \t, \n, \v, \f and \r)
+    basic_immutable_string trim(void)                                                                        const;
+    basic_immutable_string ltrim(void)                                                                       const;
+    basic_immutable_string rtrim(void)                                                                       const;
+
+    // numeric conversion without a std::basic_string, a stream or a locale.
+    // from() formats integers as std::to_string() does, and floating point
+    // values with the fewest significant digits that read back exactly. the
+    // parsers read the characters in place and accept what std::stoi() and
+    // its relatives accept, storing the number of characters used in *idx,
+    // and throw std::invalid_argument if there is no number and
+    // std::out_of_range if it does not fit
+    template<typename T>
+    static typename detail::if_number<T, basic_immutable_string>::type
+                                  from(T value, allocator_type const &alloc = allocator_type());
+    int                const to_int(size_type *idx=nullptr, int base=10)                                     const;
+    long               const to_long(size_type *idx=nullptr, int base=10)                                    const;
+    long long          const to_long_long(size_type *idx=nullptr, int base=10)                               const;
+    unsigned long      const to_unsigned_long(size_type *idx=nullptr, int base=10)                           const;
+    unsigned long long const to_unsigned_long_long(size_type *idx=nullptr, int base=10)                      const;
+    float              const to_float(size_type *idx=nullptr)                                                const;
+    double             const to_double(size_type *idx=nullptr)                                               const;
+    long double        const to_long_double(size_type *idx=nullptr)                                          const;
+
     Char const *                     const c_str(void)                                                       const noexcept { return string_.c_str();         }
     Char const *                     const data(void)                                                        const noexcept { return string_.data();          }
-    std::basic_string<Char, Traits, Alloc> mutable_string(void)                                              const          { return string_;                 }
+    std::basic_string<Char, Traits, Alloc> mutable_string(void)                                              CONST_LVALUE   { return string_;                 }
+#if HAS_REF_QUALIFIERS
+    std::basic_string<Char, Traits, Alloc> mutable_string(void)                                              &&             { return release();               }
+#endif
     allocator_type                         get_allocator(void)                                               const noexcept { return string_.get_allocator(); }
     size_type                        const copy(Char* s, size_type len, size_type pos)                       const          { return string_.copy(s,len,pos); }
 
+    // Unicode properties are computed on first use and cached. the encoding
+    // is UTF-8, UTF-16 or UTF-32 according to the size of Char
+    bool      const is_valid_utf(void)                                                                       const noexcept;
+    bool      const is_ascii(void)                                                                           const noexcept;
+    size_type const code_points(void)                                                                        const noexcept;    // npos if not valid
+
+    // the first characters packed into an integer that orders as the string
+    // does, for character types whose Traits order by value. it is computed
+    // on first use and cached, and lets operator< and sort() order most
+    // strings without reading their characters. zero for other types
+    std::uint64_t const prefix_key(void)                                                                     const noexcept;
+
+    // the hash used by std::hash, computed on first use and cached. for
+    // std::char_traits it is equal to hash_literal() of a literal with the
+    // same value
+    std::size_t   const hash(void)                                                                           const noexcept;
+
+    // the key that std::collate<Char>::transform() makes of the string under
+    // a locale, computed on first use for each locale and cached, so that
+    // ordering strings by comparing keys costs what comparing the characters
+    // does rather than a call to std::collate<Char>::compare(). a locale is
+    // recognized by its collate facet, which copies of it share, or by its
+    // name. Char must be char or wchar_t
+    std::basic_string<Char> const &collation_key(std::locale const &loc=std::locale())                     const;
+
     size_type const find(basic_immutable_string const &str, size_type pos=0)                                 const noexcept;    // string
     size_type const find(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=0)                 const noexcept;    // string
-    size_type const find(Char const *s, size_type pos=0)                                                     const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type find(T s, size_type pos=0)                 const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  find(T (&s)[N], size_type pos=0)            const          { return find(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const find(Char const *s, size_type pos, size_type n)                                          const;             // buffer
     size_type const find(Char c, size_type pos=0)                                                            const noexcept;    // character
                                                                                                              
     size_type const rfind(basic_immutable_string const &str, size_type pos=npos)                             const;             // string
     size_type const rfind(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=npos)             const;             // string
-    size_type const rfind(Char const *s, size_type pos=npos)                                                 const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type rfind(T s, size_type pos=npos)             const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  rfind(T (&s)[N], size_type pos=npos)        const          { return rfind(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const rfind(Char const *s, size_type pos, size_type n)                                         const;             // buffer
     size_type const rfind(Char c, size_type pos=npos)                                                        const;             // character
                                                                                                              
     size_type const find_first_of(basic_immutable_string const &str, size_type pos=0)                        const noexcept;    // string
     size_type const find_first_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=0)        const noexcept;    // string
-    size_type const find_first_of(Char const *s, size_type pos=0)                                            const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type find_first_of(T s, size_type pos=0)        const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  find_first_of(T (&s)[N], size_type pos=0)   const          { return find_first_of(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const find_first_of(Char const *s, size_type pos, size_type n)                                 const;             // buffer
     size_type const find_first_of(Char c, size_type pos=0)                                                   const noexcept;    // character
                                                                                                              
     size_type const find_last_of(basic_immutable_string const &str, size_type pos=npos)                      const noexcept;    // string
     size_type const find_last_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=npos)      const noexcept;    // string
-    size_type const find_last_of(Char const *s, size_type pos=npos)                                          const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type find_last_of(T s, size_type pos=npos)      const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  find_last_of(T (&s)[N], size_type pos=npos) const          { return find_last_of(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const find_last_of(Char const *s, size_type pos, size_type n)                                  const;             // buffer
     size_type const find_last_of(Char c, size_type pos=npos)                                                 const noexcept;    // character
                                                                                                              
     size_type const find_first_not_of(basic_immutable_string const &str, size_type pos=0)                    const noexcept;    // string
     size_type const find_first_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=0)    const noexcept;    // string
-    size_type const find_first_not_of(Char const *s, size_type pos=0)                                        const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type find_first_not_of(T s, size_type pos=0)    const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  find_first_not_of(T (&s)[N], size_type pos=0) const          { return find_first_not_of(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const find_first_not_of(Char const *s, size_type pos, size_type n)                             const;             // buffer
     size_type const find_first_not_of(Char c, size_type pos=0)                                               const noexcept;    // character
 
     size_type const find_last_not_of(basic_immutable_string const &str, size_type pos=npos)                  const noexcept;    // string
     size_type const find_last_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos=npos)  const noexcept;    // string
-    size_type const find_last_not_of(Char const *s, size_type pos=npos)                                      const;             // c-string
+    template<typename T>
+    typename detail::if_c_string<T, Char, size_type const>::type find_last_not_of(T s, size_type pos=npos)  const;             // c-string
+    template<typename T, std::size_t N>
+    typename detail::if_literal<T, Char, size_type const>::type  find_last_not_of(T (&s)[N], size_type pos=npos) const          { return find_last_not_of(s, pos, detail::literal_length<Traits>(s)); } // literal
     size_type const find_last_not_of(Char const *s, size_type pos, size_type n)                              const;             // buffer
     size_type const find_last_not_of(Char c, size_type pos=npos)                                             const noexcept;    // character
 
   private:
+    basic_immutable_string substitute(detail::substitution<Char> *first, detail::substitution<Char> *last) const;
+    std::uint64_t const utf_metadata(void) const noexcept;
+
+    // moves the value out of a string that is about to be destroyed
+    std::basic_string<Char, Traits, Alloc> release(void) noexcept
+    {
+        meta_.utf.store(0, std::memory_order_relaxed);
+        meta_.drop_collation();
+        IMMUTABLE_STRING_RECORD_ADOPTION(heap_bytes()? string_.data() : nullptr);
+        return std::move(string_);
+    }
+
+    // whether characters that a modifier of a temporary is still to read lie
+    // within the value, which release() would take from under them
+    bool const is_inside(Char const *s) const noexcept
+    {
+        std::less_equal<Char const *> const before;
+        return before(data(), s)  &&  before(s, data() + size());
+    }
+
+    template<typename InputIterator>
+    bool const is_inside(InputIterator first, InputIterator last) const noexcept
+    {
+        return is_inside(first, last, detail::refers_to_chars<InputIterator, Char>());
+    }
+
+    template<typename InputIterator>
+    bool const is_inside(InputIterator first, InputIterator last, std::true_type) const noexcept { return first != last  &&  is_inside(&*first); }
+    template<typename InputIterator>
+    bool const is_inside(InputIterator, InputIterator, std::false_type)          const noexcept { return false; }
+
+    // the bytes of the buffer, or zero if the string is held within the object
+    std::size_t const heap_bytes(void) const noexcept
+    {
+        char const *const buffer = reinterpret_cast<char const *>(string_.data());
+        char const *const object = reinterpret_cast<char const *>(&string_);
+        return (buffer >= object  &&  buffer < object + sizeof(string_))? 0 : (string_.capacity() + 1) * sizeof(Char);
+    }
+
+#ifdef IMMUTABLE_STRING_STATISTICS
+    void record_statistics(statistics::operation op, bool moved=false) const
+    {
+        statistics::detail::record_allocation(op, heap_bytes(), string_.size() * sizeof(Char), moved, string_.data());
+    }
+#endif
+
     // the encapsulated string is not declared const as this would
     // prevent the object being moved, which may be important in
     // some situations for performance
     std::basic_string<Char, Traits, Alloc> string_;
+    detail::string_metadata                meta_;
 
 #if defined(_MSC_VER)  &&  _MSC_VER < 1800
     // private assignment operator prevents compiler generator function
@@ -282,11 +799,93 @@ class basic_immutable_string
 #endif
 };
 
+// character traits that compare ASCII letters without regard to case, for
+// use as the Traits parameter of basic_immutable_string
+template<typename Char>
+struct ci_char_traits : std::char_traits<Char>
+{
+    typedef Char char_type;
+
+    static Char       const  fold(Char c)                                                                          noexcept;
+    static bool       const  eq(Char c1, Char c2)                                                                  noexcept;
+    static bool       const  lt(Char c1, Char c2)                                                                  noexcept;
+    static int        const  compare(Char const *s1, Char const *s2, std::size_t n);
+    static Char const *const find(Char const *s, std::size_t n, Char const &c);
+};
+
+#if HAS_CONSTEXPR
+// the hash of a string literal as a constant expression, equal to hash() of
+// an immutable string with the same value, for use as a case label:
+//
+//     switch (command.hash())
+//     {
+//         case hash_literal("get"):  if (command == "get") ...
+//
+template<typename Char, std::size_t N>
+constexpr std::size_t hash_literal(Char const (&s)[N]) noexcept;
+
+namespace literals {
+
+// "get"_hash is hash_literal("get")
+constexpr std::size_t operator""_hash(char const *s, std::size_t n) noexcept;
+constexpr std::size_t operator""_hash(wchar_t const *s, std::size_t n) noexcept;
+constexpr std::size_t operator""_hash(char16_t const *s, std::size_t n) noexcept;
+constexpr std::size_t operator""_hash(char32_t const *s, std::size_t n) noexcept;
+
+}   // namespace literals
+#endif
+
 typedef basic_immutable_string<char>     immutable_string;
 typedef basic_immutable_string<wchar_t>  immutable_wstring;
 typedef basic_immutable_string<char16_t> immutable_u16string;
 typedef basic_immutable_string<char32_t> immutable_u32string;
 
+typedef basic_immutable_string<char,    ci_char_traits<char>>    ci_immutable_string;
+typedef basic_immutable_string<wchar_t, ci_char_traits<wchar_t>> ci_immutable_wstring;
+
+// orders strings as std::collate<Char>::compare() does under a locale, by
+// comparing the collation keys that they cache, for ordered containers and
+// for sorts, including sort_strings():
+//
+//     std::set<immutable_string, collate_less> names(collate_less(std::locale("")));
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_collate_less
+{
+  public:
+    explicit basic_collate_less(std::locale const &loc=std::locale()) : locale_(loc)                          { }
+
+    bool const operator()(basic_immutable_string<Char, Traits, Alloc> const &lhs,
+                          basic_immutable_string<Char, Traits, Alloc> const &rhs)                          const
+    {
+        return lhs.collation_key(locale_).compare(rhs.collation_key(locale_)) < 0;
+    }
+
+    std::locale const &locale(void)                                                                          const noexcept { return locale_; }
+
+  private:
+    std::locale locale_;
+};
+
+typedef basic_collate_less<char>    collate_less;
+typedef basic_collate_less<wchar_t> wcollate_less;
+
+// walks a range of strings and totals the memory that they use, counting
+// storage shared between strings only once
+template<typename InputIterator>
+memory_usage const measure_memory(InputIterator first, InputIterator last);
+
+// transcoding between the Unicode typedefs. the source is validated (and the
+// result cached) first, so each result is built in a single allocation of
+// exactly the right size. invalid input throws std::range_error
+template<typename Traits, typename Alloc> immutable_string    to_utf8(basic_immutable_string<char16_t, Traits, Alloc> const &str);
+template<typename Traits, typename Alloc> immutable_string    to_utf8(basic_immutable_string<char32_t, Traits, Alloc> const &str);
+template<typename Traits, typename Alloc> immutable_u16string to_utf16(basic_immutable_string<char, Traits, Alloc> const &str);
+template<typename Traits, typename Alloc> immutable_u16string to_utf16(basic_immutable_string<char32_t, Traits, Alloc> const &str);
+template<typename Traits, typename Alloc> immutable_u32string to_utf32(basic_immutable_string<char, Traits, Alloc> const &str);
+template<typename Traits, typename Alloc> immutable_u32string to_utf32(basic_immutable_string<char16_t, Traits, Alloc> const &str);
+
 }   // namespace cdmh
 
 #include "immutable_string.inl"
@@ -21,6 +21,24 @@
 
 namespace cdmh {
 
+namespace detail {
+
+// orders two strings by their prefix keys where they differ, which needs
+// neither string's characters once the keys are cached
+template<typename Char, typename Traits, typename Alloc>
+int const compare_ordered(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    if (prefix_key<Char, Traits>::enabled)
+    {
+        std::uint64_t const lhs_key = lhs.prefix_key();
+        std::uint64_t const rhs_key = rhs.prefix_key();
+        if (lhs_key != rhs_key)
+            return (lhs_key < rhs_key)? -1 : 1;
+    }
+    return lhs.compare(rhs);
+}
+
+}   // namespace detail
+
 // comparison with another string instance
 template<typename Char, typename Traits, typename Alloc>
 bool operator==(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
@@ -34,22 +52,22 @@ bool operator!=(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_im
 
 template<typename Char, typename Traits, typename Alloc>
 bool operator<(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
-    return lhs.compare(rhs) < 0;
+    return detail::compare_ordered(lhs, rhs) < 0;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 bool operator<=(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
-    return lhs.compare(rhs) <= 0;
+    return detail::compare_ordered(lhs, rhs) <= 0;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 bool operator>(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
-    return lhs.compare(rhs) > 0;
+    return detail::compare_ordered(lhs, rhs) > 0;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 bool operator>=(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
-    return lhs.compare(rhs) >= 0;
+    return detail::compare_ordered(lhs, rhs) >= 0;
 }
 
 
@@ -116,206 +134,290 @@ bool operator>=(std::basic_string<Char, Traits, Alloc> const &lhs, basic_immutab
 
 
 
-// comparison to Char*
-template<typename Char, typename Traits, typename Alloc>
-bool operator==(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+// comparison to Char*, as a template so that string literals use the
+// overloads below
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator==(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return rhs.compare(lhs) == 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator==(basic_immutable_string<Char, Traits, Alloc> const &lhs, Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator==(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
     return lhs.compare(rhs) == 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator!=(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator!=(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return !(rhs == lhs);
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator!=(basic_immutable_string<Char, Traits, Alloc> const &lhs, Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator!=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
     return !(lhs == rhs);
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator<(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator<(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return rhs.compare(lhs) > 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator<(basic_immutable_string<Char, Traits, Alloc> const &lhs,  Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator<(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
     return lhs.compare(rhs) < 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator<=(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator<=(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return rhs.compare(lhs) >= 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator<=(basic_immutable_string<Char, Traits, Alloc> const &lhs, Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator<=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
     return lhs.compare(rhs) <= 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator>(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator>(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return rhs.compare(lhs) < 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator>(basic_immutable_string<Char, Traits, Alloc> const &lhs, Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator>(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
     return lhs.compare(rhs) > 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator>=(Char const * const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator>=(T const lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs) {
     return rhs.compare(lhs) <= 0;
 }
 
 
-template<typename Char, typename Traits, typename Alloc>
-bool operator>=(basic_immutable_string<Char, Traits, Alloc> const &lhs, Char const * const rhs) {
+template<typename Char, typename Traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, bool>::type operator>=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T const rhs) {
+    return lhs.compare(rhs) >= 0;
+}
+
+
+// comparison to string literals, whose length is known
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator==(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    std::size_t const length = detail::literal_length<Traits>(lhs);
+    return rhs.size() == length  &&  Traits::compare(rhs.data(), lhs, length) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator==(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
+    return rhs == lhs;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator!=(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator!=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
+    return !(rhs == lhs);
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator<(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    return rhs.compare(lhs) > 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator<(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
+    return lhs.compare(rhs) < 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator<=(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    return rhs.compare(lhs) >= 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator<=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
+    return lhs.compare(rhs) <= 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator>(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    return rhs.compare(lhs) < 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator>(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
+    return lhs.compare(rhs) > 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator>=(T (&lhs)[N], basic_immutable_string<Char, Traits, Alloc> const &rhs) {
+    return rhs.compare(lhs) <= 0;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, bool>::type operator>=(basic_immutable_string<Char, Traits, Alloc> const &lhs, T (&rhs)[N]) {
     return lhs.compare(rhs) >= 0;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str) const
+basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + str.string_;     // ctor 10.2
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str) const
+basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + str;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str, size_type subpos, size_type sublen) const
+basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str, size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + str.string_.substr(subpos, sublen);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str, size_type subpos, size_type sublen) const
+basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str, size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + str.substr(subpos, sublen);
 }
 
 template<typename Char, typename Traits, typename Alloc>
-basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(Char const * const s) const
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::append(T s) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return std::basic_string<Char, Traits, Alloc>(string_ + s);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(Char const * const s, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>::append(Char const * const s, size_type n) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + std::basic_string<Char, Traits, Alloc>(s, n);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(size_type n, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::append(size_type n, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + std::basic_string<Char, Traits, Alloc>(n, c);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(Char c) const
+basic_immutable_string<Char, Traits, Alloc>::append(Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + c;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 template<typename InputIterator>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(InputIterator first, InputIterator last) const
+basic_immutable_string<Char, Traits, Alloc>::append(InputIterator first, InputIterator last) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + std::basic_string<Char, Traits, Alloc>(first, last);
 }
 
 #if HAS_INITIALIZER_LIST
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::append(std::initializer_list<Char> il) const
+basic_immutable_string<Char, Traits, Alloc>::append(std::initializer_list<Char> il) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(append);
     return string_ + std::basic_string<Char, Traits, Alloc>(il);
 }
 #endif
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, basic_immutable_string<Char, Traits, Alloc> const &str) const
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, basic_immutable_string<Char, Traits, Alloc> const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, str.string_);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str) const
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, str);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
 basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, basic_immutable_string<Char, Traits, Alloc> const &str,
-                                                     size_type subpos, size_type sublen) const
+                                                     size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, str.string_, subpos, sublen);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
 basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str,
-                                                     size_type subpos, size_type sublen) const
+                                                     size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, str, subpos, sublen);
 }
 
 template<typename Char, typename Traits, typename Alloc>
-basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, Char const *s) const
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, T s) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, s);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, Char const *s, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, Char const *s, size_type n) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, s, n);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, size_type n, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, size_type n, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     return std::basic_string<Char, Traits, Alloc>(string_).insert(pos, n, c);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, size_type n, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, size_type n, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.insert(str.begin() + std::distance(cbegin(),p), n, c);
     return str;
@@ -323,8 +425,9 @@ basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, size_type
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.insert(str.begin() + std::distance(cbegin(),p), c);
     return str;
@@ -333,8 +436,9 @@ basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, Char c) co
 template<typename Char, typename Traits, typename Alloc>
 template<typename InputIterator>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, InputIterator first, InputIterator last) const
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, InputIterator first, InputIterator last) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.insert(str.begin() + std::distance(cbegin(),p), first, last);
     return str;
@@ -343,8 +447,9 @@ basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, InputItera
 #if HAS_INITIALIZER_LIST
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, std::initializer_list<Char> il) const
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, std::initializer_list<Char> il) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(insert);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.insert(str.begin() + std::distance(cbegin(),p), il);
     return str;
@@ -353,15 +458,17 @@ basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, std::initi
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::erase(size_type pos, size_type len) const
+basic_immutable_string<Char, Traits, Alloc>::erase(size_type pos, size_type len) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(erase);
     return std::basic_string<Char, Traits, Alloc>(string_).erase(pos,len);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator p) const
+basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator p) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(erase);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.erase(str.begin() + std::distance(cbegin(),p));
     return str;
@@ -369,8 +476,9 @@ basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator p) const
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator first, const_iterator last) const
+basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator first, const_iterator last) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(erase);
     std::basic_string<Char, Traits, Alloc> str(string_);
     str.erase(str.begin() + std::distance(cbegin(),first), str.begin() + std::distance(cbegin(), last));
     return str;
@@ -378,22 +486,25 @@ basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator first, const_i
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, basic_immutable_string const &str) const
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, basic_immutable_string const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos,len,str.string_);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, std::basic_string<Char, Traits, Alloc> const &str) const
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, std::basic_string<Char, Traits, Alloc> const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos,len,str);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, basic_immutable_string const &str) const
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, basic_immutable_string const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return 
         newstr.replace(
@@ -404,8 +515,9 @@ basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_it
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::basic_string<Char, Traits, Alloc> const &str) const
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::basic_string<Char, Traits, Alloc> const &str) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return
         newstr.replace(
@@ -418,8 +530,9 @@ template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
 basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len,
                                                       basic_immutable_string const &str,
-                                                      size_type subpos, size_type sublen) const
+                                                      size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos, len, str.string_, subpos, sublen);
 }
 
@@ -427,22 +540,27 @@ template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
 basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len,
                                                       std::basic_string<Char, Traits, Alloc> const &str,
-                                                      size_type subpos, size_type sublen) const
+                                                      size_type subpos, size_type sublen) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos, len, str, subpos, sublen);
 }
 
 template<typename Char, typename Traits, typename Alloc>
-basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, Char const *s) const
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, T s) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos, len, s);
 }
 
 template<typename Char, typename Traits, typename Alloc>
-basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, Char const *s) const
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, T s) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return 
         newstr.replace(
@@ -453,15 +571,17 @@ basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_it
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, Char const *s, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, Char const *s, size_type n) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos, len, s, n);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, Char const *s, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, Char const *s, size_type n) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return
         newstr.replace(
@@ -472,15 +592,17 @@ basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_it
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, size_type n, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, size_type n, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     return std::basic_string<Char, Traits, Alloc>(string_).replace(pos, len, n, c);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, size_type n, Char c) const
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, size_type n, Char c) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return 
         newstr.replace(
@@ -493,8 +615,9 @@ template<typename Char, typename Traits, typename Alloc>
 template<typename InputIterator>
 basic_immutable_string<Char, Traits, Alloc>
 basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2,
-                                                      InputIterator first, InputIterator last) const
+                                                      InputIterator first, InputIterator last) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return 
         newstr.replace(
@@ -506,8 +629,9 @@ basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_it
 #if HAS_INITIALIZER_LIST
 template<typename Char, typename Traits, typename Alloc>
 basic_immutable_string<Char, Traits, Alloc>
-basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::initializer_list<Char> il)  const
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::initializer_list<Char> il) CONST_LVALUE
 {
+    IMMUTABLE_STRING_OPERATION(replace);
     std::basic_string<Char, Traits, Alloc> newstr(string_);
     return 
         newstr.replace(
@@ -517,328 +641,1921 @@ basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_it
 }
 #endif
 
-
+#if HAS_REF_QUALIFIERS
+/*
+  modifiers of temporaries, which take over the buffer of the string rather
+  than copying it. a string argument may be the object itself, and a
+  character pointer or iterator may point into its value, which would be
+  emptied by taking it over, in which case the value is copied as usual
+*/
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find(basic_immutable_string const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str) &&
 {
-    return string_.find(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).append(str);
+    return std::move(release().append(str.string_));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str) &&
 {
-    return string_.find(str, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    return std::move(release().append(str));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(basic_immutable_string const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find(s, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).append(str, subpos, sublen);
+    return std::move(release().append(str.string_, subpos, sublen));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find(Char const *s, size_type pos, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(std::basic_string<Char, Traits, Alloc> const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(append);
+    return std::move(release().append(str, subpos, sublen));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find(Char c, size_type pos) const noexcept
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::append(T s) &&
 {
-    return string_.find(c, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).append(s);
+    return std::move(release().append(s));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::rfind(basic_immutable_string const &str, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(Char const * const s, size_type n) &&
 {
-    return string_.rfind(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).append(s, n);
+    return std::move(release().append(s, n));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::rfind(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(size_type n, Char c) &&
 {
-    return string_.rfind(str, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    return std::move(release().append(n, c));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::rfind(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(Char c) &&
 {
-    return string_.rfind(s, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    return std::move(release().append(1, c));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::rfind(Char const *s, size_type pos, size_type n) const
+template<typename InputIterator>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(InputIterator first, InputIterator last) &&
 {
-    return string_.rfind(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(append);
+    if (is_inside(first, last))
+        return static_cast<basic_immutable_string const &>(*this).append(first, last);
+    return std::move(release().append(first, last));
 }
 
+#if HAS_INITIALIZER_LIST
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::rfind(Char c, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::append(std::initializer_list<Char> il) &&
 {
-    return string_.rfind(c, pos);
+    IMMUTABLE_STRING_OPERATION(append);
+    return std::move(release().append(il));
 }
+#endif
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_of(basic_immutable_string const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, basic_immutable_string const &str) &&
 {
-    return string_.find_first_of(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).insert(pos, str);
+    return std::move(release().insert(pos, str.string_));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str) &&
 {
-    return string_.find_first_of(str, pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    return std::move(release().insert(pos, str));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_of(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, basic_immutable_string const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find_first_of(s, pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).insert(pos, str, subpos, sublen);
+    return std::move(release().insert(pos, str.string_, subpos, sublen));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_of(Char const *s, size_type pos, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, std::basic_string<Char, Traits, Alloc> const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find_first_of(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(insert);
+    return std::move(release().insert(pos, str, subpos, sublen));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_of(Char c, size_type pos) const noexcept
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, T s) &&
 {
-    return string_.find_first_of(c, pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).insert(pos, s);
+    return std::move(release().insert(pos, s));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_of(basic_immutable_string const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, Char const *s, size_type n) &&
 {
-    return string_.find_last_of(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).insert(pos, s, n);
+    return std::move(release().insert(pos, s, n));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(size_type pos, size_type n, Char c) &&
 {
-    return string_.find_last_of(str, pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    return std::move(release().insert(pos, n, c));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_of(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, size_type n, Char c) &&
 {
-    return string_.find_last_of(s, pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    size_type const pos = std::distance(cbegin(), p);
+    return std::move(release().insert(pos, n, c));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_of(Char const *s, size_type pos, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, Char c) &&
 {
-    return string_.find_last_of(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(insert);
+    size_type const pos = std::distance(cbegin(), p);
+    return std::move(release().insert(pos, 1, c));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_of(Char c, size_type pos) const noexcept
-{
-    return string_.find_last_of(c, pos);
+template<typename InputIterator>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, InputIterator first, InputIterator last) &&
+{
+    IMMUTABLE_STRING_OPERATION(insert);
+    if (is_inside(first, last))
+        return static_cast<basic_immutable_string const &>(*this).insert(p, first, last);
+    size_type const pos = std::distance(cbegin(), p);
+    std::basic_string<Char, Traits, Alloc> str(release());
+    str.insert(str.begin() + pos, first, last);
+    return str;
 }
 
+#if HAS_INITIALIZER_LIST
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(basic_immutable_string const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::insert(const_iterator p, std::initializer_list<Char> il) &&
 {
-    return string_.find_first_not_of(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(insert);
+    size_type const pos = std::distance(cbegin(), p);
+    std::basic_string<Char, Traits, Alloc> str(release());
+    str.insert(str.begin() + pos, il);
+    return str;
 }
+#endif
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::erase(size_type pos, size_type len) &&
 {
-    return string_.find_first_not_of(str, pos);
+    IMMUTABLE_STRING_OPERATION(erase);
+    return std::move(release().erase(pos, len));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator p) &&
 {
-    return string_.find_first_not_of(s, pos);
+    IMMUTABLE_STRING_OPERATION(erase);
+    size_type const pos = std::distance(cbegin(), p);
+    return std::move(release().erase(pos, 1));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char const *s, size_type pos, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::erase(const_iterator first, const_iterator last) &&
 {
-    return string_.find_first_not_of(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(erase);
+    size_type const pos = std::distance(cbegin(), first);
+    size_type const len = std::distance(first, last);
+    return std::move(release().erase(pos, len));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char c, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, basic_immutable_string const &str) &&
 {
-    return string_.find_first_not_of(c, pos);
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).replace(pos, len, str);
+    return std::move(release().replace(pos, len, str.string_));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(basic_immutable_string const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, std::basic_string<Char, Traits, Alloc> const &str) &&
 {
-    return string_.find_last_not_of(str.c_str(), pos);
+    IMMUTABLE_STRING_OPERATION(replace);
+    return std::move(release().replace(pos, len, str));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, basic_immutable_string const &str) &&
 {
-    return string_.find_last_not_of(str, pos);
+    IMMUTABLE_STRING_OPERATION(replace);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).replace(pos, len, str);
+    return std::move(release().replace(pos, len, str.string_));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char const *s, size_type pos) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::basic_string<Char, Traits, Alloc> const &str) &&
 {
-    return string_.find_last_not_of(s, pos);
+    IMMUTABLE_STRING_OPERATION(replace);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    return std::move(release().replace(pos, len, str));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char const *s, size_type pos, size_type n) const
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, basic_immutable_string const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find_last_not_of(s, pos, n);
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (&str == this)
+        return static_cast<basic_immutable_string const &>(*this).replace(pos, len, str, subpos, sublen);
+    return std::move(release().replace(pos, len, str.string_, subpos, sublen));
 }
 
 template<typename Char, typename Traits, typename Alloc>
-typename basic_immutable_string<Char, Traits, Alloc>::size_type const
-basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char c, size_type pos) const noexcept
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, std::basic_string<Char, Traits, Alloc> const &str, size_type subpos, size_type sublen) &&
 {
-    return string_.find_last_not_of(c, pos);
+    IMMUTABLE_STRING_OPERATION(replace);
+    return std::move(release().replace(pos, len, str, subpos, sublen));
 }
 
-/*
-  addition operators
-*/
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, T s) &&
 {
-    return lhs.append(std::forward<basic_immutable_string<Char, traits, Alloc>>(rhs));
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).replace(pos, len, s);
+    return std::move(release().replace(pos, len, s));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, std::basic_string<Char, traits, Alloc> &&rhs)
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, T s) &&
 {
-    return lhs.append(std::forward<std::basic_string<Char, traits, Alloc>>(rhs));
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).replace(i1, i2, s);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    return std::move(release().replace(pos, len, s));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(std::basic_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, Char const *s, size_type n) &&
 {
-    return lhs.append(rhs.c_str());
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).replace(pos, len, s, n);
+    return std::move(release().replace(pos, len, s, n));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, Char const *s, size_type n) &&
 {
-    return lhs.append(rhs);
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (is_inside(s))
+        return static_cast<basic_immutable_string const &>(*this).replace(i1, i2, s, n);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    return std::move(release().replace(pos, len, s, n));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, std::basic_string<Char, traits, Alloc> const &rhs)
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(size_type pos, size_type len, size_type n, Char c) &&
 {
-    return lhs.append(rhs);
+    IMMUTABLE_STRING_OPERATION(replace);
+    return std::move(release().replace(pos, len, n, c));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(std::basic_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, size_type n, Char c) &&
 {
-    return lhs + rhs.c_str();
+    IMMUTABLE_STRING_OPERATION(replace);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    return std::move(release().replace(pos, len, n, c));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
-{
-    return lhs.append(std::forward<basic_immutable_string<Char, traits, Alloc>>(rhs));
+template<typename Char, typename Traits, typename Alloc>
+template<typename InputIterator>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, InputIterator first, InputIterator last) &&
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    if (is_inside(first, last))
+        return static_cast<basic_immutable_string const &>(*this).replace(i1, i2, first, last);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    std::basic_string<Char, Traits, Alloc> str(release());
+    str.replace(str.begin() + pos, str.begin() + pos + len, first, last);
+    return str;
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, std::basic_string<Char, traits, Alloc> &&rhs)
+#if HAS_INITIALIZER_LIST
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace(const_iterator i1, const_iterator i2, std::initializer_list<Char> il) &&
 {
-    return lhs.append(std::forward<std::basic_string<Char, traits, Alloc>>(rhs));
+    IMMUTABLE_STRING_OPERATION(replace);
+    size_type const pos = std::distance(cbegin(), i1);
+    size_type const len = std::distance(i1, i2);
+    std::basic_string<Char, Traits, Alloc> str(release());
+    str.replace(str.begin() + pos, str.begin() + pos + len, il);
+    return str;
 }
+#endif
+#endif  // HAS_REF_QUALIFIERS
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(std::basic_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+namespace detail {
+
+// buffer and length of the strings that can appear in a substitution table
+template<typename Traits, typename Char, typename Alloc>
+std::pair<Char const *, std::size_t> string_buffer(basic_immutable_string<Char, Traits, Alloc> const &str)
 {
-    return lhs.append(rhs.c_str());
+    return std::make_pair(str.data(), str.size());
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+template<typename Traits, typename Char, typename Alloc>
+std::pair<Char const *, std::size_t> string_buffer(std::basic_string<Char, Traits, Alloc> const &str)
 {
-    return lhs.append(rhs);
+    return std::make_pair(str.data(), str.size());
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, std::basic_string<Char, traits, Alloc> const &rhs)
+template<typename Traits, typename Char>
+std::pair<Char const *, std::size_t> string_buffer(Char const *s)
 {
-    return lhs.append(rhs);
+    return std::make_pair(s, Traits::length(s));
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(std::basic_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+template<typename Traits, typename From, typename To>
+substitution<typename Traits::char_type> make_substitution(From const &from, To const &to)
 {
-    return lhs.append(rhs.c_str());
+    std::pair<typename Traits::char_type const *, std::size_t> const f = string_buffer<Traits>(from);
+    std::pair<typename Traits::char_type const *, std::size_t> const t = string_buffer<Traits>(to);
+    substitution<typename Traits::char_type> const result = { f.first, f.second, t.first, t.second };
+    return result;
 }
 
-template <typename Char, typename traits, typename Alloc>
-basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, Char const *rhs)
-{
+}   // namespace detail
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(basic_immutable_string const &from, basic_immutable_string const &to) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    return replace_all(from.data(), from.size(), to.data(), to.size());
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(std::basic_string<Char, Traits, Alloc> const &from,
+                                                          std::basic_string<Char, Traits, Alloc> const &to) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    return replace_all(from.data(), from.size(), to.data(), to.size());
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(Char const *from, Char const *to) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    return replace_all(from, Traits::length(from), to, Traits::length(to));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(Char const *from, size_type from_len,
+                                                          Char const *to,   size_type to_len) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    // an empty pattern would match everywhere; treat it as matching nowhere
+    if (from_len == 0)
+        return *this;
+
+    std::vector<size_type> positions;
+    for (size_type pos=string_.find(from, 0, from_len); pos != npos; pos=string_.find(from, pos + from_len, from_len))
+        positions.push_back(pos);
+    if (positions.empty())
+        return *this;
+
+    std::basic_string<Char, Traits, Alloc> result(get_allocator());
+    result.reserve(size() - positions.size() * from_len + positions.size() * to_len);
+
+    size_type prev = 0;
+    for (typename std::vector<size_type>::const_iterator it=positions.begin(); it != positions.end(); ++it)
+    {
+        result.append(data() + prev, *it - prev);
+        result.append(to, to_len);
+        prev = *it + from_len;
+    }
+    result.append(data() + prev, size() - prev);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(Char from, Char to) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    size_type pos = string_.find(from);
+    if (pos == npos)
+        return *this;
+
+    std::basic_string<Char, Traits, Alloc> result(string_);
+    for (; pos != result.size(); ++pos)
+    {
+        if (Traits::eq(result[pos], from))
+            result[pos] = to;
+    }
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename Substitutions>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(Substitutions const &substitutions) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    std::vector<detail::substitution<Char>> table;
+    for (auto it=std::begin(substitutions); it != std::end(substitutions); ++it)
+        table.push_back(detail::make_substitution<Traits>(it->first, it->second));
+    return substitute(table.data(), table.data() + table.size());
+}
+
+#if HAS_INITIALIZER_LIST
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::replace_all(std::initializer_list<std::pair<basic_immutable_string, basic_immutable_string>> il) const
+{
+    IMMUTABLE_STRING_OPERATION(replace);
+    std::vector<detail::substitution<Char>> table;
+    for (auto it=il.begin(); it != il.end(); ++it)
+        table.push_back(detail::make_substitution<Traits>(it->first, it->second));
+    return substitute(table.data(), table.data() + table.size());
+}
+#endif
+
+// single pass multi-pattern substitution. at each position the longest
+// matching pattern wins, and on equal lengths the earliest table entry wins
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::substitute(detail::substitution<Char> *first, detail::substitution<Char> *last) const
+{
+    typedef detail::substitution<Char> substitution;
+
+    last = std::remove_if(first, last, [](substitution const &s) { return s.from_len == 0; });
+    if (first == last  ||  empty())
+        return *this;
+
+    std::stable_sort(first, last, [](substitution const &lhs, substitution const &rhs) {
+        if (!Traits::eq(lhs.from[0], rhs.from[0]))
+            return Traits::lt(lhs.from[0], rhs.from[0]);
+        return lhs.from_len > rhs.from_len;
+    });
+
+    // the distinct initial characters are used to skip to the next candidate
+    std::basic_string<Char, Traits, Alloc> initials(get_allocator());
+    for (substitution const *it=first; it != last; ++it)
+    {
+        if (initials.empty()  ||  !Traits::eq(initials.back(), it->from[0]))
+            initials.push_back(it->from[0]);
+    }
+
+    std::vector<std::pair<size_type, substitution const *>> matches;
+    size_type length = size();
+    for (size_type pos=string_.find_first_of(initials); pos != npos; pos=string_.find_first_of(initials, pos))
+    {
+        substitution const *match = 0;
+        for (substitution const *it=std::lower_bound(first, last, string_[pos],
+                                                     [](substitution const &s, Char c) { return Traits::lt(s.from[0], c); });
+             it != last  &&  Traits::eq(it->from[0], string_[pos]);
+             ++it)
+        {
+            if (it->from_len <= size() - pos  &&  Traits::compare(data() + pos, it->from, it->from_len) == 0)
+            {
+                match = it;
+                break;
+            }
+        }
+
+        if (match)
+        {
+            matches.push_back(std::make_pair(pos, match));
+            length = length - match->from_len + match->to_len;
+            pos += match->from_len;
+        }
+        else
+            ++pos;
+    }
+    if (matches.empty())
+        return *this;
+
+    std::basic_string<Char, Traits, Alloc> result(get_allocator());
+    result.reserve(length);
+
+    size_type prev = 0;
+    for (auto it=matches.cbegin(); it != matches.cend(); ++it)
+    {
+        result.append(data() + prev, it->first - prev);
+        result.append(it->second->to, it->second->to_len);
+        prev = it->first + it->second->from_len;
+    }
+    result.append(data() + prev, size() - prev);
+    return result;
+}
+
+namespace detail {
+
+inline bool const is_space(unsigned long c) noexcept
+{
+    return c == ' '  ||  (c >= '\t'  &&  c <= '\r');
+}
+
+// ASCII letters in [first, first+26) have bit 0x20 flipped, which converts
+// A-Z to lower case when first is 'A', and a-z to upper case when first is 'a'
+template<typename Char>
+std::size_t const ascii_find_case(Char const *s, std::size_t n, char first) noexcept
+{
+    for (std::size_t i=0; i<n; ++i)
+    {
+        if (s[i] >= Char(first)  &&  s[i] < Char(first + 26))
+            return i;
+    }
+    return n;
+}
+
+template<typename Char>
+void ascii_flip_case(Char *s, std::size_t n, char first) noexcept
+{
+    for (std::size_t i=0; i<n; ++i)
+    {
+        if (s[i] >= Char(first)  &&  s[i] < Char(first + 26))
+            s[i] = Char(s[i] ^ 0x20);
+    }
+}
+
+#if HAS_SSE2
+// bytes in the range [first, first+26) map to [-128, -102) after adding the
+// bias, so a single signed comparison selects them
+inline __m128i const ascii_case_mask(__m128i v, char first) noexcept
+{
+    return _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - first))),
+                          _mm_set1_epi8(static_cast<char>(-128 + 26)));
+}
+
+inline std::size_t const ascii_find_case(char const *s, std::size_t n, char first) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        if (_mm_movemask_epi8(ascii_case_mask(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + i)), first)))
+            break;
+    }
+    return i + ascii_find_case<char>(s + i, n - i, first);
+}
+
+inline void ascii_flip_case(char *s, std::size_t n, char first) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(s + i),
+                         _mm_xor_si128(v, _mm_and_si128(ascii_case_mask(v, first), _mm_set1_epi8(0x20))));
+    }
+    ascii_flip_case<char>(s + i, n - i, first);
+}
+
+inline int const ascii_casecmp(char const *s1, char const *s2, std::size_t n) noexcept
+{
+    // the vector loop runs over whole blocks only, counted up front, so that
+    // GCC sees every 16 byte load is within the n characters being compared
+    char const *const end = s1 + n;
+    for (std::size_t blocks = n / 16; blocks != 0; --blocks, s1 += 16, s2 += 16)
+    {
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s1));
+        __m128i v2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s2));
+        v1 = _mm_xor_si128(v1, _mm_and_si128(ascii_case_mask(v1, 'A'), _mm_set1_epi8(0x20)));
+        v2 = _mm_xor_si128(v2, _mm_and_si128(ascii_case_mask(v2, 'A'), _mm_set1_epi8(0x20)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) != 0xffff)
+            break;  // the scalar loop below locates the difference
+    }
+    for (; s1 != end; ++s1, ++s2)
+    {
+        unsigned char const c1 = static_cast<unsigned char>(ci_char_traits<char>::fold(*s1));
+        unsigned char const c2 = static_cast<unsigned char>(ci_char_traits<char>::fold(*s2));
+        if (c1 != c2)
+            return (c1 < c2)? -1 : 1;
+    }
+    return 0;
+}
+#endif
+
+template<typename Char>
+int const ascii_casecmp(Char const *s1, Char const *s2, std::size_t n) noexcept
+{
+    for (std::size_t i=0; i<n; ++i)
+    {
+        Char const c1 = ci_char_traits<Char>::fold(s1[i]);
+        Char const c2 = ci_char_traits<Char>::fold(s2[i]);
+        if (!std::char_traits<Char>::eq(c1, c2))
+            return std::char_traits<Char>::lt(c1, c2)? -1 : 1;
+    }
+    return 0;
+}
+
+// FNV-1a over the code units of a string, least significant byte first
+template<std::size_t Bytes> struct fnv1a;
+template<> struct fnv1a<4> { static std::uint32_t const offset = 2166136261U;            static std::uint32_t const prime = 16777619U;        };
+template<> struct fnv1a<8> { static std::uint64_t const offset = 14695981039346656037ULL; static std::uint64_t const prime = 1099511628211ULL; };
+
+template<typename Char>
+std::size_t const fnv1a_step(std::size_t hash, Char c) noexcept
+{
+    typedef typename std::make_unsigned<Char>::type unsigned_type;
+    unsigned_type value = static_cast<unsigned_type>(c);
+    for (std::size_t i=0; i<sizeof(Char); ++i, value = static_cast<unsigned_type>(value >> 8))
+        hash = (hash ^ (value & 0xff)) * fnv1a<sizeof(std::size_t)>::prime;
+    return hash;
+}
+
+#if HAS_CONSTEXPR
+// fnv1a_step() as a constant expression
+template<typename Unsigned>
+constexpr std::size_t fnv1a_bytes(std::size_t hash, Unsigned value, std::size_t bytes) noexcept
+{
+    return (bytes == 0)? hash : fnv1a_bytes((hash ^ (value & 0xff)) * fnv1a<sizeof(std::size_t)>::prime, static_cast<Unsigned>(value >> 8), bytes - 1);
+}
+
+template<typename Char>
+constexpr std::size_t fnv1a_literal(Char const *s, std::size_t n, std::size_t hash) noexcept
+{
+    return (n == 0)? hash : fnv1a_literal(s + 1, n - 1, fnv1a_bytes(hash, static_cast<typename std::make_unsigned<Char>::type>(*s), sizeof(Char)));
+}
+
+// the number of characters before the first terminator among the first n,
+// as a constant expression, so that a literal hashes as literal_length()
+// measures it
+template<typename Char>
+constexpr std::size_t terminated_length(Char const *s, std::size_t n, std::size_t length = 0) noexcept
+{
+    return (length == n  ||  s[length] == Char())? length : terminated_length(s, n, length + 1);
+}
+#endif
+
+// hash of a string that is consistent with the equality of its Traits
+template<typename Traits>
+struct string_hash
+{
+    typedef typename Traits::char_type char_type;
+
+    static std::size_t const hash(char_type const *s, std::size_t n) noexcept
+    {
+        std::size_t hash = fnv1a<sizeof(std::size_t)>::offset;
+        for (std::size_t i=0; i<n; ++i)
+            hash = fnv1a_step(hash, s[i]);
+        return hash;
+    }
+};
+
+template<typename Char>
+struct string_hash<ci_char_traits<Char>>
+{
+    static std::size_t const hash(Char const *s, std::size_t n) noexcept
+    {
+        std::size_t hash = fnv1a<sizeof(std::size_t)>::offset;
+        for (std::size_t i=0; i<n; ++i)
+            hash = fnv1a_step(hash, ci_char_traits<Char>::fold(s[i]));
+        return hash;
+    }
+};
+
+}   // namespace detail
+
+#if HAS_CONSTEXPR
+template<typename Char, std::size_t N>
+constexpr std::size_t hash_literal(Char const (&s)[N]) noexcept
+{
+    return detail::fnv1a_literal(s, detail::terminated_length(s, N), detail::fnv1a<sizeof(std::size_t)>::offset);
+}
+
+namespace literals {
+
+constexpr std::size_t operator""_hash(char const *s, std::size_t n) noexcept     { return detail::fnv1a_literal(s, detail::terminated_length(s, n), detail::fnv1a<sizeof(std::size_t)>::offset); }
+constexpr std::size_t operator""_hash(wchar_t const *s, std::size_t n) noexcept  { return detail::fnv1a_literal(s, detail::terminated_length(s, n), detail::fnv1a<sizeof(std::size_t)>::offset); }
+constexpr std::size_t operator""_hash(char16_t const *s, std::size_t n) noexcept { return detail::fnv1a_literal(s, detail::terminated_length(s, n), detail::fnv1a<sizeof(std::size_t)>::offset); }
+constexpr std::size_t operator""_hash(char32_t const *s, std::size_t n) noexcept { return detail::fnv1a_literal(s, detail::terminated_length(s, n), detail::fnv1a<sizeof(std::size_t)>::offset); }
+
+}   // namespace literals
+#endif
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const basic_immutable_string<Char, Traits, Alloc>::hash(void) const noexcept
+{
+    if (meta_.utf.load(std::memory_order_acquire) & detail::string_metadata::hash_computed)
+        return static_cast<std::size_t>(meta_.hash.load(std::memory_order_relaxed));
+
+    std::size_t const hash = detail::string_hash<Traits>::hash(data(), size());
+    meta_.hash.store(hash, std::memory_order_relaxed);
+    meta_.utf.fetch_or(detail::string_metadata::hash_computed, std::memory_order_release);
+    return hash;
+}
+
+// threads that race to add a key for the same locale each add one, and the
+// first in the list is used from then on
+template<typename Char, typename Traits, typename Alloc>
+std::basic_string<Char> const &basic_immutable_string<Char, Traits, Alloc>::collation_key(std::locale const &loc) const
+{
+    typedef detail::collation_key_node<Char> node_type;
+
+    std::collate<Char> const &facet = std::use_facet<std::collate<Char>>(loc);
+    detail::collation_node *const head = meta_.collation.load(std::memory_order_acquire);
+    for (detail::collation_node *node=head; node; node=node->next)
+    {
+        if (static_cast<node_type *>(node)->facet == &facet)
+            return static_cast<node_type *>(node)->key;
+    }
+
+    std::string const name = loc.name();
+    if (name != "*")
+    {
+        for (detail::collation_node *node=head; node; node=node->next)
+        {
+            if (static_cast<node_type *>(node)->name == name)
+                return static_cast<node_type *>(node)->key;
+        }
+    }
+
+    std::unique_ptr<node_type> node(new node_type);
+    node->locale = loc;
+    node->facet  = &facet;
+    node->name   = name;
+    node->key    = facet.transform(data(), data() + size());
+    node->next   = head;
+    while (!meta_.collation.compare_exchange_weak(node->next, node.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+        ;
+    return node.release()->key;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::to_lower(void) const
+{
+    size_type const pos = detail::ascii_find_case(data(), size(), 'A');
+    if (pos == size())
+        return *this;
+
+    std::basic_string<Char, Traits, Alloc> result(string_);
+    detail::ascii_flip_case(&result[pos], size() - pos, 'A');
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::to_upper(void) const
+{
+    size_type const pos = detail::ascii_find_case(data(), size(), 'a');
+    if (pos == size())
+        return *this;
+
+    std::basic_string<Char, Traits, Alloc> result(string_);
+    detail::ascii_flip_case(&result[pos], size() - pos, 'a');
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::trim(void) const
+{
+    size_type first = 0;
+    size_type last  = size();
+    while (first != last  &&  detail::is_space(static_cast<unsigned long>(string_[first])))
+        ++first;
+    while (last != first  &&  detail::is_space(static_cast<unsigned long>(string_[last-1])))
+        --last;
+    if (first == 0  &&  last == size())
+        return *this;
+    return substr(first, last - first);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::ltrim(void) const
+{
+    size_type first = 0;
+    while (first != size()  &&  detail::is_space(static_cast<unsigned long>(string_[first])))
+        ++first;
+    if (first == 0)
+        return *this;
+    return substr(first);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string<Char, Traits, Alloc>
+basic_immutable_string<Char, Traits, Alloc>::rtrim(void) const
+{
+    size_type last = size();
+    while (last != 0  &&  detail::is_space(static_cast<unsigned long>(string_[last-1])))
+        --last;
+    if (last == size())
+        return *this;
+    return substr(0, last);
+}
+
+namespace detail {
+
+// integers are formatted two digits at a time, from the right
+inline char const *const digit_pairs(void) noexcept
+{
+    return "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+}
+
+template<typename T>
+bool const is_negative(T value, std::true_type /*signed*/)   noexcept { return value < T(); }
+template<typename T>
+bool const is_negative(T, std::false_type /*unsigned*/)      noexcept { return false;       }
+
+// write the digits of an integer ending at end, and return the first
+template<typename Char, typename T>
+Char *const format_number(T value, Char *end, std::true_type /*integral*/) noexcept
+{
+    typedef typename std::make_unsigned<T>::type unsigned_type;
+    bool const negative = is_negative(value, std::is_signed<T>());
+    unsigned long long n = negative? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(value)) : static_cast<unsigned_type>(value);
+
+    char const *const pairs = digit_pairs();
+    for (; n >= 100; n /= 100)
+    {
+        unsigned const pair = static_cast<unsigned>(n % 100) * 2;
+        *--end = Char(pairs[pair + 1]);
+        *--end = Char(pairs[pair]);
+    }
+    if (n >= 10)
+    {
+        *--end = Char(pairs[n * 2 + 1]);
+        *--end = Char(pairs[n * 2]);
+    }
+    else
+        *--end = Char('0' + n);
+
+    if (negative)
+        *--end = Char('-');
+    return end;
+}
+
+inline float       const read_floating(char const *s, char **end, float)       { return std::strtof(s, end);  }
+inline double      const read_floating(char const *s, char **end, double)      { return std::strtod(s, end);  }
+inline long double const read_floating(char const *s, char **end, long double) { return std::strtold(s, end); }
+
+// the largest power of ten that T holds exactly, and at most the largest
+// that an unsigned long long holds. 10^n is exact if 5^n fits in the
+// mantissa, and log10(2) / log10(5) is 0.43067...
+template<typename T>
+int const max_exact_power(void) noexcept
+{
+    return std::min(std::numeric_limits<T>::digits * 43067 / 100000, 19);
+}
+
+inline unsigned long long const power_of_ten(int n) noexcept
+{
+    unsigned long long power = 1;
+    while (n-- > 0)
+        power *= 10;
+    return power;
+}
+
+// the shortest decimal of a value that %g would print without an exponent
+// at digits10 precision, found without the C library. a decimal m / 10^k
+// with exact m and 10^k reads back as m divided by 10^k, rounded once, so
+// the value is compared with that quotient for increasing k. the first
+// match has the fewest digits, which are the digits that %g prints, as any
+// decimal of no more than digits10 digits survives a round trip. returns
+// nullptr for values that need more digits, or an exponent
+template<typename Char, typename T>
+Char *const format_decimal(T value, Char *end) noexcept
+{
+#if HAS_EXACT_FLOATING_ARITHMETIC
+    int                const digits = std::numeric_limits<T>::digits10;
+    unsigned long long const limit  = power_of_ten(digits);
+    bool               const negative  = std::signbit(value);
+    T                  const magnitude = negative? -value : value;
+    if (!(magnitude < static_cast<T>(limit))  ||  (magnitude != T()  &&  magnitude < static_cast<T>(0.0001L)))
+        return nullptr;
+
+    unsigned long long scale = 1;
+    for (int places=0; places<=std::min(digits + 4, max_exact_power<T>()); ++places, scale*=10)
+    {
+        T const scaled = magnitude * static_cast<T>(scale);
+        if (!(scaled < static_cast<T>(limit)))
+            break;
+
+        unsigned long long const mantissa = static_cast<unsigned long long>(scaled + T(0.5));
+        if (mantissa < limit  &&  static_cast<T>(mantissa) / static_cast<T>(scale) == magnitude)
+        {
+            unsigned long long fraction = mantissa % scale;
+            for (int place=0; place<places; ++place, fraction/=10)
+                *--end = Char('0' + fraction % 10);
+            if (places != 0)
+                *--end = Char('.');
+            end = format_number(mantissa / scale, end, std::true_type());
+            if (negative)
+                *--end = Char('-');
+            return end;
+        }
+    }
+#else
+    (void)value;
+    (void)end;
+#endif
+    return nullptr;
+}
+
+// the fewest significant digits that read back as the same value. most
+// values are formatted by format_decimal(); the others with increasing
+// precision from the number of digits that are always exact, using the C
+// library in its current locale. the decimal point, which depends on the
+// locale, is whatever is not part of a number in the "C" locale, and is
+// always written as '.'
+template<typename Char, typename T>
+Char *const format_number(T value, Char *end, std::false_type /*floating point*/)
+{
+    if (Char *const first = format_decimal(value, end))
+        return first;
+
+    char text[64];
+    int length = 0;
+    for (int precision=std::numeric_limits<T>::digits10; ; ++precision)
+    {
+        length = std::snprintf(text, sizeof(text), "%.*Lg", precision, static_cast<long double>(value));
+        if (precision >= std::numeric_limits<T>::max_digits10  ||  value != value  ||  read_floating(text, nullptr, T()) == value)
+            break;
+    }
+
+    bool in_point = false;
+    for (char const *c=text+length; c != text; )
+    {
+        --c;
+        bool const point = !std::strchr("0123456789+-eEinfaINFA", *c);
+        if (!point)
+            *--end = Char(*c);
+        else if (!in_point)
+            *--end = Char('.');
+        in_point = point;
+    }
+    return end;
+}
+
+inline unsigned const digit_value(unsigned long c) noexcept
+{
+    if (c >= '0'  &&  c <= '9')
+        return static_cast<unsigned>(c - '0');
+    else if (c >= 'a'  &&  c <= 'z')
+        return static_cast<unsigned>(c - 'a' + 10);
+    else if (c >= 'A'  &&  c <= 'Z')
+        return static_cast<unsigned>(c - 'A' + 10);
+    return 36;
+}
+
+// parse an integer as strtol() and strtoul() do, and check the range of the
+// result as std::stoi() and its relatives do. a minus sign negates an
+// unsigned result modulo its range
+template<typename T, typename Char>
+T const parse_integer(Char const *first, Char const *last, std::size_t &used, int base, char const *name)
+{
+    Char const *p = first;
+    while (p != last  &&  is_space(static_cast<unsigned long>(*p)))
+        ++p;
+
+    bool negative = false;
+    if (p != last  &&  (*p == Char('+')  ||  *p == Char('-')))
+        negative = (*p++ == Char('-'));
+
+    if ((base == 0  ||  base == 16)  &&  last - p >= 3  &&  *p == Char('0')  &&  (p[1] == Char('x')  ||  p[1] == Char('X'))
+    &&  digit_value(static_cast<unsigned long>(p[2])) < 16)
+    {
+        p += 2;
+        base = 16;
+    }
+    else if (base == 0)
+        base = (p != last  &&  *p == Char('0'))? 8 : 10;
+    if (base < 2  ||  base > 36)
+        throw std::invalid_argument(name);
+
+    Char const *const digits = p;
+    unsigned long long magnitude = 0;
+    bool overflow = false;
+    for (; p != last; ++p)
+    {
+        unsigned const digit = digit_value(static_cast<unsigned long>(*p));
+        if (digit >= static_cast<unsigned>(base))
+            break;
+        else if (magnitude > (std::numeric_limits<unsigned long long>::max() - digit) / static_cast<unsigned>(base))
+            overflow = true;
+        else
+            magnitude = magnitude * static_cast<unsigned>(base) + digit;
+    }
+    if (p == digits)
+        throw std::invalid_argument(name);
+
+    unsigned long long const limit = static_cast<unsigned long long>(std::numeric_limits<T>::max())
+                                   + ((std::is_signed<T>::value  &&  negative)? 1 : 0);
+    if (overflow  ||  magnitude > limit)
+        throw std::out_of_range(name);
+
+    used = static_cast<std::size_t>(p - first);
+    if (!negative  ||  magnitude == 0)
+        return static_cast<T>(magnitude);
+    return static_cast<T>(T(0) - static_cast<T>(magnitude - 1) - T(1));
+}
+
+inline bool const is_floating_character(unsigned long c) noexcept
+{
+    return digit_value(c) < 36  ||  c == '.'  ||  c == '+'  ||  c == '-'  ||  c == '('  ||  c == ')'  ||  c == '_';
+}
+
+inline bool const is_digit(unsigned long c) noexcept
+{
+    return c >= '0'  &&  c <= '9';
+}
+
+// parse a plain decimal, such as "-12.5e3", whose significant digits fit in
+// the mantissa of T and whose power of ten T holds exactly. the value is
+// then one multiplication or division of exact values, rounded once, as
+// strtod() rounds it. returns false, having set nothing, for any other
+// number, including one that is not decimal or has too many digits
+template<typename T, typename Char>
+bool const parse_decimal(Char const *first, Char const *last, std::size_t &used, T &value) noexcept
+{
+#if HAS_EXACT_FLOATING_ARITHMETIC
+    Char const *p = first;
+    while (p != last  &&  is_space(static_cast<unsigned long>(*p)))
+        ++p;
+
+    bool negative = false;
+    if (p != last  &&  (*p == Char('+')  ||  *p == Char('-')))
+        negative = (*p++ == Char('-'));
+    if (last - p >= 2  &&  *p == Char('0')  &&  (p[1] == Char('x')  ||  p[1] == Char('X')))
+        return false;   // hexadecimal
+
+    // leading zeros are not significant, and each digit after the point
+    // lowers the exponent
+    unsigned long long mantissa = 0;
+    int  digits   = 0;
+    int  exponent = 0;
+    bool any      = false;
+    for (bool fraction=false; p != last; ++p)
+    {
+        if (*p == Char('.')  &&  !fraction)
+        {
+            fraction = true;
+            continue;
+        }
+        else if (!is_digit(static_cast<unsigned long>(*p)))
+            break;
+
+        any = true;
+        exponent -= fraction? 1 : 0;
+        if (mantissa == 0  &&  *p == Char('0'))
+            continue;
+        else if (++digits > std::numeric_limits<unsigned long long>::digits10)
+            return false;
+        mantissa = mantissa * 10 + static_cast<unsigned>(*p - Char('0'));
+    }
+    if (!any)
+        return false;
+
+    // an exponent without digits is not part of the number
+    if (p != last  &&  (*p == Char('e')  ||  *p == Char('E')))
+    {
+        Char const *q = p + 1;
+        bool negative_exponent = false;
+        if (q != last  &&  (*q == Char('+')  ||  *q == Char('-')))
+            negative_exponent = (*q++ == Char('-'));
+        if (q != last  &&  is_digit(static_cast<unsigned long>(*q)))
+        {
+            int power = 0;
+            for (; q != last  &&  is_digit(static_cast<unsigned long>(*q)); ++q)
+                power = std::min(power * 10 + static_cast<int>(*q - Char('0')), 100000);
+            exponent += negative_exponent? -power : power;
+            p = q;
+        }
+    }
+
+    if (mantissa != 0)
+    {
+        // the mantissa is exact if it has no more bits than that of T
+        int const bits = std::min(std::numeric_limits<T>::digits, std::numeric_limits<unsigned long long>::digits);
+        if ((mantissa >> (bits - 1) >> 1) != 0)
+            return false;
+        else if (exponent < -max_exact_power<T>()  ||  exponent > max_exact_power<T>())
+            return false;
+    }
+
+    T const scale = static_cast<T>(power_of_ten((mantissa == 0)? 0 : (exponent < 0)? -exponent : exponent));
+    value = (exponent < 0)? static_cast<T>(mantissa) / scale : static_cast<T>(mantissa) * scale;
+    if (negative)
+        value = -value;
+    used = static_cast<std::size_t>(p - first);
+    return true;
+#else
+    (void)first;
+    (void)last;
+    (void)used;
+    (void)value;
+    return false;
+#endif
+}
+
+// parse a floating point number as strtod() does in the "C" locale. plain
+// decimals are parsed by parse_decimal(). for the others, the characters
+// that may belong to the number are copied to a buffer on the stack, unless
+// there are a great many of them, for strtod() in the current locale
+template<typename T, typename Char>
+T const parse_floating(Char const *first, Char const *last, std::size_t &used, char const *name)
+{
+    T value;
+    if (parse_decimal(first, last, used, value))
+        return value;
+
+    Char const *start = first;
+    while (start != last  &&  is_space(static_cast<unsigned long>(*start)))
+        ++start;
+    Char const *end = start;
+    while (end != last  &&  is_floating_character(static_cast<unsigned long>(*end)))
+        ++end;
+
+    std::size_t const length = static_cast<std::size_t>(end - start);
+    char             buffer[64];
+    std::vector<char> large;
+    char *text = buffer;
+    if (length >= sizeof(buffer))
+    {
+        large.resize(length + 1);
+        text = &large[0];
+    }
+
+    char const point = *std::localeconv()->decimal_point;
+    for (std::size_t i=0; i<length; ++i)
+        text[i] = (start[i] == Char('.'))? point : static_cast<char>(start[i]);
+    text[length] = 0;
+
+    int const saved_errno = errno;
+    errno = 0;
+    char *stop;
+    value = read_floating(text, &stop, T());
+    bool const out_of_range = (errno == ERANGE);
+    errno = saved_errno;
+    if (stop == text)
+        throw std::invalid_argument(name);
+    else if (out_of_range)
+        throw std::out_of_range(name);
+
+    used = static_cast<std::size_t>(start - first) + static_cast<std::size_t>(stop - text);
+    return value;
+}
+
+}   // namespace detail
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_number<T, basic_immutable_string<Char, Traits, Alloc>>::type
+basic_immutable_string<Char, Traits, Alloc>::from(T value, allocator_type const &alloc)
+{
+    Char buffer[64];
+    Char const *const first = detail::format_number(value, buffer + 64, std::is_integral<T>());
+    return basic_immutable_string(first, static_cast<size_type>(buffer + 64 - first), alloc);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+int const basic_immutable_string<Char, Traits, Alloc>::to_int(size_type *idx, int base) const
+{
+    std::size_t used;
+    int const result = detail::parse_integer<int>(data(), data() + size(), used, base, "to_int");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+long const basic_immutable_string<Char, Traits, Alloc>::to_long(size_type *idx, int base) const
+{
+    std::size_t used;
+    long const result = detail::parse_integer<long>(data(), data() + size(), used, base, "to_long");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+long long const basic_immutable_string<Char, Traits, Alloc>::to_long_long(size_type *idx, int base) const
+{
+    std::size_t used;
+    long long const result = detail::parse_integer<long long>(data(), data() + size(), used, base, "to_long_long");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+unsigned long const basic_immutable_string<Char, Traits, Alloc>::to_unsigned_long(size_type *idx, int base) const
+{
+    std::size_t used;
+    unsigned long const result = detail::parse_integer<unsigned long>(data(), data() + size(), used, base, "to_unsigned_long");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+unsigned long long const basic_immutable_string<Char, Traits, Alloc>::to_unsigned_long_long(size_type *idx, int base) const
+{
+    std::size_t used;
+    unsigned long long const result = detail::parse_integer<unsigned long long>(data(), data() + size(), used, base, "to_unsigned_long_long");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+float const basic_immutable_string<Char, Traits, Alloc>::to_float(size_type *idx) const
+{
+    std::size_t used;
+    float const result = detail::parse_floating<float>(data(), data() + size(), used, "to_float");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+double const basic_immutable_string<Char, Traits, Alloc>::to_double(size_type *idx) const
+{
+    std::size_t used;
+    double const result = detail::parse_floating<double>(data(), data() + size(), used, "to_double");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+long double const basic_immutable_string<Char, Traits, Alloc>::to_long_double(size_type *idx) const
+{
+    std::size_t used;
+    long double const result = detail::parse_floating<long double>(data(), data() + size(), used, "to_long_double");
+    if (idx)
+        *idx = static_cast<size_type>(used);
+    return result;
+}
+
+template<typename Char>
+Char const ci_char_traits<Char>::fold(Char c) noexcept
+{
+    return (c >= Char('A')  &&  c <= Char('Z'))? Char(c ^ 0x20) : c;
+}
+
+template<typename Char>
+bool const ci_char_traits<Char>::eq(Char c1, Char c2) noexcept
+{
+    return std::char_traits<Char>::eq(fold(c1), fold(c2));
+}
+
+template<typename Char>
+bool const ci_char_traits<Char>::lt(Char c1, Char c2) noexcept
+{
+    return std::char_traits<Char>::lt(fold(c1), fold(c2));
+}
+
+template<typename Char>
+int const ci_char_traits<Char>::compare(Char const *s1, Char const *s2, std::size_t n)
+{
+    return detail::ascii_casecmp(s1, s2, n);
+}
+
+template<typename Char>
+Char const *const ci_char_traits<Char>::find(Char const *s, std::size_t n, Char const &c)
+{
+    // a character without case, such as the terminator that measures a
+    // literal, matches only itself
+    Char const folded = fold(c);
+    if (folded < Char('a')  ||  folded > Char('z'))
+        return std::char_traits<Char>::find(s, n, c);
+
+    for (std::size_t i=0; i<n; ++i)
+    {
+        if (std::char_traits<Char>::eq(fold(s[i]), folded))
+            return s + i;
+    }
+    return 0;
+}
+
+namespace detail {
+
+struct utf_scan
+{
+    bool        valid;
+    bool        ascii;
+    std::size_t code_points;
+};
+
+// length of the well-formed UTF-8 sequence at the start of s (Unicode 6.3
+// table 3-7), or zero if the sequence is ill-formed
+inline std::size_t const utf8_sequence_length(unsigned char const *s, std::size_t n) noexcept
+{
+    unsigned char const c = s[0];
+    if (c < 0x80)
+        return 1;
+    else if (c < 0xc2)
+        return 0;
+    else if (c < 0xe0)
+        return (n >= 2  &&  (s[1] & 0xc0) == 0x80)? 2 : 0;
+    else if (c < 0xf0)
+    {
+        unsigned char const lo = (c == 0xe0)? 0xa0 : 0x80;
+        unsigned char const hi = (c == 0xed)? 0x9f : 0xbf;
+        return (n >= 3  &&  s[1] >= lo  &&  s[1] <= hi  &&  (s[2] & 0xc0) == 0x80)? 3 : 0;
+    }
+    else if (c < 0xf5)
+    {
+        unsigned char const lo = (c == 0xf0)? 0x90 : 0x80;
+        unsigned char const hi = (c == 0xf4)? 0x8f : 0xbf;
+        return (n >= 4  &&  s[1] >= lo  &&  s[1] <= hi  &&  (s[2] & 0xc0) == 0x80  &&  (s[3] & 0xc0) == 0x80)? 4 : 0;
+    }
+    return 0;
+}
+
+// true if the 16 (SSE2) or 8 bytes at s are all ASCII
+inline bool const ascii_block(unsigned char const *s) noexcept
+{
+#if HAS_SSE2
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s))) == 0;
+#else
+    std::uint64_t word;
+    std::memcpy(&word, s, sizeof(word));
+    return (word & 0x8080808080808080ULL) == 0;
+#endif
+}
+
+#if HAS_SSE2
+std::size_t const ascii_block_size = 16;
+#else
+std::size_t const ascii_block_size = 8;
+#endif
+
+template<typename Char>
+utf_scan const scan_utf(Char const *str, std::size_t n, std::integral_constant<std::size_t, 1>) noexcept
+{
+    unsigned char const *s = reinterpret_cast<unsigned char const *>(str);
+    utf_scan result = { true, true, 0 };
+    std::size_t i = 0;
+    while (i < n)
+    {
+        if (i + ascii_block_size <= n  &&  ascii_block(s + i))
+        {
+            i += ascii_block_size;
+            result.code_points += ascii_block_size;
+        }
+        else if (s[i] < 0x80)
+        {
+            ++i;
+            ++result.code_points;
+        }
+        else
+        {
+            result.ascii = false;
+            std::size_t const length = utf8_sequence_length(s + i, n - i);
+            if (length == 0)
+            {
+                result.valid = false;
+                return result;
+            }
+            i += length;
+            ++result.code_points;
+        }
+    }
+    return result;
+}
+
+template<typename Char>
+utf_scan const scan_utf(Char const *s, std::size_t n, std::integral_constant<std::size_t, 2>) noexcept
+{
+    utf_scan result = { true, true, 0 };
+    for (std::size_t i=0; i<n; ++i, ++result.code_points)
+    {
+        std::uint32_t const c = static_cast<std::uint16_t>(s[i]);
+        if (c < 0x80)
+            continue;
+
+        result.ascii = false;
+        if (c >= 0xd800  &&  c < 0xdc00  &&  i + 1 < n
+        &&  static_cast<std::uint16_t>(s[i+1]) >= 0xdc00  &&  static_cast<std::uint16_t>(s[i+1]) < 0xe000)
+        {
+            ++i;
+        }
+        else if (c >= 0xd800  &&  c < 0xe000)
+        {
+            result.valid = false;
+            return result;
+        }
+    }
+    return result;
+}
+
+template<typename Char>
+utf_scan const scan_utf(Char const *s, std::size_t n, std::integral_constant<std::size_t, 4>) noexcept
+{
+    utf_scan result = { true, true, n };
+    for (std::size_t i=0; i<n; ++i)
+    {
+        std::uint32_t const c = static_cast<std::uint32_t>(s[i]);
+        if (c >= 0x80)
+            result.ascii = false;
+        if (c >= 0x110000  ||  (c >= 0xd800  &&  c < 0xe000))
+        {
+            result.valid = false;
+            return result;
+        }
+    }
+    return result;
+}
+
+}   // namespace detail
+
+template<typename Char, typename Traits, typename Alloc>
+std::uint64_t const basic_immutable_string<Char, Traits, Alloc>::utf_metadata(void) const noexcept
+{
+    typedef detail::string_metadata metadata;
+
+    std::uint64_t utf = meta_.utf.load(std::memory_order_relaxed);
+    if ((utf & metadata::utf_computed) == 0)
+    {
+        detail::utf_scan const scan = detail::scan_utf(data(), size(), std::integral_constant<std::size_t, sizeof(Char)>());
+        utf = metadata::utf_computed
+            | (scan.valid? metadata::utf_valid : 0)
+            | (scan.ascii? metadata::utf_ascii : 0)
+            | (scan.valid? static_cast<std::uint64_t>(scan.code_points) << metadata::utf_count_shift : 0);
+        meta_.utf.fetch_or(utf, std::memory_order_relaxed);
+    }
+    return utf;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::uint64_t const basic_immutable_string<Char, Traits, Alloc>::prefix_key(void) const noexcept
+{
+    typedef detail::prefix_key<Char, Traits> key;
+
+    if (!key::enabled)
+        return 0;
+    if (meta_.utf.load(std::memory_order_acquire) & detail::string_metadata::prefix_computed)
+        return meta_.prefix.load(std::memory_order_relaxed);
+
+    std::uint64_t const prefix = key::pack(data(), size());
+    meta_.prefix.store(prefix, std::memory_order_relaxed);
+    meta_.utf.fetch_or(detail::string_metadata::prefix_computed, std::memory_order_release);
+    return prefix;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_immutable_string<Char, Traits, Alloc>::is_valid_utf(void) const noexcept
+{
+    return (utf_metadata() & detail::string_metadata::utf_valid) != 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_immutable_string<Char, Traits, Alloc>::is_ascii(void) const noexcept
+{
+    return (utf_metadata() & detail::string_metadata::utf_ascii) != 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::code_points(void) const noexcept
+{
+    std::uint64_t const utf = utf_metadata();
+    if ((utf & detail::string_metadata::utf_valid) == 0)
+        return npos;
+    return static_cast<size_type>(utf >> detail::string_metadata::utf_count_shift);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find(basic_immutable_string const &str, size_type pos) const noexcept
+{
+    return string_.find(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+{
+    return string_.find(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::find(T s, size_type pos) const
+{
+    return string_.find(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find(Char const *s, size_type pos, size_type n) const
+{
+    return string_.find(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find(Char c, size_type pos) const noexcept
+{
+    return string_.find(c, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::rfind(basic_immutable_string const &str, size_type pos) const
+{
+    return string_.rfind(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::rfind(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const
+{
+    return string_.rfind(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::rfind(T s, size_type pos) const
+{
+    return string_.rfind(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::rfind(Char const *s, size_type pos, size_type n) const
+{
+    return string_.rfind(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::rfind(Char c, size_type pos) const
+{
+    return string_.rfind(c, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_of(basic_immutable_string const &str, size_type pos) const noexcept
+{
+    return string_.find_first_of(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+{
+    return string_.find_first_of(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::find_first_of(T s, size_type pos) const
+{
+    return string_.find_first_of(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_of(Char const *s, size_type pos, size_type n) const
+{
+    return string_.find_first_of(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_of(Char c, size_type pos) const noexcept
+{
+    return string_.find_first_of(c, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_of(basic_immutable_string const &str, size_type pos) const noexcept
+{
+    return string_.find_last_of(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+{
+    return string_.find_last_of(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::find_last_of(T s, size_type pos) const
+{
+    return string_.find_last_of(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_of(Char const *s, size_type pos, size_type n) const
+{
+    return string_.find_last_of(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_of(Char c, size_type pos) const noexcept
+{
+    return string_.find_last_of(c, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(basic_immutable_string const &str, size_type pos) const noexcept
+{
+    return string_.find_first_not_of(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+{
+    return string_.find_first_not_of(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(T s, size_type pos) const
+{
+    return string_.find_first_not_of(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char const *s, size_type pos, size_type n) const
+{
+    return string_.find_first_not_of(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char c, size_type pos) const noexcept
+{
+    return string_.find_first_not_of(c, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(basic_immutable_string const &str, size_type pos) const noexcept
+{
+    return string_.find_last_not_of(str.c_str(), pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(std::basic_string<Char, Traits, Alloc> const &str, size_type pos) const noexcept
+{
+    return string_.find_last_not_of(str, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename T>
+typename detail::if_c_string<T, Char, typename basic_immutable_string<Char, Traits, Alloc>::size_type const>::type
+basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(T s, size_type pos) const
+{
+    return string_.find_last_not_of(s, pos);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char const *s, size_type pos, size_type n) const
+{
+    return string_.find_last_not_of(s, pos, n);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string<Char, Traits, Alloc>::size_type const
+basic_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char c, size_type pos) const noexcept
+{
+    return string_.find_last_not_of(c, pos);
+}
+
+/*
+  addition operators
+*/
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, std::basic_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(std::basic_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(lhs.append(rhs.data(), rhs.size()));
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+{
     return lhs.append(rhs);
 }
 
 template <typename Char, typename traits, typename Alloc>
 basic_immutable_string<Char, traits, Alloc>
-operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, Char const *rhs)
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, std::basic_string<Char, traits, Alloc> const &rhs)
 {
     return lhs.append(rhs);
 }
 
 template <typename Char, typename traits, typename Alloc>
 basic_immutable_string<Char, traits, Alloc>
-operator+(Char const *lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+operator+(std::basic_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+{
+    return lhs + rhs.c_str();
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return lhs.append(std::forward<basic_immutable_string<Char, traits, Alloc>>(rhs));
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, std::basic_string<Char, traits, Alloc> &&rhs)
+{
+    return lhs.append(std::forward<std::basic_string<Char, traits, Alloc>>(rhs));
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(std::basic_string<Char, traits, Alloc> const &lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(rhs).insert(0, lhs);
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+{
+    return std::move(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc>
+basic_immutable_string<Char, traits, Alloc>
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, std::basic_string<Char, traits, Alloc> const &rhs)
 {
-    return basic_immutable_string<Char, traits, Alloc>(lhs).append(std::forward<basic_immutable_string<Char, traits, Alloc>>(rhs));
+    return std::move(lhs).append(rhs);
 }
 
 template <typename Char, typename traits, typename Alloc>
 basic_immutable_string<Char, traits, Alloc>
-operator+(Char const *lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+operator+(std::basic_string<Char, traits, Alloc> &&lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+{
+    return std::move(lhs.append(rhs.data(), rhs.size()));
+}
+
+template <typename Char, typename traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, T const rhs)
+{
+    return std::move(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, T const rhs)
+{
+    return lhs.append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(T const lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(rhs).insert(0, lhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T>
+typename detail::if_c_string<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(T const lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
+{
+    return basic_immutable_string<Char, traits, Alloc>(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, T (&rhs)[N])
+{
+    return std::move(lhs).append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(basic_immutable_string<Char, traits, Alloc> const &lhs, T (&rhs)[N])
+{
+    return lhs.append(rhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(T (&lhs)[N], basic_immutable_string<Char, traits, Alloc> &&rhs)
+{
+    return std::move(rhs).insert(0, lhs);
+}
+
+template <typename Char, typename traits, typename Alloc, typename T, std::size_t N>
+typename detail::if_literal<T, Char, basic_immutable_string<Char, traits, Alloc>>::type
+operator+(T (&lhs)[N], basic_immutable_string<Char, traits, Alloc> const &rhs)
 {
     return basic_immutable_string<Char, traits, Alloc>(lhs).append(rhs);
 }
@@ -847,7 +2564,7 @@ template <typename Char, typename traits, typename Alloc>
 basic_immutable_string<Char, traits, Alloc>
 operator+(basic_immutable_string<Char, traits, Alloc> &&lhs, Char rhs)
 {
-    return lhs.append(rhs);
+    return std::move(lhs).append(rhs);
 }
 
 template <typename Char, typename traits, typename Alloc>
@@ -861,7 +2578,7 @@ template <typename Char, typename traits, typename Alloc>
 basic_immutable_string<Char, traits, Alloc>
 operator+(Char lhs, basic_immutable_string<Char, traits, Alloc> &&rhs)
 {
-    return basic_immutable_string<Char, traits, Alloc>(lhs).append(std::forward<basic_immutable_string<Char, traits, Alloc>>(rhs));
+    return std::move(rhs).insert(0, 1, lhs);
 }
 
 template <typename Char, typename traits, typename Alloc>
@@ -871,6 +2588,223 @@ operator+(Char lhs, basic_immutable_string<Char, traits, Alloc> const &rhs)
     return basic_immutable_string<Char, traits, Alloc>(lhs).append(rhs);
 }
 
+/*
+  Memory accounting
+*/
+template<typename Char, typename Traits, typename Alloc>
+string_footprint const basic_immutable_string<Char, Traits, Alloc>::footprint(void) const noexcept
+{
+    // the value is never shared; each string owns a copy of its characters
+    std::size_t const bytes = heap_bytes();
+    string_footprint const result = { (bytes == 0)? nullptr : string_.data(), bytes, false, 1 };
+    return result;
+}
+
+template<typename InputIterator>
+memory_usage const measure_memory(InputIterator first, InputIterator last)
+{
+    memory_usage usage = { 0, 0, 0, 0, 0, 0, 0 };
+
+    std::vector<std::pair<void const *, std::size_t>> shared;
+    for (; first!=last; ++first)
+    {
+        ++usage.strings;
+        usage.object_bytes += sizeof(*first);
+
+        string_footprint const footprint = first->footprint();
+        if (footprint.heap_bytes == 0)
+            continue;
+        if (footprint.shared)
+            shared.push_back(std::make_pair(footprint.buffer, footprint.heap_bytes));
+        else
+        {
+            ++usage.buffers;
+            usage.unique_bytes += footprint.heap_bytes;
+        }
+    }
+
+    // each shared buffer is counted once, however many strings use it
+    std::sort(shared.begin(), shared.end());
+    for (auto it=shared.cbegin(); it!=shared.cend(); )
+    {
+        auto const next = std::find_if(it, shared.cend(), [it](std::pair<void const *, std::size_t> const &entry) { return entry.first != it->first; });
+        ++usage.buffers;
+        usage.shared_bytes += it->second;
+        usage.saved_bytes  += it->second * static_cast<std::size_t>(std::distance(it, next) - 1);
+        it = next;
+    }
+
+    usage.total_bytes = usage.object_bytes + usage.unique_bytes + usage.shared_bytes;
+    return usage;
+}
+
+/*
+  Unicode transcoding
+*/
+namespace detail {
+
+// decoders for input that has already been validated
+inline std::uint32_t const decode_utf(char const *&s) noexcept
+{
+    unsigned char const *p = reinterpret_cast<unsigned char const *>(s);
+    std::uint32_t c = *p;
+    if (c < 0x80)
+    {
+        s += 1;
+        return c;
+    }
+    else if (c < 0xe0)
+    {
+        s += 2;
+        return ((c & 0x1f) << 6) | (p[1] & 0x3f);
+    }
+    else if (c < 0xf0)
+    {
+        s += 3;
+        return ((c & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+    }
+    s += 4;
+    return ((c & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+}
+
+inline std::uint32_t const decode_utf(char16_t const *&s) noexcept
+{
+    std::uint32_t const c = *s++;
+    if (c < 0xd800  ||  c >= 0xdc00)
+        return c;
+    return 0x10000 + ((c - 0xd800) << 10) + (*s++ - 0xdc00);
+}
+
+inline std::uint32_t const decode_utf(char32_t const *&s) noexcept
+{
+    return *s++;
+}
+
+inline std::size_t const utf8_length(std::uint32_t c) noexcept
+{
+    return (c < 0x80)? 1 : (c < 0x800)? 2 : (c < 0x10000)? 3 : 4;
+}
+
+inline std::size_t const utf16_length(std::uint32_t c) noexcept
+{
+    return (c < 0x10000)? 1 : 2;
+}
+
+inline void encode_utf(std::uint32_t c, char *&out) noexcept
+{
+    if (c < 0x80)
+        *out++ = static_cast<char>(c);
+    else if (c < 0x800)
+    {
+        *out++ = static_cast<char>(0xc0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+    else if (c < 0x10000)
+    {
+        *out++ = static_cast<char>(0xe0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+    else
+    {
+        *out++ = static_cast<char>(0xf0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+}
+
+inline void encode_utf(std::uint32_t c, char16_t *&out) noexcept
+{
+    if (c < 0x10000)
+        *out++ = static_cast<char16_t>(c);
+    else
+    {
+        *out++ = static_cast<char16_t>(0xd800 + ((c - 0x10000) >> 10));
+        *out++ = static_cast<char16_t>(0xdc00 + ((c - 0x10000) & 0x3ff));
+    }
+}
+
+inline void encode_utf(std::uint32_t c, char32_t *&out) noexcept
+{
+    *out++ = static_cast<char32_t>(c);
+}
+
+inline std::size_t const encoded_length(std::uint32_t c, char)     noexcept { return utf8_length(c);  }
+inline std::size_t const encoded_length(std::uint32_t c, char16_t) noexcept { return utf16_length(c); }
+inline std::size_t const encoded_length(std::uint32_t,   char32_t) noexcept { return 1;               }
+
+template<typename To, typename From, typename Traits, typename Alloc>
+basic_immutable_string<To> transcode(basic_immutable_string<From, Traits, Alloc> const &str)
+{
+    if (!str.is_valid_utf())
+        throw std::range_error("invalid Unicode string");
+
+    From const *const end = str.data() + str.size();
+    std::basic_string<To> result;
+    if (str.is_ascii())
+    {
+        result.resize(str.size());
+        for (std::size_t i=0; i<str.size(); ++i)
+            result[i] = static_cast<To>(static_cast<unsigned char>(str[i]));
+        return result;
+    }
+
+    // UTF-32 output is sized by the cached code point count; other encodings
+    // need a measuring pass over the source
+    std::size_t length = str.code_points();
+    if (sizeof(To) != 4)
+    {
+        length = 0;
+        for (From const *s=str.data(); s != end; )
+            length += encoded_length(decode_utf(s), To());
+    }
+
+    result.resize(length);
+    To *out = &result[0];
+    for (From const *s=str.data(); s != end; )
+        encode_utf(decode_utf(s), out);
+    return result;
+}
+
+}   // namespace detail
+
+template<typename Traits, typename Alloc>
+immutable_string to_utf8(basic_immutable_string<char16_t, Traits, Alloc> const &str)
+{
+    return detail::transcode<char>(str);
+}
+
+template<typename Traits, typename Alloc>
+immutable_string to_utf8(basic_immutable_string<char32_t, Traits, Alloc> const &str)
+{
+    return detail::transcode<char>(str);
+}
+
+template<typename Traits, typename Alloc>
+immutable_u16string to_utf16(basic_immutable_string<char, Traits, Alloc> const &str)
+{
+    return detail::transcode<char16_t>(str);
+}
+
+template<typename Traits, typename Alloc>
+immutable_u16string to_utf16(basic_immutable_string<char32_t, Traits, Alloc> const &str)
+{
+    return detail::transcode<char16_t>(str);
+}
+
+template<typename Traits, typename Alloc>
+immutable_u32string to_utf32(basic_immutable_string<char, Traits, Alloc> const &str)
+{
+    return detail::transcode<char32_t>(str);
+}
+
+template<typename Traits, typename Alloc>
+immutable_u32string to_utf32(basic_immutable_string<char16_t, Traits, Alloc> const &str)
+{
+    return detail::transcode<char32_t>(str);
+}
+
 template<typename Char, typename traits, typename Alloc>
 std::basic_ostream<Char, traits> &operator<<(std::basic_ostream<Char, traits>& os, basic_immutable_string<Char, traits, Alloc> const &str)
 {
@@ -879,3 +2813,19 @@ std::basic_ostream<Char, traits> &operator<<(std::basic_ostream<Char, traits>& o
 }
 
 }   // namespace cdmh
+
+namespace std {
+
+template<typename Char, typename Traits, typename Alloc>
+struct hash<cdmh::basic_immutable_string<Char, Traits, Alloc>>
+{
+    typedef cdmh::basic_immutable_string<Char, Traits, Alloc> argument_type;
+    typedef std::size_t                                       result_type;
+
+    result_type operator()(argument_type const &str) const
+    {
+        return str.hash();
+    }
+};
+
+}   // namespace std
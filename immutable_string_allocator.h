@@ -0,0 +1,174 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace cdmh {
+
+namespace detail {
+
+// a pool of string buffers in size classes, with a cache of free blocks for
+// each thread. a thread allocates from and frees to its own cache without
+// locks or atomic read-modify-writes. a block freed by another thread is
+// pushed onto a lock free list in the cache of the thread that allocated
+// it, which takes the whole list back when its own list of that class runs
+// out. a cache is not destroyed when its thread exits, as blocks it gave
+// out may still be in use, but is handed to the next new thread. memory is
+// kept by the pool for reuse rather than returned to the system
+namespace string_pool {
+
+// every block is preceded by a header naming the cache that carved it, and
+// the sizes are multiples of 16 so that the blocks are as aligned as those
+// from operator new. requests larger than the largest class go to operator
+// new, and the size passed to deallocate() tells the two apart
+enum { header_size = 16, classes = 14, slab_size = 16 * 1024 };
+
+inline std::size_t const class_size(std::size_t index) noexcept
+{
+    static std::size_t const sizes[classes] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+    return sizes[index];
+}
+
+// the smallest class that holds bytes, or classes if there is none
+inline std::size_t const size_class(std::size_t bytes) noexcept
+{
+    std::size_t index = 0;
+    while (index != classes  &&  class_size(index) < bytes)
+        ++index;
+    return index;
+}
+
+struct free_block
+{
+    free_block *next;
+};
+
+struct thread_cache
+{
+    thread_cache()
+    {
+        for (std::size_t index=0; index<classes; ++index)
+        {
+            free[index] = nullptr;
+            remote[index].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    free_block               *free[classes];     // used only by the owning thread
+    std::atomic<free_block *> remote[classes];   // pushed by other threads
+    std::vector<void *>       slabs;             // never freed, but held so that leak checkers see them
+};
+
+struct header
+{
+    thread_cache *owner;
+};
+
+class registry
+{
+  public:
+    static registry &instance(void)
+    {
+        // never destroyed, as strings may be freed during static destruction
+        static registry *const the_registry = new registry;
+        return *the_registry;
+    }
+
+    thread_cache *acquire(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty())
+        {
+            thread_cache *const cache = free_.back();
+            free_.pop_back();
+            return cache;
+        }
+        return new thread_cache;
+    }
+
+    void release(thread_cache *cache)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(cache);
+    }
+
+  private:
+    std::mutex                  mutex_;
+    std::vector<thread_cache *> free_;
+};
+
+inline void       *allocate(std::size_t bytes);
+inline void        deallocate(void *p, std::size_t bytes) noexcept;
+
+}   // namespace string_pool
+
+}   // namespace detail
+
+// a stateless allocator that draws buffers of up to 2KB from the string
+// pool and larger ones from operator new. all instances are equal, so a
+// string allocated on one thread may be freed on any other
+template<typename T>
+class pooled_allocator
+{
+  public:
+    typedef T               value_type;
+    typedef T              *pointer;
+    typedef T const        *const_pointer;
+    typedef T              &reference;
+    typedef T const        &const_reference;
+    typedef std::size_t     size_type;
+    typedef std::ptrdiff_t  difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef pooled_allocator<U> other;
+    };
+
+    pooled_allocator() noexcept                                                           { }
+    template<typename U>
+    pooled_allocator(pooled_allocator<U> const &) noexcept                                { }
+
+    T               *allocate(size_type n);
+    void             deallocate(T *p, size_type n)                                        noexcept { detail::string_pool::deallocate(p, n * sizeof(T)); }
+    size_type const  max_size(void)                                              const noexcept { return size_type(-1) / sizeof(T); }
+};
+
+template<typename T, typename U>
+inline bool const operator==(pooled_allocator<T> const &, pooled_allocator<U> const &) noexcept { return true;  }
+template<typename T, typename U>
+inline bool const operator!=(pooled_allocator<T> const &, pooled_allocator<U> const &) noexcept { return false; }
+
+typedef basic_immutable_string<char,     std::char_traits<char>,     pooled_allocator<char>>     pooled_immutable_string;
+typedef basic_immutable_string<wchar_t,  std::char_traits<wchar_t>,  pooled_allocator<wchar_t>>  pooled_immutable_wstring;
+typedef basic_immutable_string<char16_t, std::char_traits<char16_t>, pooled_allocator<char16_t>> pooled_immutable_u16string;
+typedef basic_immutable_string<char32_t, std::char_traits<char32_t>, pooled_allocator<char32_t>> pooled_immutable_u32string;
+
+}   // namespace cdmh
+
+#include "immutable_string_allocator.inl"
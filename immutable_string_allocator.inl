@@ -0,0 +1,139 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+namespace detail {
+
+namespace string_pool {
+
+// the cache of the calling thread, or nullptr if it has none. reading it
+// constructs nothing, so deallocate() may use it as a thread exits
+inline thread_cache *&current(void) noexcept
+{
+    static IMMUTABLE_STRING_THREAD_LOCAL thread_cache *cache = nullptr;
+    return cache;
+}
+
+#if IMMUTABLE_STRING_HAS_THREAD_EXIT
+struct thread_slot
+{
+    thread_slot() : cache(registry::instance().acquire()) { current() = cache; }
+    ~thread_slot()                                        { current() = nullptr; registry::instance().release(cache); }
+
+    thread_cache *const cache;
+};
+
+inline thread_cache &local(void)
+{
+    static thread_local thread_slot slot;
+    return *slot.cache;
+}
+#else
+inline thread_cache &local(void)
+{
+    thread_cache *&cache = current();
+    if (cache == nullptr)
+        cache = registry::instance().acquire();
+    return *cache;
+}
+#endif
+
+// carve a slab into blocks of a class, owned by the cache, and return the first
+inline free_block *refill(thread_cache &cache, std::size_t index)
+{
+    std::size_t const block_size = header_size + class_size(index);
+    std::size_t const count      = std::max<std::size_t>(slab_size / block_size, 8);
+    char *const slab = static_cast<char *>(::operator new(block_size * count));
+    cache.slabs.push_back(slab);
+
+    free_block *first = nullptr;
+    for (std::size_t i=count; i-- != 0; )
+    {
+        char *const block = slab + i * block_size;
+        reinterpret_cast<header *>(block)->owner = &cache;
+        free_block *const free = reinterpret_cast<free_block *>(block + header_size);
+        free->next = first;
+        first = free;
+    }
+    return first;
+}
+
+inline void *allocate(std::size_t bytes)
+{
+    std::size_t const index = size_class(bytes);
+    if (index == classes)
+        return ::operator new(bytes);
+
+    thread_cache &cache = local();
+    free_block *block = cache.free[index];
+    if (block == nullptr)
+    {
+        block = cache.remote[index].exchange(nullptr, std::memory_order_acquire);
+        if (block == nullptr)
+            block = refill(cache, index);
+    }
+    cache.free[index] = block->next;
+    return block;
+}
+
+inline void deallocate(void *p, std::size_t bytes) noexcept
+{
+    std::size_t const index = size_class(bytes);
+    if (index == classes)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    free_block   *const block = static_cast<free_block *>(p);
+    thread_cache *const owner = reinterpret_cast<header *>(static_cast<char *>(p) - header_size)->owner;
+    if (owner == current())
+    {
+        block->next = owner->free[index];
+        owner->free[index] = block;
+        return;
+    }
+
+    // the owner takes the whole list with an exchange and never pops a
+    // single block, so the push can't be confused by a block reused between
+    // its load and its compare_exchange
+    block->next = owner->remote[index].load(std::memory_order_relaxed);
+    while (!owner->remote[index].compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
+
+}   // namespace string_pool
+
+}   // namespace detail
+
+template<typename T>
+T *pooled_allocator<T>::allocate(size_type n)
+{
+    if (n > max_size())
+        throw std::bad_alloc();
+    return static_cast<T *>(detail::string_pool::allocate(n * sizeof(T)));
+}
+
+}   // namespace cdmh
@@ -0,0 +1,191 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Benchmarks basic_immutable_string against std::basic_string and writes the
+// results to stdout as CSV, one row per operation, implementation and size:
+//
+//     operation,implementation,size,iterations,ns_per_op,mb_per_s
+//
+// options:
+//     --min-size <bytes>      smallest string size to measure (default 1)
+//     --max-size <bytes>      largest string size to measure (default 100MB)
+//     --min-time <seconds>    minimum time to run each measurement (default 0.05)
+//     --filter <text>         only run operations whose name contains text
+//
+// std::basic_string modifiers change the string in place, so they are
+// measured on a copy of the string, which is the work an immutable string
+// does to produce its result
+
+#include "immutable_string.h"
+#include "immutable_string_allocator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct options
+{
+    std::size_t  min_size;
+    std::size_t  max_size;
+    double       min_time;
+    char const  *filter;
+};
+
+volatile std::size_t sink;
+
+// the same operations on both implementations, producing a new string
+std::string appended(std::string const &s, std::string const &t)                          { std::string r(s); r.append(t);          return r; }
+std::string inserted(std::string const &s, std::size_t pos, std::string const &t)         { std::string r(s); r.insert(pos, t);     return r; }
+std::string replaced(std::string const &s, std::size_t pos, std::size_t n, std::string const &t) { std::string r(s); r.replace(pos, n, t); return r; }
+std::string erased(std::string const &s, std::size_t pos, std::size_t n)                  { std::string r(s); r.erase(pos, n);      return r; }
+
+template<typename Traits, typename Alloc>
+cdmh::basic_immutable_string<char, Traits, Alloc> appended(cdmh::basic_immutable_string<char, Traits, Alloc> const &s, cdmh::basic_immutable_string<char, Traits, Alloc> const &t)                                  { return s.append(t);          }
+template<typename Traits, typename Alloc>
+cdmh::basic_immutable_string<char, Traits, Alloc> inserted(cdmh::basic_immutable_string<char, Traits, Alloc> const &s, std::size_t pos, cdmh::basic_immutable_string<char, Traits, Alloc> const &t)                 { return s.insert(pos, t);     }
+template<typename Traits, typename Alloc>
+cdmh::basic_immutable_string<char, Traits, Alloc> replaced(cdmh::basic_immutable_string<char, Traits, Alloc> const &s, std::size_t pos, std::size_t n, cdmh::basic_immutable_string<char, Traits, Alloc> const &t)  { return s.replace(pos, n, t); }
+template<typename Traits, typename Alloc>
+cdmh::basic_immutable_string<char, Traits, Alloc> erased(cdmh::basic_immutable_string<char, Traits, Alloc> const &s, std::size_t pos, std::size_t n)                                                                 { return s.erase(pos, n);      }
+
+// runs op in batches of doubling size until a batch takes at least the
+// minimum time, and reports the time per operation of the last batch
+template<typename Op>
+void measure(options const &opts, char const *operation, char const *implementation, std::size_t size, Op op)
+{
+    if (opts.filter  &&  std::strstr(operation, opts.filter) == nullptr)
+        return;
+
+    typedef std::chrono::steady_clock clock;
+    std::size_t iterations = 1;
+    double      elapsed;
+    for (;;)
+    {
+        clock::time_point const start = clock::now();
+        for (std::size_t i=0; i<iterations; ++i)
+            sink = sink + op();
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        if (elapsed >= opts.min_time  ||  iterations >= (std::size_t(1) << 40))
+            break;
+        iterations *= 2;
+    }
+
+    double const ns = elapsed * 1e9 / iterations;
+    std::printf("%s,%s,%llu,%llu,%.2f,%.2f\n", operation, implementation, (unsigned long long)size, (unsigned long long)iterations, ns, (ns > 0)? size * 1e3 / ns : 0.0);
+    std::fflush(stdout);
+}
+
+template<typename String>
+void run(options const &opts, char const *implementation, std::string const &text)
+{
+    std::size_t  const size = text.size();
+    String       const s(text.data(), size);
+    String       const equal(text.data(), size);
+    std::string  const last_z(std::string(text, 0, size - 1) + 'z');
+    String       const greater(last_z.data(), last_z.size());
+    String       const piece("0123456789abcdef");
+    String       const separator("-");
+    char const *const data = text.data();
+
+    // searches for characters that aren't in the text, so each scans the whole string
+    measure(opts, "construct",         implementation, size, [&]{ return String(data, size).size();                                 });
+    measure(opts, "copy",              implementation, size, [&]{ return String(s).size();                                          });
+    measure(opts, "substr",            implementation, size, [&]{ return s.substr(size / 4, size / 2).size();                       });
+    measure(opts, "append",            implementation, size, [&]{ return appended(s, s).size();                                     });
+    measure(opts, "operator+",         implementation, size, [&]{ return (s + separator + s + separator + s).size();                });
+    measure(opts, "insert",            implementation, size, [&]{ return inserted(s, size / 2, piece).size();                       });
+    measure(opts, "replace",           implementation, size, [&]{ return replaced(s, size / 4, size / 2, piece).size();             });
+    measure(opts, "erase",             implementation, size, [&]{ return erased(s, size / 4, size / 2).size();                      });
+    measure(opts, "find",              implementation, size, [&]{ return s.find("z0");                                              });
+    measure(opts, "find_char",         implementation, size, [&]{ return s.find('z');                                               });
+    measure(opts, "rfind",             implementation, size, [&]{ return s.rfind("z0");                                             });
+    measure(opts, "find_first_of",     implementation, size, [&]{ return s.find_first_of("z0123456789");                            });
+    measure(opts, "find_last_of",      implementation, size, [&]{ return s.find_last_of("z0123456789");                             });
+    measure(opts, "find_first_not_of", implementation, size, [&]{ return s.find_first_not_of("abcdefghijklmnopqrstuvwxy");          });
+    measure(opts, "find_last_not_of",  implementation, size, [&]{ return s.find_last_not_of("abcdefghijklmnopqrstuvwxy");           });
+    measure(opts, "equal",             implementation, size, [&]{ return std::size_t(s == equal);                                   });
+    measure(opts, "compare",           implementation, size, [&]{ return std::size_t(s.compare(greater) + 1);                       });
+    measure(opts, "less",              implementation, size, [&]{ return std::size_t(s < greater);                                  });
+}
+
+bool parse_size(char const *arg, std::size_t &value)
+{
+    char *end;
+    unsigned long long const result = std::strtoull(arg, &end, 10);
+    if (end == arg  ||  *end != 0)
+        return false;
+    value = static_cast<std::size_t>(result);
+    return true;
+}
+
+}   // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    options opts = { 1, 100 * 1024 * 1024, 0.05, nullptr };
+    for (int i=1; i<argc; ++i)
+    {
+        bool valid = (i + 1 < argc);
+        if (valid  &&  std::strcmp(argv[i], "--min-size") == 0)
+            valid = parse_size(argv[++i], opts.min_size);
+        else if (valid  &&  std::strcmp(argv[i], "--max-size") == 0)
+            valid = parse_size(argv[++i], opts.max_size);
+        else if (valid  &&  std::strcmp(argv[i], "--min-time") == 0)
+            opts.min_time = std::atof(argv[++i]);
+        else if (valid  &&  std::strcmp(argv[i], "--filter") == 0)
+            opts.filter = argv[++i];
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            std::cerr << "usage: " << argv[0] << " [--min-size bytes] [--max-size bytes] [--min-time seconds] [--filter text]\n";
+            return 1;
+        }
+    }
+
+    std::size_t const sizes[] = { 1, 16, 256, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 100 * 1024 * 1024 };
+
+    std::printf("operation,implementation,size,iterations,ns_per_op,mb_per_s\n");
+    for (std::size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); ++i)
+    {
+        if (sizes[i] < opts.min_size  ||  sizes[i] > opts.max_size)
+            continue;
+
+        // pseudo random lower case letters, excluding 'z'
+        std::string text(sizes[i], 'a');
+        std::uint32_t seed = 12345;
+        for (std::size_t j=0; j<text.size(); ++j)
+        {
+            seed = seed * 1103515245 + 12345;
+            text[j] = static_cast<char>('a' + (seed >> 16) % 25);
+        }
+
+        run<std::string>(opts, "std::string", text);
+        run<cdmh::immutable_string>(opts, "immutable_string", text);
+        run<cdmh::pooled_immutable_string>(opts, "pooled_immutable_string", text);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <iterator>
+#include <vector>
+
+namespace cdmh {
+
+// an immutable column of strings, built once from a range, with the
+// characters of every string packed end to end in one array and the
+// position of each in a second. a std::vector of immutable strings holds a
+// separate buffer for each string; a column of millions of short values
+// holds two, so scanning it reads memory in order rather than following a
+// pointer for each value. elements are views of the array, which are valid
+// for the life of the column. the batch operations run as a single loop
+// over the array and the positions
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_immutable_string_column
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc>      string_type;
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+    typedef view_type                                        value_type;
+    typedef std::size_t                                      size_type;
+    typedef std::ptrdiff_t                                   difference_type;
+
+    static size_type const npos = (size_type)-1;
+
+    class const_iterator
+    {
+      public:
+        typedef std::random_access_iterator_tag                    iterator_category;
+        typedef typename basic_immutable_string_column::value_type value_type;
+        typedef std::ptrdiff_t                                     difference_type;
+        typedef void                                               pointer;
+        typedef value_type                                         reference;
+
+        const_iterator() : column_(nullptr), index_(0) { }
+
+        value_type      operator*(void)                                                const { return (*column_)[index_];                    }
+        value_type      operator[](difference_type n)                                  const { return (*column_)[index_ + n];                }
+
+        const_iterator &operator++(void)                                                     { ++index_; return *this;                       }
+        const_iterator  operator++(int)                                                      { const_iterator result(*this); ++index_; return result; }
+        const_iterator &operator--(void)                                                     { --index_; return *this;                       }
+        const_iterator  operator--(int)                                                      { const_iterator result(*this); --index_; return result; }
+        const_iterator &operator+=(difference_type n)                                        { index_ += n; return *this;                    }
+        const_iterator &operator-=(difference_type n)                                        { index_ -= n; return *this;                    }
+        const_iterator  operator+(difference_type n)                                   const { return const_iterator(column_, index_ + n);   }
+        const_iterator  operator-(difference_type n)                                   const { return const_iterator(column_, index_ - n);   }
+        difference_type operator-(const_iterator const &other)                         const { return difference_type(index_ - other.index_); }
+        size_type const index(void)                                                    const { return index_;                                }
+
+        bool const operator==(const_iterator const &other)                             const { return index_ == other.index_; }
+        bool const operator!=(const_iterator const &other)                             const { return index_ != other.index_; }
+        bool const operator<(const_iterator const &other)                              const { return index_ <  other.index_; }
+        bool const operator<=(const_iterator const &other)                             const { return index_ <= other.index_; }
+        bool const operator>(const_iterator const &other)                              const { return index_ >  other.index_; }
+        bool const operator>=(const_iterator const &other)                             const { return index_ >= other.index_; }
+
+      private:
+        friend class basic_immutable_string_column;
+        const_iterator(basic_immutable_string_column const *column, size_type index) : column_(column), index_(index) { }
+
+        basic_immutable_string_column const *column_;
+        size_type                            index_;
+    };
+    typedef const_iterator iterator;
+
+    basic_immutable_string_column() : offsets_(1, 0) { }
+
+    // the strings are kept in the order given, and need data() and size()
+    // members. the characters are counted first, so that each array is
+    // allocated once
+    template<typename ForwardIterator>
+    basic_immutable_string_column(ForwardIterator first, ForwardIterator last);
+#if HAS_INITIALIZER_LIST
+    basic_immutable_string_column(std::initializer_list<view_type> il) : basic_immutable_string_column(il.begin(), il.end()) { }
+#endif
+
+    // Iterators
+    const_iterator begin(void)                                                         const { return const_iterator(this, 0);      }
+    const_iterator end(void)                                                           const { return const_iterator(this, size()); }
+    const_iterator cbegin(void)                                                        const { return begin();                      }
+    const_iterator cend(void)                                                          const { return end();                        }
+
+    // Capacity
+    bool      const empty(void)                                                        const noexcept { return size() == 0;          }
+    size_type const size(void)                                                         const noexcept { return offsets_.size() - 1;  }
+    size_type const length(size_type index)                                           const          { return offsets_[index + 1] - offsets_[index]; }
+
+    // Element access
+    view_type       operator[](size_type index)                                        const          { return view_type(chars_.data() + offsets_[index], length(index)); }
+    view_type       at(size_type index)                                                const;
+    string_type     str(size_type index)                                               const          { return at(index).str();      }
+
+    // Batch operations
+    size_type                const count_equal(view_type const &value)                 const noexcept;
+    std::vector<size_type>         rows_equal(view_type const &value)                  const;    // the rows equal to value
+    std::vector<size_type>         rows_containing(view_type const &needle)            const;    // the rows that contain needle
+    std::vector<size_type>         find(view_type const &needle)                       const;    // the first position of needle in each row, or npos
+    std::vector<std::size_t>       hashes(void)                                        const;    // the hash() of each row
+
+    // the heap bytes held by the column
+    size_type const heap_bytes(void)                                                   const noexcept { return chars_.capacity() * sizeof(Char) + offsets_.capacity() * sizeof(size_type); }
+
+  private:
+    template<typename Row>
+    void for_each_match(view_type const &needle, Row row)                              const;
+
+    std::basic_string<Char, Traits, Alloc> chars_;      // the characters of every row, end to end
+    std::vector<size_type>                 offsets_;    // the start of each row in chars_, and the end of the last
+};
+
+typedef basic_immutable_string_column<char>    immutable_string_column;
+typedef basic_immutable_string_column<wchar_t> immutable_wstring_column;
+
+}   // namespace cdmh
+
+#include "immutable_string_column.inl"
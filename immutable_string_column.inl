@@ -0,0 +1,153 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename ForwardIterator>
+basic_immutable_string_column<Char, Traits, Alloc>::basic_immutable_string_column(ForwardIterator first, ForwardIterator last)
+{
+    size_type rows  = 0;
+    size_type chars = 0;
+    for (ForwardIterator it=first; it!=last; ++it, ++rows)
+        chars += it->size();
+
+    chars_.reserve(chars);
+    offsets_.reserve(rows + 1);
+    offsets_.push_back(0);
+    for (; first!=last; ++first)
+    {
+        chars_.append(first->data(), first->size());
+        offsets_.push_back(chars_.size());
+    }
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_column<Char, Traits, Alloc>::view_type
+basic_immutable_string_column<Char, Traits, Alloc>::at(size_type index) const
+{
+    if (index >= size())
+        throw std::out_of_range("basic_immutable_string_column::at");
+    return (*this)[index];
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_column<Char, Traits, Alloc>::size_type const
+basic_immutable_string_column<Char, Traits, Alloc>::count_equal(view_type const &value) const noexcept
+{
+    size_type        count  = 0;
+    Char      const *chars  = chars_.data();
+    size_type const  n      = value.size();
+    for (size_type row=0, rows=size(); row<rows; ++row)
+    {
+        if (offsets_[row + 1] - offsets_[row] == n  &&  Traits::compare(chars + offsets_[row], value.data(), n) == 0)
+            ++count;
+    }
+    return count;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<typename basic_immutable_string_column<Char, Traits, Alloc>::size_type>
+basic_immutable_string_column<Char, Traits, Alloc>::rows_equal(view_type const &value) const
+{
+    std::vector<size_type> result;
+    Char      const *chars = chars_.data();
+    size_type const  n     = value.size();
+    for (size_type row=0, rows=size(); row<rows; ++row)
+    {
+        if (offsets_[row + 1] - offsets_[row] == n  &&  Traits::compare(chars + offsets_[row], value.data(), n) == 0)
+            result.push_back(row);
+    }
+    return result;
+}
+
+// search the whole array for the needle once, rather than each row in
+// turn, and call row(index, position) for the first match within each row.
+// a match that spans the end of a row is not a match, and the search
+// carries on from the character after its start
+template<typename Char, typename Traits, typename Alloc>
+template<typename Row>
+void basic_immutable_string_column<Char, Traits, Alloc>::for_each_match(view_type const &needle, Row row) const
+{
+    size_type const rows = size();
+    if (needle.empty())
+    {
+        for (size_type index=0; index<rows; ++index)
+            row(index, 0);
+        return;
+    }
+
+    size_type index = 0;
+    size_type pos   = 0;
+    while (index < rows)
+    {
+        pos = chars_.find(needle.data(), pos, needle.size());
+        if (pos == npos)
+            break;
+
+        // the row that the match starts in. rows before it are skipped,
+        // with a binary search when the match is far ahead
+        if (offsets_[index + 1] <= pos)
+            index = static_cast<size_type>(std::upper_bound(offsets_.begin() + index + 1, offsets_.end(), pos) - offsets_.begin()) - 1;
+
+        if (pos + needle.size() <= offsets_[index + 1])
+        {
+            row(index, pos - offsets_[index]);
+            pos = offsets_[++index];
+        }
+        else
+            ++pos;
+    }
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<typename basic_immutable_string_column<Char, Traits, Alloc>::size_type>
+basic_immutable_string_column<Char, Traits, Alloc>::rows_containing(view_type const &needle) const
+{
+    std::vector<size_type> result;
+    for_each_match(needle, [&result](size_type index, size_type) { result.push_back(index); });
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<typename basic_immutable_string_column<Char, Traits, Alloc>::size_type>
+basic_immutable_string_column<Char, Traits, Alloc>::find(view_type const &needle) const
+{
+    std::vector<size_type> result(size(), size_type(npos));
+    for_each_match(needle, [&result](size_type index, size_type pos) { result[index] = pos; });
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<std::size_t> basic_immutable_string_column<Char, Traits, Alloc>::hashes(void) const
+{
+    std::vector<std::size_t> result;
+    result.reserve(size());
+    Char const *chars = chars_.data();
+    for (size_type row=0, rows=size(); row<rows; ++row)
+        result.push_back(detail::string_hash<Traits>::hash(chars + offsets_[row], offsets_[row + 1] - offsets_[row]));
+    return result;
+}
+
+}   // namespace cdmh
@@ -0,0 +1,114 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "atomic_immutable_string.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cdmh {
+
+// finds atomic cells whose values are equal to one another and points them
+// all at one canonical value, so that the duplicates can be freed, in the
+// manner of the string deduplication of some garbage collected runtimes.
+//
+// a string's buffer belongs to the string, so two equal strings can only be
+// made to share storage by replacing the string itself, which is what a cell
+// allows. cells are tracked by weak reference; tracking one queues it, and a
+// background thread hashes its value, looks it up in a table of canonical
+// values and redirects the cell with compare_exchange(), which does nothing
+// if the cell was changed in the meantime. a writer that stores a new value
+// can track the cell again, or rescan() can queue every tracked cell. values
+// shorter than the threshold are left alone, as they cost little to keep.
+// the table holds canonical values by weak reference, so it keeps none alive
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_string_deduplicator
+{
+  public:
+    typedef basic_atomic_immutable_string<Char, Traits, Alloc> cell_type;
+    typedef typename cell_type::value_type                    value_type;
+    typedef typename cell_type::pointer                       pointer;
+    typedef typename value_type::size_type                    size_type;
+
+    struct summary
+    {
+        std::size_t inspected;      // values looked up in the table
+        std::size_t deduplicated;   // cells redirected to a canonical value
+        std::size_t bytes_saved;    // heap bytes of the values they held
+    };
+
+    explicit basic_string_deduplicator(size_type threshold = 64);
+    ~basic_string_deduplicator();
+
+    void    track(std::shared_ptr<cell_type> const &cell);
+    void    rescan(void);
+
+    // the canonical value equal to value, found on the calling thread, for
+    // code that can intern its strings itself
+    pointer canonical(pointer const &value);
+
+    // waits until every queued cell has been examined
+    void    flush(void);
+
+    size_type const threshold(void)                                                    const noexcept { return threshold_; }
+    summary   const stats(void)                                                        const;
+
+  private:
+    typedef std::weak_ptr<cell_type>                                   cell_reference;
+    typedef std::unordered_multimap<std::size_t, std::weak_ptr<value_type const>> table_type;
+
+    void run(void);
+    void deduplicate(cell_reference const &reference);
+    void sweep(void);
+
+    size_type const              threshold_;
+    mutable std::mutex           mutex_;        // guards everything below but the table
+    std::condition_variable      work_;
+    std::condition_variable      idle_;
+    std::deque<cell_reference>   queue_;
+    std::vector<cell_reference>  tracked_;
+    std::size_t                  busy_;         // cells taken from the queue and not yet done
+    bool                         stopping_;
+    summary                      summary_;
+
+    std::mutex                   table_mutex_;
+    table_type                   table_;
+    std::size_t                  inserted_;     // canonical values added since the last sweep
+
+    std::thread                  worker_;       // last, so that it starts after the rest is initialized
+
+    basic_string_deduplicator(basic_string_deduplicator const &);
+    basic_string_deduplicator &operator=(basic_string_deduplicator const &);
+};
+
+typedef basic_string_deduplicator<char>    string_deduplicator;
+typedef basic_string_deduplicator<wchar_t> wstring_deduplicator;
+
+}   // namespace cdmh
+
+#include "immutable_string_deduplicator.inl"
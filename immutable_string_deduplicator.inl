@@ -0,0 +1,182 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+basic_string_deduplicator<Char, Traits, Alloc>::basic_string_deduplicator(size_type threshold)
+  : threshold_(threshold),
+    busy_(0),
+    stopping_(false),
+    inserted_(0),
+    worker_(&basic_string_deduplicator::run, this)
+{
+    summary_.inspected    = 0;
+    summary_.deduplicated = 0;
+    summary_.bytes_saved  = 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_string_deduplicator<Char, Traits, Alloc>::~basic_string_deduplicator()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_one();
+    worker_.join();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::track(std::shared_ptr<cell_type> const &cell)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // forget cells that have gone once the list has doubled, which
+        // keeps the cost of tracking constant
+        if (tracked_.size() == tracked_.capacity())
+        {
+            tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(), [](cell_reference const &reference) { return reference.expired(); }), tracked_.end());
+            tracked_.reserve(tracked_.size() * 2 + 16);
+        }
+        tracked_.push_back(cell);
+        queue_.push_back(cell);
+    }
+    work_.notify_one();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::rescan(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(), [](cell_reference const &reference) { return reference.expired(); }), tracked_.end());
+        queue_.insert(queue_.end(), tracked_.begin(), tracked_.end());
+    }
+    work_.notify_one();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::flush(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty()  &&  busy_ == 0; });
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_deduplicator<Char, Traits, Alloc>::summary const
+basic_string_deduplicator<Char, Traits, Alloc>::stats(void) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return summary_;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_deduplicator<Char, Traits, Alloc>::pointer
+basic_string_deduplicator<Char, Traits, Alloc>::canonical(pointer const &value)
+{
+    if (!value)
+        return value;
+
+    std::size_t const hash = detail::string_hash<Traits>::hash(value->data(), value->size());
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    auto const range = table_.equal_range(hash);
+    for (auto it=range.first; it!=range.second; ++it)
+    {
+        pointer const candidate = it->second.lock();
+        if (candidate  &&  *candidate == *value)
+            return candidate;
+    }
+
+    table_.insert(std::make_pair(hash, std::weak_ptr<value_type const>(value)));
+    if (++inserted_ > table_.size() / 2)
+        sweep();
+    return value;
+}
+
+// removes the canonical values that have been freed. called with the table
+// locked, after enough insertions to pay for the pass over the table
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::sweep(void)
+{
+    for (auto it=table_.begin(); it!=table_.end();)
+    {
+        if (it->second.expired())
+            it = table_.erase(it);
+        else
+            ++it;
+    }
+    inserted_ = 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::deduplicate(cell_reference const &reference)
+{
+    std::shared_ptr<cell_type> const cell = reference.lock();
+    if (!cell)
+        return;
+
+    pointer value = cell->load();
+    if (!value  ||  value->size() < threshold_)
+        return;
+
+    pointer const replacement = canonical(value);
+    std::size_t const saved = value->footprint().heap_bytes;
+    bool const redirected = (replacement != value  &&  cell->compare_exchange(value, replacement));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++summary_.inspected;
+    if (redirected)
+    {
+        ++summary_.deduplicated;
+        summary_.bytes_saved += saved;
+    }
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_deduplicator<Char, Traits, Alloc>::run(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        work_.wait(lock, [this] { return stopping_  ||  !queue_.empty(); });
+        if (stopping_)
+            break;
+
+        std::deque<cell_reference> batch;
+        batch.swap(queue_);
+        busy_ = batch.size();
+        lock.unlock();
+
+        for (auto const &reference : batch)
+            deduplicate(reference);
+
+        lock.lock();
+        busy_ = 0;
+        if (queue_.empty())
+            idle_.notify_all();
+    }
+}
+
+}   // namespace cdmh
@@ -0,0 +1,81 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string_parallel.h"
+#include <cstdint>
+#include <vector>
+
+namespace cdmh {
+
+// a match found by find_approx(). position is npos if there is none
+struct approximate_match
+{
+    std::size_t position;
+    std::size_t length;
+    std::size_t errors;     // the edit distance between the match and the pattern
+};
+
+// the Levenshtein distance between two strings: the fewest insertions,
+// deletions and substitutions of single characters that turn one into the
+// other, with characters equal as Traits compares them. it is computed a
+// column of 64 characters of the shorter string at a time, in the bits of
+// an integer (Myers' bit-parallel algorithm), so that the cost is the
+// product of the lengths divided by 64.
+//
+// with max_distance, a distance greater than max_distance is reported as
+// max_distance + 1, and the computation stops as soon as it is certain to
+// be, which for strings whose lengths differ by more is at once
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs);
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs);
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs, std::size_t max_distance);
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs, std::size_t max_distance);
+
+// the edit distances between a pattern and each string of a range of
+// immutable strings or views, bounded by max_distance as above. the
+// pattern is prepared once, and patterns of up to 32 characters are
+// compared with four strings at once in SSE2 registers. the range is
+// divided between up to threads threads, or one per processor if threads
+// is zero
+template<typename Char, typename Traits, typename Alloc, typename RandomAccessIterator>
+std::vector<std::size_t> edit_distances(basic_immutable_string_view<Char, Traits, Alloc> const &pattern, RandomAccessIterator first, RandomAccessIterator last, std::size_t max_distance=std::size_t(-1), unsigned threads=1);
+template<typename Char, typename Traits, typename Alloc, typename RandomAccessIterator>
+std::vector<std::size_t> edit_distances(basic_immutable_string<Char, Traits, Alloc> const &pattern, RandomAccessIterator first, RandomAccessIterator last, std::size_t max_distance=std::size_t(-1), unsigned threads=1);
+
+// the first substring at or after pos within max_errors of the pattern.
+// the match ends where the edit distance first falls to max_errors or
+// below and then stops falling, and begins where that distance is reached
+// with the fewest characters
+template<typename Char, typename Traits, typename Alloc>
+approximate_match const find_approx(basic_immutable_string_view<Char, Traits, Alloc> const &text, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &pattern, std::size_t max_errors, std::size_t pos=0);
+template<typename Char, typename Traits, typename Alloc>
+approximate_match const find_approx(basic_immutable_string<Char, Traits, Alloc> const &text, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &pattern, std::size_t max_errors, std::size_t pos=0);
+
+}   // namespace cdmh
+
+#include "immutable_string_distance.inl"
@@ -0,0 +1,402 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+namespace detail {
+
+// the vertical differences between adjacent rows of 64 rows of a column of
+// the edit distance matrix, as the bits of the rows where the difference
+// is +1 and where it is -1
+struct myers_block
+{
+    std::uint64_t pv;
+    std::uint64_t mv;
+};
+
+// advances a block by one column, where eq has the bits of the rows whose
+// pattern character equals that of the column, and carry_in is the
+// horizontal difference in the row above the block. returns the
+// horizontal difference in the row of out_bit. the differences are data
+// dependent, so they are applied without branches
+inline int const advance_myers_block(myers_block &block, std::uint64_t eq, int carry_in, std::uint64_t out_bit) noexcept
+{
+    std::uint64_t const minus = static_cast<std::uint64_t>(carry_in < 0);
+    std::uint64_t const plus  = static_cast<std::uint64_t>(carry_in > 0);
+
+    std::uint64_t const xv = eq | block.mv;
+    eq |= minus;
+    std::uint64_t const xh = (((eq & block.pv) + block.pv) ^ block.pv) | eq;
+    std::uint64_t ph = block.mv | ~(xh | block.pv);
+    std::uint64_t mh = block.pv & xh;
+
+    int const carry_out = static_cast<int>((ph & out_bit) != 0) - static_cast<int>((mh & out_bit) != 0);
+    ph = (ph << 1) | plus;
+    mh = (mh << 1) | minus;
+
+    block.pv = mh | ~(xv | ph);
+    block.mv = ph & xv;
+    return carry_out;
+}
+
+// a pattern prepared for Myers' algorithm: for each character, the bits of
+// the positions in the pattern that Traits says are equal to it. characters
+// below 256 are looked up in a table; the others are equal only to
+// themselves and are found by a binary search
+template<typename Char, typename Traits>
+class myers_pattern
+{
+  public:
+    myers_pattern(Char const *s, std::size_t size);
+
+    std::size_t          const  size(void)                                                        const noexcept { return size_; }
+    std::size_t          const  words(void)                                                       const noexcept { return words_; }
+    std::uint64_t const *const  eq(Char c)                                                        const noexcept;
+
+    // calls visit(j, score) with the score in the last row after each of the
+    // first n columns of the text, while it returns true. the top row rises
+    // by top in each column: 1 to compare the whole of the text, 0 to search
+    // it for a match that may start anywhere
+    template<typename Iterator, typename Visit>
+    void run(Iterator text, std::size_t n, int top, Visit visit)                                  const;
+
+    // the edit distance to the text, or max + 1 if it is more than max
+    std::size_t          const  distance(Char const *text, std::size_t n, std::size_t max)        const;
+
+  private:
+    typedef typename std::make_unsigned<Char>::type unsigned_char;
+
+    std::size_t                               size_;
+    std::size_t                               words_;
+    std::vector<std::uint64_t>                low_;         // 257 rows of words_; the last is zero
+    std::vector<std::pair<Char, std::size_t>> high_;        // in order of character, with their rows
+    std::vector<std::uint64_t>                high_rows_;
+};
+
+template<typename Char, typename Traits>
+myers_pattern<Char, Traits>::myers_pattern(Char const *s, std::size_t size)
+  : size_(size),
+    words_(std::max<std::size_t>(1, (size + 63) / 64)),
+    low_(257 * words_)
+{
+    std::vector<std::pair<Char, std::size_t>> high;
+    for (std::size_t i=0; i<size; ++i)
+    {
+        std::size_t const value = static_cast<unsigned_char>(s[i]);
+        std::uint64_t const bit = std::uint64_t(1) << (i % 64);
+        if (value >= 256)
+            high.push_back(std::make_pair(s[i], i));
+        else if (std::is_same<Traits, std::char_traits<Char>>::value)
+            low_[value * words_ + i / 64] |= bit;
+        else
+        {
+            for (std::size_t c=0; c<256; ++c)
+            {
+                if (Traits::eq(static_cast<Char>(c), s[i]))
+                    low_[c * words_ + i / 64] |= bit;
+            }
+        }
+    }
+
+    std::sort(high.begin(), high.end());
+    for (std::size_t i=0; i<high.size(); ++i)
+    {
+        if (i == 0  ||  high[i].first != high[i - 1].first)
+        {
+            high_.push_back(std::make_pair(high[i].first, high_rows_.size()));
+            high_rows_.resize(high_rows_.size() + words_);
+        }
+        high_rows_[high_.back().second + high[i].second / 64] |= std::uint64_t(1) << (high[i].second % 64);
+    }
+}
+
+template<typename Char, typename Traits>
+std::uint64_t const *const myers_pattern<Char, Traits>::eq(Char c) const noexcept
+{
+    std::size_t const value = static_cast<unsigned_char>(c);
+    if (value < 256)
+        return &low_[value * words_];
+
+    auto const it = std::lower_bound(high_.begin(), high_.end(), std::make_pair(c, std::size_t(0)));
+    if (it != high_.end()  &&  it->first == c)
+        return &high_rows_[it->second];
+    return &low_[256 * words_];
+}
+
+template<typename Char, typename Traits>
+template<typename Iterator, typename Visit>
+void myers_pattern<Char, Traits>::run(Iterator text, std::size_t n, int top, Visit visit) const
+{
+    myers_block const initial = { ~std::uint64_t(0), 0 };
+    std::uint64_t const last_bit = std::uint64_t(1) << ((size_ - 1) % 64);
+    std::uint64_t const high_bit = std::uint64_t(1) << 63;
+
+    std::size_t score = size_;
+    if (words_ == 1)
+    {
+        myers_block block = initial;
+        for (std::size_t j=1; j<=n; ++j, ++text)
+        {
+            score += advance_myers_block(block, *eq(*text), top, last_bit);
+            if (!visit(j, score))
+                return;
+        }
+        return;
+    }
+
+    std::vector<myers_block> blocks(words_, initial);
+    for (std::size_t j=1; j<=n; ++j, ++text)
+    {
+        std::uint64_t const *const eq = this->eq(*text);
+        int carry = top;
+        for (std::size_t word=0; word+1<words_; ++word)
+            carry = advance_myers_block(blocks[word], eq[word], carry, high_bit);
+        score += advance_myers_block(blocks[words_ - 1], eq[words_ - 1], carry, last_bit);
+        if (!visit(j, score))
+            return;
+    }
+}
+
+// the distance falls by at most one in each column, so a score more than
+// max above the number of columns left cannot fall to max
+template<typename Char, typename Traits>
+std::size_t const myers_pattern<Char, Traits>::distance(Char const *text, std::size_t n, std::size_t max) const
+{
+    if ((n > size_? n - size_ : size_ - n) > max)
+        return max + 1;
+    if (size_ == 0)
+        return n;
+
+    std::size_t result = size_;
+    run(text, n, 1, [&result, n, max](std::size_t j, std::size_t score) {
+        result = score;
+        if (score > max  &&  score - max > n - j)
+            return false;
+        return true;
+    });
+    return (result > max)? max + 1 : result;
+}
+
+#if HAS_SSE2
+// the edit distances between a pattern of 1 to 32 characters and four
+// strings, in the 32 bit lanes of SSE2 registers. the characters of the
+// strings are looked up one at a time, and the rest of each column is
+// computed for all four at once
+template<typename Char, typename Traits>
+void myers_distances4(myers_pattern<Char, Traits> const &pattern, Char const *const texts[4], std::size_t const sizes[4], std::size_t results[4])
+{
+    __m128i const ones  = _mm_set1_epi32(-1);
+    __m128i const one   = _mm_set1_epi32(1);
+    __m128i const shift = _mm_cvtsi32_si128(static_cast<int>(pattern.size() - 1));
+    __m128i pv    = ones;
+    __m128i mv    = _mm_setzero_si128();
+    __m128i score = _mm_set1_epi32(static_cast<int>(pattern.size()));
+
+    std::size_t longest = 0;
+    for (int lane=0; lane<4; ++lane)
+    {
+        longest = std::max(longest, sizes[lane]);
+        if (sizes[lane] == 0)
+            results[lane] = pattern.size();
+    }
+
+    for (std::size_t j=0; j<longest; ++j)
+    {
+        std::uint32_t eq[4];
+        for (int lane=0; lane<4; ++lane)
+            eq[lane] = (j < sizes[lane])? static_cast<std::uint32_t>(*pattern.eq(texts[lane][j])) : 0;
+        __m128i const e = _mm_set_epi32(static_cast<int>(eq[3]), static_cast<int>(eq[2]), static_cast<int>(eq[1]), static_cast<int>(eq[0]));
+
+        __m128i const xv = _mm_or_si128(e, mv);
+        __m128i const xh = _mm_or_si128(_mm_xor_si128(_mm_add_epi32(_mm_and_si128(e, pv), pv), pv), e);
+        __m128i       ph = _mm_or_si128(mv, _mm_xor_si128(_mm_or_si128(xh, pv), ones));
+        __m128i       mh = _mm_and_si128(pv, xh);
+        score = _mm_add_epi32(score, _mm_and_si128(_mm_srl_epi32(ph, shift), one));
+        score = _mm_sub_epi32(score, _mm_and_si128(_mm_srl_epi32(mh, shift), one));
+        ph = _mm_or_si128(_mm_slli_epi32(ph, 1), one);
+        mh = _mm_slli_epi32(mh, 1);
+        pv = _mm_or_si128(mh, _mm_xor_si128(_mm_or_si128(xv, ph), ones));
+        mv = _mm_and_si128(ph, xv);
+
+        if (j + 1 == sizes[0]  ||  j + 1 == sizes[1]  ||  j + 1 == sizes[2]  ||  j + 1 == sizes[3])
+        {
+            std::uint32_t scores[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(scores), score);
+            for (int lane=0; lane<4; ++lane)
+            {
+                if (j + 1 == sizes[lane])
+                    results[lane] = scores[lane];
+            }
+        }
+    }
+}
+#endif
+
+}   // namespace detail
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs)
+{
+    return edit_distance(lhs, rhs, std::size_t(-1));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs)
+{
+    return edit_distance(basic_immutable_string_view<Char, Traits, Alloc>(lhs), rhs, std::size_t(-1));
+}
+
+// the shorter string is the pattern, so that it has the fewest blocks
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs, std::size_t max_distance)
+{
+    basic_immutable_string_view<Char, Traits, Alloc> const &pattern = (lhs.size() <= rhs.size())? lhs : rhs;
+    basic_immutable_string_view<Char, Traits, Alloc> const &text    = (lhs.size() <= rhs.size())? rhs : lhs;
+    if (text.size() - pattern.size() > max_distance)
+        return max_distance + 1;
+    return detail::myers_pattern<Char, Traits>(pattern.data(), pattern.size()).distance(text.data(), text.size(), max_distance);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const edit_distance(basic_immutable_string<Char, Traits, Alloc> const &lhs, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &rhs, std::size_t max_distance)
+{
+    return edit_distance(basic_immutable_string_view<Char, Traits, Alloc>(lhs), rhs, max_distance);
+}
+
+// the range is divided into tasks of a fixed number of strings. within a
+// task, strings whose lengths alone put them beyond max_distance are
+// skipped, and the others are compared four at a time where possible
+template<typename Char, typename Traits, typename Alloc, typename RandomAccessIterator>
+std::vector<std::size_t> edit_distances(basic_immutable_string_view<Char, Traits, Alloc> const &pattern, RandomAccessIterator first, RandomAccessIterator last, std::size_t max_distance, unsigned threads)
+{
+    std::size_t const count = static_cast<std::size_t>(last - first);
+    std::size_t const task_size = 1024;
+    std::vector<std::size_t> results(count);
+    detail::myers_pattern<Char, Traits> const prepared(pattern.data(), pattern.size());
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    detail::run_parallel((count + task_size - 1) / task_size, threads, [&](std::size_t task) {
+        std::size_t const begin = task * task_size;
+        std::size_t const end   = std::min(count, begin + task_size);
+#if HAS_SSE2
+        bool const batch = (prepared.size() >= 1  &&  prepared.size() <= 32);
+        Char const *texts[4];
+        std::size_t sizes[4];
+        std::size_t indices[4];
+        std::size_t distances[4];
+        int pending = 0;
+#endif
+        for (std::size_t i=begin; i<end; ++i)
+        {
+            Char const *const data = first[i].data();
+            std::size_t const size = first[i].size();
+            if ((size > prepared.size()? size - prepared.size() : prepared.size() - size) > max_distance)
+            {
+                results[i] = max_distance + 1;
+                continue;
+            }
+#if HAS_SSE2
+            if (batch)
+            {
+                texts[pending]   = data;
+                sizes[pending]   = size;
+                indices[pending] = i;
+                if (++pending == 4)
+                {
+                    detail::myers_distances4(prepared, texts, sizes, distances);
+                    for (int lane=0; lane<4; ++lane)
+                        results[indices[lane]] = (distances[lane] > max_distance)? max_distance + 1 : distances[lane];
+                    pending = 0;
+                }
+                continue;
+            }
+#endif
+            results[i] = prepared.distance(data, size, max_distance);
+        }
+#if HAS_SSE2
+        for (int lane=0; lane<pending; ++lane)
+            results[indices[lane]] = prepared.distance(texts[lane], sizes[lane], max_distance);
+#endif
+    });
+    return results;
+}
+
+template<typename Char, typename Traits, typename Alloc, typename RandomAccessIterator>
+std::vector<std::size_t> edit_distances(basic_immutable_string<Char, Traits, Alloc> const &pattern, RandomAccessIterator first, RandomAccessIterator last, std::size_t max_distance, unsigned threads)
+{
+    return edit_distances(basic_immutable_string_view<Char, Traits, Alloc>(pattern), first, last, max_distance, threads);
+}
+
+// searches for the end of the match, then finds its beginning by comparing
+// the reversed pattern with the text read backwards from the end
+template<typename Char, typename Traits, typename Alloc>
+approximate_match const find_approx(basic_immutable_string_view<Char, Traits, Alloc> const &text, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &pattern, std::size_t max_errors, std::size_t pos)
+{
+    approximate_match match = { std::size_t(-1), 0, 0 };
+    if (pos > text.size())
+        return match;
+    if (pattern.empty())
+    {
+        match.position = pos;
+        return match;
+    }
+
+    bool found = false;
+    std::size_t end = 0;
+    detail::myers_pattern<Char, Traits>(pattern.data(), pattern.size()).run(text.data() + pos, text.size() - pos, 0, [&](std::size_t j, std::size_t score) {
+        if (score <= max_errors  &&  (!found  ||  score < match.errors))
+        {
+            found        = true;
+            match.errors = score;
+            end          = pos + j;
+            return true;
+        }
+        return !found;
+    });
+    if (!found)
+        return match;
+
+    std::vector<Char> const reversed(std::reverse_iterator<Char const *>(pattern.data() + pattern.size()), std::reverse_iterator<Char const *>(pattern.data()));
+    std::size_t const limit = std::min(end - pos, pattern.size() + match.errors);
+    std::size_t errors = pattern.size();
+    detail::myers_pattern<Char, Traits>(reversed.data(), reversed.size()).run(std::reverse_iterator<Char const *>(text.data() + end), limit, 1, [&](std::size_t j, std::size_t score) {
+        if (score < errors)
+        {
+            errors       = score;
+            match.length = j;
+        }
+        return true;
+    });
+    match.position = end - match.length;
+    return match;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+approximate_match const find_approx(basic_immutable_string<Char, Traits, Alloc> const &text, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &pattern, std::size_t max_errors, std::size_t pos)
+{
+    return find_approx(basic_immutable_string_view<Char, Traits, Alloc>(text), pattern, max_errors, pos);
+}
+
+}   // namespace cdmh
@@ -0,0 +1,98 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <vector>
+
+#if HAS_VARIADIC_TEMPLATES
+
+namespace cdmh {
+
+// format() builds a string from a format and arguments in one allocation of
+// exactly the size of the result, or none if it fits in the small string
+// buffer:
+//
+//     auto message = format("{} of {} bytes from {}", read, total, path);
+//
+// {} is replaced by the next argument and {n} by argument n, counting from
+// zero; {{ and }} are a literal brace. the arguments are formatted once,
+// numbers into a buffer on the stack, then measured, and then copied into
+// the result. immutable strings, views, std::basic_strings, C strings and
+// characters are copied from in place; integers and floating point values
+// are formatted as from() formats them, and bool as true or false. a brace
+// that is not part of a replacement throws std::invalid_argument and a
+// replacement for an argument that wasn't passed throws std::out_of_range
+template<typename Char, typename... Args>
+basic_immutable_string<Char> format(Char const *fmt, Args &&...args);
+
+template<typename Char, typename Traits, typename Alloc, typename... Args>
+basic_immutable_string<Char, Traits, Alloc> format(basic_immutable_string<Char, Traits, Alloc> const &fmt, Args &&...args);
+
+// a format that is parsed once when it is constructed, for formatting
+// repeatedly with different arguments:
+//
+//     static string_format const line("{}: {}\n");
+//     auto text = line(name, value);
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_string_format
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc> string_type;
+    typedef std::size_t                                 size_type;
+
+    explicit basic_string_format(string_type const &fmt);
+    explicit basic_string_format(Char const *fmt) : basic_string_format(string_type(fmt)) { }
+
+    template<typename... Args>
+    string_type operator()(Args &&...args)                                              const;
+
+    string_type const &str(void)                                                       const noexcept { return format_;    }
+    size_type   const  arguments(void)                                                 const noexcept { return arguments_; }    // the number of arguments it uses
+
+  private:
+    static size_type const text = (size_type)-1;
+
+    struct segment
+    {
+        size_type argument;     // the argument to copy, or text
+        size_type offset;       // the text to copy from the format
+        size_type length;
+    };
+
+    string_type          format_;
+    std::vector<segment> segments_;
+    size_type            text_size_;    // the number of characters copied from the format
+    size_type            arguments_;
+};
+
+typedef basic_string_format<char>    string_format;
+typedef basic_string_format<wchar_t> wstring_format;
+
+}   // namespace cdmh
+
+#include "immutable_string_format.inl"
+
+#endif  // HAS_VARIADIC_TEMPLATES
@@ -0,0 +1,241 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+namespace detail {
+
+// an argument of format() as characters: a reference to the characters of
+// a string argument, or a number formatted into the buffer
+template<typename Char>
+struct format_argument
+{
+    Char const  *data;
+    std::size_t  size;
+    Char         buffer[64];
+};
+
+template<typename Char, typename Traits, typename Alloc>
+void prepare_argument(format_argument<Char> &argument, basic_immutable_string<Char, Traits, Alloc> const &str) noexcept
+{
+    argument.data = str.data();
+    argument.size = str.size();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void prepare_argument(format_argument<Char> &argument, basic_immutable_string_view<Char, Traits, Alloc> const &view) noexcept
+{
+    argument.data = view.data();
+    argument.size = view.size();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void prepare_argument(format_argument<Char> &argument, std::basic_string<Char, Traits, Alloc> const &str) noexcept
+{
+    argument.data = str.data();
+    argument.size = str.size();
+}
+
+// only an array of const characters is a literal; any other array is a
+// buffer, which is measured as a C string by the overload for pointers
+template<typename Char, typename T, std::size_t N>
+typename if_literal<T, Char, void>::type prepare_argument(format_argument<Char> &argument, T (&s)[N]) noexcept
+{
+    argument.data = s;
+    argument.size = literal_length<std::char_traits<Char>>(s);
+}
+
+template<typename Char, typename T>
+typename if_c_string<T, Char, void>::type prepare_argument(format_argument<Char> &argument, T s) noexcept
+{
+    argument.data = s;
+    argument.size = std::char_traits<Char>::length(s);
+}
+
+template<typename Char>
+void prepare_argument(format_argument<Char> &argument, Char c) noexcept
+{
+    argument.buffer[0] = c;
+    argument.data      = argument.buffer;
+    argument.size      = 1;
+}
+
+template<typename Char>
+void prepare_argument(format_argument<Char> &argument, bool value) noexcept
+{
+    char const *const text = value? "true" : "false";
+    argument.size = value? 4 : 5;
+    std::copy(text, text + argument.size, argument.buffer);
+    argument.data = argument.buffer;
+}
+
+template<typename Char, typename T>
+typename if_number<T, void>::type prepare_argument(format_argument<Char> &argument, T value)
+{
+    Char *const end = argument.buffer + sizeof(argument.buffer) / sizeof(Char);
+    argument.data = format_number(value, end, std::is_integral<T>());
+    argument.size = static_cast<std::size_t>(end - argument.data);
+}
+
+template<typename Char, typename... Args>
+void prepare_arguments(format_argument<Char> *arguments, Args &&...args)
+{
+    int const expand[] = { 0, (prepare_argument(*arguments++, args), 0)... };
+    (void)expand;
+    (void)arguments;    // unused if there are no arguments
+}
+
+// call text(offset, length) for each run of characters of the format to be
+// copied, and argument(index) for each replacement, in order
+template<typename Char, typename Traits, typename Text, typename Argument>
+void parse_format(Char const *fmt, std::size_t n, Text text, Argument argument)
+{
+    std::size_t next  = 0;  // the argument of the next {}
+    std::size_t start = 0;  // the first character not yet passed to text()
+    for (std::size_t i=0; i<n; ++i)
+    {
+        if (Traits::eq(fmt[i], Char('{'))  &&  i + 1 < n  &&  Traits::eq(fmt[i + 1], Char('{')))
+        {
+            text(start, i + 1 - start);
+            start = ++i + 1;
+        }
+        else if (Traits::eq(fmt[i], Char('{')))
+        {
+            if (i != start)
+                text(start, i - start);
+
+            std::size_t j = i + 1;
+            std::size_t index = 0;
+            for (; j < n  &&  fmt[j] >= Char('0')  &&  fmt[j] <= Char('9'); ++j)
+            {
+                if (index > (std::numeric_limits<std::size_t>::max() - 9) / 10)
+                    throw std::out_of_range("format");
+                index = index * 10 + static_cast<std::size_t>(fmt[j] - Char('0'));
+            }
+            if (j == n  ||  !Traits::eq(fmt[j], Char('}')))
+                throw std::invalid_argument("format");
+
+            argument((j == i + 1)? next++ : index);
+            i = j;
+            start = j + 1;
+        }
+        else if (Traits::eq(fmt[i], Char('}')))
+        {
+            if (i + 1 == n  ||  !Traits::eq(fmt[i + 1], Char('}')))
+                throw std::invalid_argument("format");
+            text(start, i + 1 - start);
+            start = ++i + 1;
+        }
+    }
+    if (start != n)
+        text(start, n - start);
+}
+
+template<typename Char, typename Traits, typename Alloc, typename... Args>
+basic_immutable_string<Char, Traits, Alloc> format(Char const *fmt, std::size_t n, Alloc const &alloc, Args &&...args)
+{
+    std::size_t const count = sizeof...(Args);
+    format_argument<Char> arguments[count + 1];     // one more, as an array can't be empty
+    prepare_arguments(arguments, args...);
+
+    std::size_t size = 0;
+    parse_format<Char, Traits>(fmt, n,
+        [&size](std::size_t, std::size_t length) { size += length; },
+        [&size, &arguments, count](std::size_t index) {
+            if (index >= count)
+                throw std::out_of_range("format");
+            size += arguments[index].size;
+        });
+
+    std::basic_string<Char, Traits, Alloc> result(alloc);
+    result.reserve(size);
+    parse_format<Char, Traits>(fmt, n,
+        [&result, fmt](std::size_t offset, std::size_t length) { result.append(fmt + offset, length); },
+        [&result, &arguments](std::size_t index) { result.append(arguments[index].data, arguments[index].size); });
+    return basic_immutable_string<Char, Traits, Alloc>(std::move(result));
+}
+
+}   // namespace detail
+
+template<typename Char, typename... Args>
+basic_immutable_string<Char> format(Char const *fmt, Args &&...args)
+{
+    return detail::format<Char, std::char_traits<Char>>(fmt, std::char_traits<Char>::length(fmt), std::allocator<Char>(), args...);
+}
+
+template<typename Char, typename Traits, typename Alloc, typename... Args>
+basic_immutable_string<Char, Traits, Alloc> format(basic_immutable_string<Char, Traits, Alloc> const &fmt, Args &&...args)
+{
+    return detail::format<Char, Traits>(fmt.data(), fmt.size(), fmt.get_allocator(), args...);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_string_format<Char, Traits, Alloc>::basic_string_format(string_type const &fmt)
+  : format_(fmt), text_size_(0), arguments_(0)
+{
+    detail::parse_format<Char, Traits>(format_.data(), format_.size(),
+        [this](size_type offset, size_type length) {
+            segment const text_segment = { text, offset, length };
+            segments_.push_back(text_segment);
+            text_size_ += length;
+        },
+        [this](size_type index) {
+            segment const argument_segment = { index, 0, 0 };
+            segments_.push_back(argument_segment);
+            arguments_ = std::max(arguments_, index + 1);
+        });
+}
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename... Args>
+typename basic_string_format<Char, Traits, Alloc>::string_type
+basic_string_format<Char, Traits, Alloc>::operator()(Args &&...args) const
+{
+    std::size_t const count = sizeof...(Args);
+    if (arguments_ > count)
+        throw std::out_of_range("format");
+
+    detail::format_argument<Char> arguments[count + 1];
+    detail::prepare_arguments(arguments, args...);
+
+    size_type size = text_size_;
+    for (auto const &segment : segments_)
+    {
+        if (segment.argument != text)
+            size += arguments[segment.argument].size;
+    }
+
+    std::basic_string<Char, Traits, Alloc> result(format_.get_allocator());
+    result.reserve(size);
+    for (auto const &segment : segments_)
+    {
+        if (segment.argument == text)
+            result.append(format_.data() + segment.offset, segment.length);
+        else
+            result.append(arguments[segment.argument].data, arguments[segment.argument].size);
+    }
+    return string_type(std::move(result));
+}
+
+}   // namespace cdmh
@@ -0,0 +1,67 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <thread>
+#include <vector>
+
+namespace cdmh {
+
+namespace detail {
+
+// prevents a parameter taking part in template argument deduction, so that
+// it converts to the type deduced from the others
+template<typename T>
+struct non_deduced
+{
+    typedef T type;
+};
+
+}   // namespace detail
+
+// searches of very large strings on up to threads threads, or one per
+// processor if threads is zero. the haystack is divided into chunks of the
+// positions where a match could begin, and each chunk is searched to the
+// end of any match that begins within it, so that a match that straddles a
+// boundary between chunks is found once, by the chunk it begins in. the
+// characters never change, so the threads share them without locks.
+// matches are found at every position, so they may overlap, and results
+// are in ascending order
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_find(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, std::size_t pos=0, unsigned threads=0);
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_find(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, std::size_t pos=0, unsigned threads=0);
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_count(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads=0);
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_count(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads=0);
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<std::size_t> parallel_find_all(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads=0);
+template<typename Char, typename Traits, typename Alloc>
+std::vector<std::size_t> parallel_find_all(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads=0);
+
+}   // namespace cdmh
+
+#include "immutable_string_parallel.inl"
@@ -0,0 +1,311 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace cdmh {
+
+namespace detail {
+
+// the threads that run_parallel() shares out work to. they are started as
+// they are first needed and then kept, so that a search costs no thread
+// creation. the pool is never destroyed, so that its threads can't be left
+// waiting on a destroyed condition when the process exits
+class thread_pool
+{
+  public:
+    static thread_pool &instance(void)
+    {
+        static thread_pool *const pool = new thread_pool;
+        return *pool;
+    }
+
+    // runs job on a thread of the pool, first starting threads until there
+    // are at least the given number
+    void submit(std::function<void ()> job, std::size_t threads)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (; threads_ < threads; ++threads_)
+            std::thread(&thread_pool::work, this).detach();
+        jobs_.push_back(std::move(job));
+        ready_.notify_one();
+    }
+
+  private:
+    thread_pool() : threads_(0) { }
+
+    void work(void)
+    {
+        for (;;)
+        {
+            std::function<void ()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this]{ return !jobs_.empty(); });
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex                          mutex_;
+    std::condition_variable             ready_;
+    std::deque<std::function<void ()>>  jobs_;
+    std::size_t                         threads_;
+};
+
+// tasks taken in order by each thread that calls run(). once a task throws,
+// the tasks not yet started are skipped, and wait() rethrows the exception
+// when every task has been accounted for. a thread of the pool that starts
+// after the tasks have run finds none left, so never calls fn
+class parallel_tasks
+{
+  public:
+    parallel_tasks(std::size_t count, std::function<void (std::size_t)> fn)
+      : next_(0), count_(count), done_(0), failed_(false), fn_(std::move(fn))
+    {
+    }
+
+    void run(void)
+    {
+        for (std::size_t task; (task = next_++) < count_;)
+        {
+            if (!failed_.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    fn_(task);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!error_)
+                        error_ = std::current_exception();
+                    failed_ = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (++done_ == count_)
+                finished_.notify_all();
+        }
+    }
+
+    void wait(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this]{ return done_ == count_; });
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+  private:
+    std::atomic<std::size_t>            next_;
+    std::size_t const                   count_;
+    std::size_t                         done_;
+    std::atomic<bool>                   failed_;
+    std::exception_ptr                  error_;
+    std::function<void (std::size_t)>   fn_;
+    std::mutex                          mutex_;
+    std::condition_variable             finished_;
+};
+
+// calls fn(0) .. fn(tasks - 1) on up to threads threads, this one and those
+// of the pool. tasks are started in order. the first exception thrown by fn
+// is rethrown once no thread is still running a task
+template<typename Function>
+void run_parallel(std::size_t tasks, unsigned threads, Function fn)
+{
+    std::size_t const helpers = std::min<std::size_t>(threads, tasks);
+    if (helpers <= 1)
+    {
+        for (std::size_t task=0; task<tasks; ++task)
+            fn(task);
+        return;
+    }
+
+    // the pool's threads share ownership of the tasks, as one may not start
+    // its job until after this call has returned. if a thread can't be
+    // started or given its job, this one runs the tasks that it would have
+    auto const work = std::make_shared<parallel_tasks>(tasks, [&fn](std::size_t task) { fn(task); });
+    try
+    {
+        for (std::size_t i=1; i<helpers; ++i)
+            thread_pool::instance().submit([work]{ work->run(); }, helpers - 1);
+    }
+    catch (...)
+    {
+    }
+    work->run();
+    work->wait();
+}
+
+// the positions at which a match can begin, divided into chunks. there are
+// several chunks a thread, so that a search can stop early and the threads
+// stay busy if some chunks take longer than others
+class search_chunks
+{
+  public:
+    enum { min_chunk = 256 * 1024 };
+
+    search_chunks(std::size_t haystack, std::size_t needle, std::size_t pos, unsigned threads)
+      : threads_(threads? threads : std::max(1u, std::thread::hardware_concurrency())),
+        first_(pos),
+        last_((pos <= haystack  &&  needle <= haystack - pos)? haystack - needle + 1 : pos),
+        size_(std::max<std::size_t>(min_chunk, (last_ - first_) / (threads_ * 8) + 1)),
+        count_((last_ - first_ + size_ - 1) / size_)
+    {
+    }
+
+    unsigned    const threads(void)                                                    const { return threads_; }
+    std::size_t const count(void)                                                      const { return count_; }
+    std::size_t const begin(std::size_t chunk)                                         const { return first_ + chunk * size_; }
+    std::size_t const end(std::size_t chunk)                                           const { return std::min(begin(chunk) + size_, last_); }
+
+  private:
+    unsigned    const threads_;
+    std::size_t const first_;
+    std::size_t const last_;
+    std::size_t const size_;
+    std::size_t const count_;
+};
+
+// the first match of needle that begins in [begin, end), or npos
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const find_in_chunk(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, basic_immutable_string_view<Char, Traits, Alloc> const &needle, std::size_t begin, std::size_t end)
+{
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+
+    if (begin >= end)
+        return view_type::npos;
+    view_type const window(haystack.data() + begin, end - 1 + needle.size() - begin);
+    std::size_t const found = window.find(needle);
+    return (found == view_type::npos)? view_type::npos : begin + found;
+}
+
+// calls fn with the position of each match that begins in [begin, end)
+template<typename Char, typename Traits, typename Alloc, typename Function>
+void for_each_match(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, basic_immutable_string_view<Char, Traits, Alloc> const &needle, std::size_t begin, std::size_t end, Function fn)
+{
+    for (std::size_t found; (found = find_in_chunk(haystack, needle, begin, end)) != basic_immutable_string_view<Char, Traits, Alloc>::npos; begin = found + 1)
+        fn(found);
+}
+
+}   // namespace detail
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_find(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, std::size_t pos, unsigned threads)
+{
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+
+    detail::search_chunks const chunks(haystack.size(), needle.size(), pos, threads);
+    if (needle.empty()  ||  chunks.count() < 2  ||  chunks.threads() == 1)
+        return haystack.find(needle, pos);
+
+    // chunks start in order, so one that begins after a match has been
+    // found cannot find an earlier one
+    std::atomic<std::size_t> first(view_type::npos);
+    detail::run_parallel(chunks.count(), chunks.threads(), [&](std::size_t chunk) {
+        if (chunks.begin(chunk) > first.load(std::memory_order_relaxed))
+            return;
+        std::size_t const found = detail::find_in_chunk(haystack, needle, chunks.begin(chunk), chunks.end(chunk));
+        std::size_t current = first.load(std::memory_order_relaxed);
+        while (found < current  &&  !first.compare_exchange_weak(current, found, std::memory_order_relaxed))
+            ;
+    });
+    return first.load();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_find(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, std::size_t pos, unsigned threads)
+{
+    return parallel_find(basic_immutable_string_view<Char, Traits, Alloc>(haystack), needle, pos, threads);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_count(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads)
+{
+    if (needle.empty())
+        return haystack.size() + 1;
+
+    detail::search_chunks const chunks(haystack.size(), needle.size(), 0, threads);
+    std::vector<std::size_t> counts(chunks.count());
+    detail::run_parallel(chunks.count(), chunks.threads(), [&](std::size_t chunk) {
+        std::size_t count = 0;
+        detail::for_each_match(haystack, needle, chunks.begin(chunk), chunks.end(chunk), [&count](std::size_t) { ++count; });
+        counts[chunk] = count;
+    });
+
+    std::size_t total = 0;
+    for (auto count : counts)
+        total += count;
+    return total;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const parallel_count(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads)
+{
+    return parallel_count(basic_immutable_string_view<Char, Traits, Alloc>(haystack), needle, threads);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<std::size_t> parallel_find_all(basic_immutable_string_view<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads)
+{
+    std::vector<std::size_t> result;
+    if (needle.empty())
+    {
+        for (std::size_t pos=0; pos<=haystack.size(); ++pos)
+            result.push_back(pos);
+        return result;
+    }
+
+    detail::search_chunks const chunks(haystack.size(), needle.size(), 0, threads);
+    std::vector<std::vector<std::size_t>> found(chunks.count());
+    detail::run_parallel(chunks.count(), chunks.threads(), [&](std::size_t chunk) {
+        std::vector<std::size_t> &positions = found[chunk];
+        detail::for_each_match(haystack, needle, chunks.begin(chunk), chunks.end(chunk), [&positions](std::size_t pos) { positions.push_back(pos); });
+    });
+
+    std::size_t total = 0;
+    for (auto const &positions : found)
+        total += positions.size();
+    result.reserve(total);
+    for (auto const &positions : found)
+        result.insert(result.end(), positions.begin(), positions.end());
+    return result;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::vector<std::size_t> parallel_find_all(basic_immutable_string<Char, Traits, Alloc> const &haystack, typename detail::non_deduced<basic_immutable_string_view<Char, Traits, Alloc>>::type const &needle, unsigned threads)
+{
+    return parallel_find_all(basic_immutable_string_view<Char, Traits, Alloc>(haystack), needle, threads);
+}
+
+}   // namespace cdmh
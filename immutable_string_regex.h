@@ -0,0 +1,149 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace cdmh {
+
+// a regular expression matched in time linear in the length of the text,
+// by simulating all of the ways through the pattern at once (a Pike VM)
+// rather than backtracking, so no pattern can take exponential time. the
+// syntax is a subset of ECMAScript:
+//
+//     .  [abc]  [^a-z]  \d \w \s \D \W \S  \n \r \t \f \v  \. \\ etc
+//     ^  $                    the beginning and end of the text
+//     (...)  (?:...)          grouping; groups do not capture
+//     a|b  a*  a+  a?  a{n}  a{n,}  a{n,m}, and a lazy form of each with ?
+//
+// find() returns the leftmost match, and among matches there the one that
+// a backtracking matcher would find, as a view of the text; no match is a
+// view whose data() is nullptr. the views refer to the text passed, which
+// must outlive them. a syntax error throws std::invalid_argument
+//
+// compiling a pattern costs far more than matching a short string, so
+// cached() keeps the most recently used compiled patterns, keyed by the
+// pattern, in a cache shared by all threads:
+//
+//     if (!string_regex::cached("[0-9]{4}-[0-9]{2}-[0-9]{2}")->matches(field))
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_string_regex
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc>      string_type;
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+    typedef std::size_t                                      size_type;
+
+    static size_type const npos = (size_type)-1;
+
+    explicit basic_string_regex(string_type const &pattern);
+    explicit basic_string_regex(Char const *pattern) : basic_string_regex(string_type(pattern)) { }
+
+    // the compiled pattern from the cache, compiling and adding it if it
+    // isn't there
+    static std::shared_ptr<basic_string_regex const> cached(string_type const &pattern);
+    static void        set_cache_capacity(std::size_t patterns);
+    static std::size_t cache_capacity(void);
+
+    string_type const &pattern(void)                                                   const noexcept { return pattern_; }
+
+    // whether the whole text matches, or some part of it
+    bool      const matches(view_type const &text)                                     const;
+    bool      const contains(view_type const &text)                                    const          { return find(text).data() != nullptr; }
+
+    // the first match that starts at or after pos, and every match that
+    // doesn't overlap the one before it
+    view_type              find(view_type const &text, size_type pos=0)                const;
+    std::vector<view_type> find_all(view_type const &text)                             const;
+
+  private:
+    class cache;
+    class compiler;
+
+    typedef typename std::make_unsigned<Char>::type unsigned_char;
+
+    enum opcode { op_char, op_any, op_class, op_split, op_jump, op_begin, op_end, op_match };
+
+    struct instruction
+    {
+        opcode    code;
+        Char      c;        // op_char
+        size_type x;        // op_class: the class; op_split and op_jump: the preferred target
+        size_type y;        // op_split: the other target
+    };
+
+    struct char_class
+    {
+        bool                                                      negated;
+        bool                                                      ascii[128];
+        std::vector<std::pair<unsigned long, unsigned long>>      ranges;     // inclusive, beyond ASCII
+
+        bool const contains(unsigned long c)                                           const;
+    };
+
+    struct thread
+    {
+        size_type pc;
+        size_type start;
+    };
+
+    // the lists run() works in, kept by each thread and reused from one
+    // match to the next so that matching a short field does not allocate
+    struct scratch
+    {
+        std::vector<thread>    current;
+        std::vector<thread>    next;
+        std::vector<size_type> marks;
+        std::vector<size_type> stack;
+    };
+
+    static scratch &local_scratch(void);
+
+    bool const accepts(instruction const &inst, Char c)                               const;
+    void       add(std::vector<thread> &list, std::vector<size_type> &marks, std::vector<size_type> &stack,
+                   size_type pc, size_type start, size_type pos, size_type size)      const;
+    bool const run(Char const *text, size_type size, size_type from, bool anchored, bool whole,
+                   size_type &match_start, size_type &match_end)                      const;
+
+    string_type              pattern_;
+    std::vector<instruction> program_;
+    std::vector<char_class>  classes_;
+};
+
+typedef basic_string_regex<char>    string_regex;
+typedef basic_string_regex<wchar_t> wstring_regex;
+
+}   // namespace cdmh
+
+#include "immutable_string_regex.inl"
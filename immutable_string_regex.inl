@@ -0,0 +1,679 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+// parses a pattern into a tree of nodes, held in a vector and linked by
+// index, and then generates the program from the tree. a counted
+// repetition copies the code of what it repeats, so the counts and the
+// size of the program are limited
+template<typename Char, typename Traits, typename Alloc>
+class basic_string_regex<Char, Traits, Alloc>::compiler
+{
+  public:
+    compiler(Char const *pattern, size_type size, std::vector<instruction> &program, std::vector<char_class> &classes)
+      : pattern_(pattern), size_(size), pos_(0), program_(program), classes_(classes)
+    {
+    }
+
+    void compile(void)
+    {
+        size_type const root = parse_alternation();
+        if (pos_ != size_)
+            error("unmatched )");
+        emit(root);
+        instruction const match = { op_match, Char(), 0, 0 };
+        program_.push_back(match);
+    }
+
+  private:
+    enum kind { node_char, node_any, node_class, node_begin, node_end, node_concat, node_alternate, node_repeat };
+    enum { max_repeat = 1000, max_program = 64 * 1024 };
+
+    struct node
+    {
+        kind                   type;
+        Char                   c;          // node_char
+        size_type              index;      // node_class: the class
+        size_type              min, max;   // node_repeat; max is npos if unbounded
+        bool                   greedy;
+        std::vector<size_type> children;
+    };
+
+    static void error(char const *message)
+    {
+        throw std::invalid_argument(std::string("invalid regular expression: ") + message);
+    }
+
+    static unsigned long const value(Char c) noexcept { return static_cast<unsigned long>(static_cast<unsigned_char>(c)); }
+
+    bool const at(char c)                                                              const noexcept { return pos_ != size_  &&  Traits::eq(pattern_[pos_], Char(c)); }
+    bool const eat(char c)                                                                   noexcept { return at(c)? (++pos_, true) : false; }
+
+    size_type add(kind type)
+    {
+        node n;
+        n.type   = type;
+        n.c      = Char();
+        n.index  = 0;
+        n.min    = n.max = 0;
+        n.greedy = true;
+        nodes_.push_back(n);
+        return nodes_.size() - 1;
+    }
+
+    size_type parse_alternation(void)
+    {
+        size_type const first = parse_concat();
+        if (!at('|'))
+            return first;
+
+        std::vector<size_type> children(1, first);
+        while (eat('|'))
+            children.push_back(parse_concat());
+        size_type const alternate = add(node_alternate);
+        nodes_[alternate].children.swap(children);
+        return alternate;
+    }
+
+    size_type parse_concat(void)
+    {
+        std::vector<size_type> children;
+        while (pos_ != size_  &&  !at('|')  &&  !at(')'))
+            children.push_back(parse_repeat());
+        if (children.size() == 1)
+            return children[0];
+
+        size_type const concat = add(node_concat);
+        nodes_[concat].children.swap(children);
+        return concat;
+    }
+
+    size_type parse_repeat(void)
+    {
+        size_type const atom = parse_atom();
+        size_type min, max;
+        if (eat('*'))
+            min = 0, max = npos;
+        else if (eat('+'))
+            min = 1, max = npos;
+        else if (eat('?'))
+            min = 0, max = 1;
+        else if (eat('{'))
+            parse_count(min, max);
+        else
+            return atom;
+
+        size_type const repeat = add(node_repeat);
+        nodes_[repeat].min    = min;
+        nodes_[repeat].max    = max;
+        nodes_[repeat].greedy = !eat('?');
+        nodes_[repeat].children.push_back(atom);
+        if (at('*')  ||  at('+')  ||  at('?')  ||  at('{'))
+            error("nothing to repeat");
+        return repeat;
+    }
+
+    size_type parse_number(void)
+    {
+        if (pos_ == size_  ||  pattern_[pos_] < Char('0')  ||  pattern_[pos_] > Char('9'))
+            error("expected a number in {}");
+        size_type number = 0;
+        while (pos_ != size_  &&  pattern_[pos_] >= Char('0')  &&  pattern_[pos_] <= Char('9'))
+        {
+            number = number * 10 + static_cast<size_type>(pattern_[pos_++] - Char('0'));
+            if (number > max_repeat)
+                error("repetition count too large");
+        }
+        return number;
+    }
+
+    void parse_count(size_type &min, size_type &max)
+    {
+        min = max = parse_number();
+        if (eat(','))
+            max = at('}')? npos : parse_number();
+        if (!eat('}'))
+            error("missing }");
+        if (max < min)
+            error("repetition counts out of order");
+    }
+
+    size_type parse_atom(void)
+    {
+        if (at('*')  ||  at('+')  ||  at('?')  ||  at('{'))
+            error("nothing to repeat");
+
+        Char const c = pattern_[pos_++];
+        if (Traits::eq(c, Char('(')))
+        {
+            if (eat('?')  &&  !eat(':'))
+                error("only (?: groups are supported");
+            size_type const group = parse_alternation();
+            if (!eat(')'))
+                error("missing )");
+            return group;
+        }
+        else if (Traits::eq(c, Char('[')))
+            return parse_class();
+        else if (Traits::eq(c, Char('.')))
+            return add(node_any);
+        else if (Traits::eq(c, Char('^')))
+            return add(node_begin);
+        else if (Traits::eq(c, Char('$')))
+            return add(node_end);
+
+        Char literal = c;
+        if (Traits::eq(c, Char('\\')))
+        {
+            char_class cls = new_class(false);
+            if (class_escape(cls))
+            {
+                size_type const n = add(node_class);
+                nodes_[n].index = classes_.size();
+                classes_.push_back(cls);
+                return n;
+            }
+            literal = escape();
+        }
+        size_type const n = add(node_char);
+        nodes_[n].c = literal;
+        return n;
+    }
+
+    static char_class new_class(bool negated)
+    {
+        char_class cls;
+        cls.negated = negated;
+        std::fill(cls.ascii, cls.ascii + 128, false);
+        return cls;
+    }
+
+    static void add_range(char_class &cls, unsigned long lo, unsigned long hi)
+    {
+        for (unsigned long c=lo; c<=hi  &&  c<128; ++c)
+            cls.ascii[c] = true;
+        if (hi >= 128)
+            cls.ranges.push_back(std::make_pair(std::max(lo, 128ul), hi));
+    }
+
+    // \d, \w and \s and their complements. the ranges of each set are in
+    // order, so a complement is the gaps between them
+    bool class_escape(char_class &cls)
+    {
+        if (pos_ == size_)
+            error("\\ at end of pattern");
+
+        static unsigned long const digits[][2] = { { '0', '9' } };
+        static unsigned long const words[][2]  = { { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } };
+        static unsigned long const spaces[][2] = { { '\t', '\r' }, { ' ', ' ' } };
+
+        unsigned long const (*set)[2];
+        std::size_t count;
+        unsigned long const e = value(pattern_[pos_]);
+        switch (e)
+        {
+            case 'd': case 'D': set = digits; count = 1; break;
+            case 'w': case 'W': set = words;  count = 4; break;
+            case 's': case 'S': set = spaces; count = 2; break;
+            default:  return false;
+        }
+        ++pos_;
+
+        if (e == 'd'  ||  e == 'w'  ||  e == 's')
+        {
+            for (std::size_t i=0; i<count; ++i)
+                add_range(cls, set[i][0], set[i][1]);
+        }
+        else
+        {
+            unsigned long lo = 0;
+            for (std::size_t i=0; i<count; ++i)
+            {
+                if (set[i][0] > lo)
+                    add_range(cls, lo, set[i][0] - 1);
+                lo = set[i][1] + 1;
+            }
+            add_range(cls, lo, std::numeric_limits<unsigned_char>::max());
+        }
+        return true;
+    }
+
+    // the character of an escape that isn't a class
+    Char escape(void)
+    {
+        if (pos_ == size_)
+            error("\\ at end of pattern");
+
+        Char const e = pattern_[pos_++];
+        switch (value(e))
+        {
+            case 'n': return Char('\n');
+            case 'r': return Char('\r');
+            case 't': return Char('\t');
+            case 'f': return Char('\f');
+            case 'v': return Char('\v');
+            case '0': return Char();
+        }
+        if (value(e) < 128  &&  std::isalnum(static_cast<int>(value(e))))
+            error("unknown escape");
+        return e;
+    }
+
+    size_type parse_class(void)
+    {
+        char_class cls = new_class(eat('^'));
+        for (bool first=true; ; first=false)
+        {
+            if (pos_ == size_)
+                error("missing ]");
+            if (!first  &&  eat(']'))
+                break;
+
+            unsigned long lo;
+            if (eat('\\'))
+            {
+                if (class_escape(cls))
+                    continue;
+                lo = value(escape());
+            }
+            else
+                lo = value(pattern_[pos_++]);
+
+            unsigned long hi = lo;
+            if (at('-')  &&  pos_ + 1 != size_  &&  !Traits::eq(pattern_[pos_ + 1], Char(']')))
+            {
+                ++pos_;
+                hi = eat('\\')? value(escape()) : value(pattern_[pos_++]);
+                if (hi < lo)
+                    error("character range out of order");
+            }
+            add_range(cls, lo, hi);
+        }
+
+        size_type const n = add(node_class);
+        nodes_[n].index = classes_.size();
+        classes_.push_back(cls);
+        return n;
+    }
+
+    size_type push(opcode code, size_type x=0, size_type y=0)
+    {
+        if (program_.size() == max_program)
+            error("pattern too large");
+        instruction const inst = { code, Char(), x, y };
+        program_.push_back(inst);
+        return program_.size() - 1;
+    }
+
+    // a split prefers x, so a lazy repetition swaps its targets
+    void patch_split(size_type split, size_type repeat, size_type next, bool greedy)
+    {
+        program_[split].x = greedy? repeat : next;
+        program_[split].y = greedy? next : repeat;
+    }
+
+    void emit(size_type index)
+    {
+        node const &n = nodes_[index];
+        switch (n.type)
+        {
+            case node_char:    program_[push(op_char)].c = n.c; break;
+            case node_any:     push(op_any);                    break;
+            case node_class:   push(op_class, n.index);         break;
+            case node_begin:   push(op_begin);                  break;
+            case node_end:     push(op_end);                    break;
+
+            case node_concat:
+                for (auto child : n.children)
+                    emit(child);
+                break;
+
+            case node_alternate:
+            {
+                std::vector<size_type> jumps;
+                for (std::size_t i=0; i<n.children.size(); ++i)
+                {
+                    if (i + 1 == n.children.size())
+                    {
+                        emit(n.children[i]);
+                        break;
+                    }
+                    size_type const split = push(op_split);
+                    emit(n.children[i]);
+                    jumps.push_back(push(op_jump));
+                    patch_split(split, split + 1, program_.size(), true);
+                }
+                for (auto jump : jumps)
+                    program_[jump].x = program_.size();
+                break;
+            }
+
+            case node_repeat:
+            {
+                size_type const child = n.children[0];
+                if (n.max == npos  &&  n.min == 0)
+                {
+                    // L: split body, next; body; jump L
+                    size_type const split = push(op_split);
+                    emit(child);
+                    push(op_jump, split);
+                    patch_split(split, split + 1, program_.size(), n.greedy);
+                }
+                else if (n.max == npos)
+                {
+                    // body min-1 times, then L: body; split L, next
+                    for (size_type i=1; i<n.min; ++i)
+                        emit(child);
+                    size_type const body = program_.size();
+                    emit(child);
+                    size_type const split = push(op_split);
+                    patch_split(split, body, split + 1, n.greedy);
+                }
+                else
+                {
+                    // body min times, then max-min optional bodies, each
+                    // of which skips to the end if it is not taken
+                    for (size_type i=0; i<n.min; ++i)
+                        emit(child);
+                    std::vector<size_type> splits;
+                    for (size_type i=n.min; i<n.max; ++i)
+                    {
+                        splits.push_back(push(op_split));
+                        emit(child);
+                    }
+                    for (auto split : splits)
+                        patch_split(split, split + 1, program_.size(), n.greedy);
+                }
+                break;
+            }
+        }
+    }
+
+    Char const               *pattern_;
+    size_type                 size_;
+    size_type                 pos_;
+    std::vector<node>         nodes_;
+    std::vector<instruction> &program_;
+    std::vector<char_class>  &classes_;
+};
+
+// least recently used cache of compiled patterns, keyed by pattern
+template<typename Char, typename Traits, typename Alloc>
+class basic_string_regex<Char, Traits, Alloc>::cache
+{
+  public:
+    static cache &instance(void)
+    {
+        static cache the_cache;
+        return the_cache;
+    }
+
+    std::shared_ptr<basic_string_regex const> find(string_type const &pattern)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(pattern);
+        if (it == index_.end())
+            return std::shared_ptr<basic_string_regex const>();
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return *it->second;
+    }
+
+    void insert(std::shared_ptr<basic_string_regex const> const &regex)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0  ||  index_.find(regex->pattern()) != index_.end())
+            return;
+        entries_.push_front(regex);
+        index_.insert(std::make_pair(regex->pattern(), entries_.begin()));
+        evict();
+    }
+
+    void capacity(std::size_t patterns)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = patterns;
+        evict();
+    }
+
+    std::size_t const capacity(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+  private:
+    typedef std::list<std::shared_ptr<basic_string_regex const>> entries_type;
+
+    cache() : capacity_(256) { }
+
+    void evict(void)
+    {
+        while (entries_.size() > capacity_)
+        {
+            index_.erase(entries_.back()->pattern());
+            entries_.pop_back();
+        }
+    }
+
+    std::mutex                                                       mutex_;
+    std::size_t                                                      capacity_;
+    entries_type                                                     entries_;
+    std::unordered_map<string_type, typename entries_type::iterator> index_;
+};
+
+template<typename Char, typename Traits, typename Alloc>
+basic_string_regex<Char, Traits, Alloc>::basic_string_regex(string_type const &pattern)
+  : pattern_(pattern)
+{
+    compiler(pattern_.data(), pattern_.size(), program_, classes_).compile();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::shared_ptr<basic_string_regex<Char, Traits, Alloc> const>
+basic_string_regex<Char, Traits, Alloc>::cached(string_type const &pattern)
+{
+    cache &c = cache::instance();
+    auto regex = c.find(pattern);
+    if (!regex)
+    {
+        regex = std::make_shared<basic_string_regex const>(pattern);
+        c.insert(regex);
+    }
+    return regex;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_regex<Char, Traits, Alloc>::set_cache_capacity(std::size_t patterns)
+{
+    cache::instance().capacity(patterns);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t basic_string_regex<Char, Traits, Alloc>::cache_capacity(void)
+{
+    return cache::instance().capacity();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_string_regex<Char, Traits, Alloc>::char_class::contains(unsigned long c) const
+{
+    bool found = (c < 128)? ascii[c] : false;
+    for (std::size_t i=0; !found  &&  i<ranges.size(); ++i)
+        found = (c >= ranges[i].first  &&  c <= ranges[i].second);
+    return found != negated;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_string_regex<Char, Traits, Alloc>::accepts(instruction const &inst, Char c) const
+{
+    switch (inst.code)
+    {
+        case op_char:  return Traits::eq(inst.c, c);
+        case op_any:   return !Traits::eq(c, Char('\n'));
+        case op_class: return classes_[inst.x].contains(static_cast<unsigned long>(static_cast<unsigned_char>(c)));
+        default:       return false;
+    }
+}
+
+// add the thread at pc to the list for position pos, following jumps,
+// splits and assertions, which consume no characters, in order of
+// preference. marks[pc] == pos if pc is already in the list
+template<typename Char, typename Traits, typename Alloc>
+void basic_string_regex<Char, Traits, Alloc>::add(std::vector<thread> &list, std::vector<size_type> &marks, std::vector<size_type> &stack,
+                                                  size_type pc, size_type start, size_type pos, size_type size) const
+{
+    stack.push_back(pc);
+    while (!stack.empty())
+    {
+        pc = stack.back();
+        stack.pop_back();
+        if (marks[pc] == pos)
+            continue;
+        marks[pc] = pos;
+
+        instruction const &inst = program_[pc];
+        switch (inst.code)
+        {
+            case op_jump:  stack.push_back(inst.x);                          break;
+            case op_split: stack.push_back(inst.y); stack.push_back(inst.x); break;
+            case op_begin: if (pos == 0)    stack.push_back(pc + 1);         break;
+            case op_end:   if (pos == size) stack.push_back(pc + 1);         break;
+            default:
+            {
+                thread const t = { pc, start };
+                list.push_back(t);
+                break;
+            }
+        }
+    }
+}
+
+// the scratch lists of the calling thread. run() does not call back into
+// user code, so a thread is never in two matches at once and one set of
+// lists is enough. without thread exit support the lists are not freed
+// when their thread ends
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_regex<Char, Traits, Alloc>::scratch &basic_string_regex<Char, Traits, Alloc>::local_scratch(void)
+{
+#if IMMUTABLE_STRING_HAS_THREAD_EXIT
+    static thread_local scratch lists;
+    return lists;
+#else
+    static IMMUTABLE_STRING_THREAD_LOCAL scratch *lists = nullptr;
+    if (lists == nullptr)
+        lists = new scratch;
+    return *lists;
+#endif
+}
+
+// step every thread over each character in turn. the threads are kept in
+// order of preference, so when one matches, the threads after it are
+// dropped, and those before it run on in case they match later
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_string_regex<Char, Traits, Alloc>::run(Char const *text, size_type size, size_type from, bool anchored, bool whole,
+                                                        size_type &match_start, size_type &match_end) const
+{
+    // the lists only grow, so once they have held a program this size,
+    // clearing and refilling them allocates nothing
+    scratch &lists = local_scratch();
+    std::vector<thread>    &current = lists.current;
+    std::vector<thread>    &next    = lists.next;
+    std::vector<size_type> &marks   = lists.marks;
+    std::vector<size_type> &stack   = lists.stack;
+    current.clear();
+    next.clear();
+    stack.clear();
+    marks.assign(program_.size(), size_type(npos));
+    current.reserve(program_.size());
+    next.reserve(program_.size());
+
+    bool matched = false;
+    for (size_type pos=from; ; ++pos)
+    {
+        // a new thread starting here has the least preference
+        if (!matched  &&  (!anchored  ||  pos == from))
+            add(current, marks, stack, 0, pos, pos, size);
+        if (current.empty()  &&  (matched  ||  anchored))
+            break;
+
+        for (auto const &t : current)
+        {
+            instruction const &inst = program_[t.pc];
+            if (inst.code == op_match)
+            {
+                if (whole  &&  pos != size)
+                    continue;
+                matched     = true;
+                match_start = t.start;
+                match_end   = pos;
+                break;
+            }
+            else if (pos != size  &&  accepts(inst, text[pos]))
+                add(next, marks, stack, t.pc + 1, t.start, pos + 1, size);
+        }
+
+        if (pos == size)
+            break;
+        current.swap(next);
+        next.clear();
+    }
+    return matched;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_string_regex<Char, Traits, Alloc>::matches(view_type const &text) const
+{
+    size_type start, end;
+    return run(text.data(), text.size(), 0, true, true, start, end);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_regex<Char, Traits, Alloc>::view_type
+basic_string_regex<Char, Traits, Alloc>::find(view_type const &text, size_type pos) const
+{
+    size_type start, end;
+    if (pos > text.size()  ||  !run(text.data(), text.size(), pos, false, false, start, end))
+        return view_type();
+    return view_type(text.data() + start, end - start);
+}
+
+// after an empty match, the next search starts one character further on
+template<typename Char, typename Traits, typename Alloc>
+std::vector<typename basic_string_regex<Char, Traits, Alloc>::view_type>
+basic_string_regex<Char, Traits, Alloc>::find_all(view_type const &text) const
+{
+    std::vector<view_type> result;
+    for (size_type pos=0; pos<=text.size(); )
+    {
+        view_type const match = find(text, pos);
+        if (match.data() == nullptr)
+            break;
+        result.push_back(match);
+        pos = static_cast<size_type>(match.data() - text.data()) + match.size() + (match.empty()? 1 : 0);
+    }
+    return result;
+}
+
+}   // namespace cdmh
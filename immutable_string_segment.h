@@ -0,0 +1,181 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace cdmh {
+
+namespace detail {
+
+// the start of a segment. everything after it is addressed by offsets from
+// the start of the segment, so that each process can map it at any address
+struct segment_header
+{
+    enum { root_count = 64 };
+
+    char                       magic[8];
+    std::uint32_t              byte_order;
+    std::uint32_t              version;
+    std::uint64_t              capacity;            // bytes in the segment, including this header
+    std::atomic<std::uint64_t> used;                // the bump allocator's high water mark
+    std::atomic<std::uint64_t> roots[root_count];   // offsets published for other processes to find
+};
+
+// a named shared memory object, mapped into this process
+class shared_memory
+{
+  public:
+    shared_memory(char const *name, std::size_t size, bool create);
+    ~shared_memory();
+
+    void        *data(void) const { return data_; }
+    std::size_t  size(void) const { return size_; }
+
+  private:
+    shared_memory(shared_memory const &);
+    shared_memory &operator=(shared_memory const &);
+
+    void        *data_;
+    std::size_t  size_;
+#if defined(_WIN32)
+    void        *mapping_;
+#endif
+};
+
+}   // namespace detail
+
+// a reference to a string in a segment, as an offset from the start of the
+// segment. it is the same in every process, so it can be stored in the
+// segment itself or passed between processes
+template<typename Char>
+struct basic_shared_string_ref
+{
+    std::uint64_t offset;
+};
+
+// a reference to a table of string references in a segment
+struct shared_string_table_ref
+{
+    std::uint64_t offset;
+};
+
+template<typename Char, typename Traits, typename Alloc> class basic_shared_string_table;
+
+// a POSIX shared memory segment (a named file mapping on Windows) that holds
+// immutable strings for several processes. one process creates the segment
+// and copies strings into it with a lock-free bump allocator; any number of
+// processes open it read-only and read the strings as views, in place.
+// strings are never freed or changed, so readers need no locks. a reader
+// sees everything written before the root it reads was published
+class shared_string_segment
+{
+  public:
+    static std::size_t const root_count = detail::segment_header::root_count;
+
+    // creates a new segment of the given capacity, replacing any of that name
+    static shared_string_segment create(char const *name, std::size_t capacity);
+
+    // maps an existing segment, read-only
+    static shared_string_segment open(char const *name);
+
+    // removes the name; processes that have the segment mapped keep it
+    static void remove(char const *name);
+
+    std::size_t const capacity(void)                                                   const noexcept { return static_cast<std::size_t>(header_->capacity); }
+    std::size_t const used(void)                                                       const noexcept { return static_cast<std::size_t>(header_->used.load(std::memory_order_acquire)); }
+    bool        const writable(void)                                                   const noexcept { return writable_; }
+
+    // copy strings into the segment. throws std::bad_alloc if the segment is full
+    template<typename Char>
+    basic_shared_string_ref<Char> allocate(Char const *s, std::size_t n);
+    template<typename Char, typename Traits, typename Alloc>
+    basic_shared_string_ref<Char> allocate(basic_immutable_string<Char, Traits, Alloc> const &str) { return allocate(str.data(), str.size()); }
+    template<typename ForwardIterator>
+    shared_string_table_ref       allocate_table(ForwardIterator first, ForwardIterator last);
+
+    // read strings in place
+    template<typename Char, typename Traits, typename Alloc>
+    basic_immutable_string_view<Char, Traits, Alloc> view(basic_shared_string_ref<Char> ref) const;
+    template<typename Char>
+    basic_immutable_string_view<Char>                view(basic_shared_string_ref<Char> ref) const { return view<Char, std::char_traits<Char>, std::allocator<Char>>(ref); }
+    template<typename Char, typename Traits, typename Alloc>
+    basic_shared_string_table<Char, Traits, Alloc>   table(shared_string_table_ref ref)      const;
+    template<typename Char>
+    basic_shared_string_table<Char, std::char_traits<Char>, std::allocator<Char>> table(shared_string_table_ref ref) const { return table<Char, std::char_traits<Char>, std::allocator<Char>>(ref); }
+
+    // roots are offsets published for readers to start from, such as the
+    // table of a dictionary. publishing a root releases everything written
+    // before it. an unset root is zero
+    void          set_root(std::size_t slot, std::uint64_t offset);
+    std::uint64_t root(std::size_t slot)                                               const;
+
+  private:
+    shared_string_segment(std::shared_ptr<detail::shared_memory> const &memory, bool writable);
+
+    unsigned char       *allocate_bytes(std::size_t bytes, std::uint64_t &offset);
+    unsigned char const *at(std::uint64_t offset, std::uint64_t bytes)                 const;
+
+    template<typename Char, typename Traits, typename Alloc> friend class basic_shared_string_table;
+
+    std::shared_ptr<detail::shared_memory>  memory_;
+    detail::segment_header                 *header_;
+    bool                                    writable_;
+};
+
+// a table of strings in a segment. the segment must outlive the table
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_shared_string_table
+{
+  public:
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+    typedef std::size_t                                      size_type;
+
+    basic_shared_string_table(shared_string_segment const &segment, shared_string_table_ref ref);
+
+    bool      const empty(void)                                                        const noexcept { return size_ == 0; }
+    size_type const size(void)                                                         const noexcept { return size_;      }
+    view_type       operator[](size_type index)                                        const;
+    view_type       at(size_type index)                                                const;
+
+  private:
+    shared_string_segment const *segment_;
+    std::uint64_t                offset_;
+    size_type                    size_;
+};
+
+typedef basic_shared_string_ref<char>      shared_string_ref;
+typedef basic_shared_string_ref<wchar_t>   shared_wstring_ref;
+typedef basic_shared_string_table<char>    shared_string_table;
+typedef basic_shared_string_table<wchar_t> shared_wstring_table;
+
+}   // namespace cdmh
+
+#include "immutable_string_segment.inl"
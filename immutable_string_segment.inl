@@ -0,0 +1,281 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cdmh {
+
+namespace detail {
+
+static char          const segment_magic[8]  = { 'c', 'd', 'm', 'h', 's', 'h', 'm', 's' };
+static std::uint32_t const segment_byte_order = 0x01020304;
+static std::uint32_t const segment_version    = 1;
+
+#if defined(_WIN32)
+inline shared_memory::shared_memory(char const *name, std::size_t size, bool create) : data_(nullptr), size_(size), mapping_(nullptr)
+{
+    if (create)
+    {
+        std::uint64_t const size64 = size;
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), name);
+    }
+    else
+        mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (mapping_ == nullptr)
+        throw std::runtime_error("unable to open shared memory");
+
+    data_ = MapViewOfFile(mapping_, create? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (data_ == nullptr  ||  VirtualQuery(data_, &info, sizeof(info)) == 0)
+    {
+        if (data_)
+            UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+        throw std::runtime_error("unable to map shared memory");
+    }
+    if (!create)
+        size_ = info.RegionSize;
+}
+
+inline shared_memory::~shared_memory()
+{
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+}
+#else
+inline shared_memory::shared_memory(char const *name, std::size_t size, bool create) : data_(nullptr), size_(size)
+{
+    int const fd = create? ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600) : ::shm_open(name, O_RDONLY, 0);
+    if (fd == -1)
+        throw std::runtime_error("unable to open shared memory");
+
+    struct stat st;
+    bool const sized = create? (::ftruncate(fd, static_cast<off_t>(size)) == 0) : (::fstat(fd, &st) == 0);
+    if (sized  &&  !create)
+        size_ = static_cast<std::size_t>(st.st_size);
+
+    void *const data = (sized  &&  size_ != 0)? ::mmap(nullptr, size_, create? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        if (create)
+            ::shm_unlink(name);
+        throw std::runtime_error("unable to map shared memory");
+    }
+    data_ = data;
+}
+
+inline shared_memory::~shared_memory()
+{
+    ::munmap(data_, size_);
+}
+#endif
+
+inline std::uint64_t const segment_entry_size(std::uint64_t bytes)
+{
+    return (bytes + 7) & ~std::uint64_t(7);
+}
+
+}   // namespace detail
+
+inline shared_string_segment::shared_string_segment(std::shared_ptr<detail::shared_memory> const &memory, bool writable)
+  : memory_(memory),
+    header_(static_cast<detail::segment_header *>(memory->data())),
+    writable_(writable)
+{
+}
+
+inline shared_string_segment shared_string_segment::create(char const *name, std::size_t capacity)
+{
+    if (capacity < sizeof(detail::segment_header))
+        throw std::invalid_argument("shared_string_segment capacity is too small");
+    if (!std::atomic<std::uint64_t>().is_lock_free())
+        throw std::runtime_error("shared_string_segment needs lock-free 64-bit atomics");
+
+    remove(name);
+    std::shared_ptr<detail::shared_memory> const memory = std::make_shared<detail::shared_memory>(name, capacity, true);
+    detail::segment_header *const header = new (memory->data()) detail::segment_header;
+    std::memcpy(header->magic, detail::segment_magic, sizeof(header->magic));
+    header->byte_order = detail::segment_byte_order;
+    header->version    = detail::segment_version;
+    header->capacity   = capacity;
+    for (std::size_t slot=0; slot<root_count; ++slot)
+        header->roots[slot].store(0, std::memory_order_relaxed);
+    header->used.store(detail::segment_entry_size(sizeof(detail::segment_header)), std::memory_order_release);
+    return shared_string_segment(memory, true);
+}
+
+inline shared_string_segment shared_string_segment::open(char const *name)
+{
+    std::shared_ptr<detail::shared_memory> const memory = std::make_shared<detail::shared_memory>(name, 0, false);
+    detail::segment_header const *const header = static_cast<detail::segment_header const *>(memory->data());
+    if (memory->size() < sizeof(detail::segment_header)
+    ||  std::memcmp(header->magic, detail::segment_magic, sizeof(header->magic)) != 0
+    ||  header->byte_order != detail::segment_byte_order
+    ||  header->version    != detail::segment_version
+    ||  header->capacity   >  memory->size())
+    {
+        throw std::runtime_error("invalid shared_string_segment");
+    }
+    return shared_string_segment(memory, false);
+}
+
+inline void shared_string_segment::remove(char const *name)
+{
+#if defined(_WIN32)
+    (void)name;     // a named mapping goes when its last handle is closed
+#else
+    ::shm_unlink(name);
+#endif
+}
+
+inline unsigned char *shared_string_segment::allocate_bytes(std::size_t bytes, std::uint64_t &offset)
+{
+    if (!writable_)
+        throw std::logic_error("shared_string_segment is read-only");
+
+    std::uint64_t const size = detail::segment_entry_size(bytes);
+    offset = header_->used.load(std::memory_order_relaxed);
+    do
+    {
+        if (size > header_->capacity - offset)
+            throw std::bad_alloc();
+    } while (!header_->used.compare_exchange_weak(offset, offset + size, std::memory_order_relaxed));
+    return static_cast<unsigned char *>(memory_->data()) + offset;
+}
+
+inline unsigned char const *shared_string_segment::at(std::uint64_t offset, std::uint64_t bytes) const
+{
+    std::uint64_t const used = header_->used.load(std::memory_order_acquire);
+    if (offset < sizeof(detail::segment_header)  ||  offset > used  ||  bytes > used - offset)
+        throw std::runtime_error("invalid shared_string_segment offset");
+    return static_cast<unsigned char const *>(memory_->data()) + offset;
+}
+
+template<typename Char>
+basic_shared_string_ref<Char> shared_string_segment::allocate(Char const *s, std::size_t n)
+{
+    std::uint64_t const length = n;
+    Char          const terminator = Char();
+    basic_shared_string_ref<Char> ref;
+    unsigned char *const entry = allocate_bytes(sizeof(length) + (n + 1) * sizeof(Char), ref.offset);
+    std::memcpy(entry, &length, sizeof(length));
+    if (n != 0)
+        std::memcpy(entry + sizeof(length), s, n * sizeof(Char));
+    std::memcpy(entry + sizeof(length) + n * sizeof(Char), &terminator, sizeof(terminator));
+    return ref;
+}
+
+template<typename ForwardIterator>
+shared_string_table_ref shared_string_segment::allocate_table(ForwardIterator first, ForwardIterator last)
+{
+    std::vector<std::uint64_t> offsets(1, 0);
+    for (; first!=last; ++first)
+        offsets.push_back(allocate(first->data(), first->size()).offset);
+    offsets[0] = offsets.size() - 1;
+
+    shared_string_table_ref ref;
+    unsigned char *const table = allocate_bytes(offsets.size() * sizeof(std::uint64_t), ref.offset);
+    std::memcpy(table, offsets.data(), offsets.size() * sizeof(std::uint64_t));
+    return ref;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_view<Char, Traits, Alloc> shared_string_segment::view(basic_shared_string_ref<Char> ref) const
+{
+    std::uint64_t length;
+    std::memcpy(&length, at(ref.offset, sizeof(length)), sizeof(length));
+    if (length >= capacity() / sizeof(Char))
+        throw std::runtime_error("invalid shared_string_segment offset");
+    Char const *const data = reinterpret_cast<Char const *>(at(ref.offset + sizeof(length), (length + 1) * sizeof(Char)));
+    return basic_immutable_string_view<Char, Traits, Alloc>(data, static_cast<std::size_t>(length));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_shared_string_table<Char, Traits, Alloc> shared_string_segment::table(shared_string_table_ref ref) const
+{
+    return basic_shared_string_table<Char, Traits, Alloc>(*this, ref);
+}
+
+inline void shared_string_segment::set_root(std::size_t slot, std::uint64_t offset)
+{
+    if (!writable_)
+        throw std::logic_error("shared_string_segment is read-only");
+    if (slot >= root_count)
+        throw std::out_of_range("shared_string_segment::set_root");
+    header_->roots[slot].store(offset, std::memory_order_release);
+}
+
+inline std::uint64_t shared_string_segment::root(std::size_t slot) const
+{
+    if (slot >= root_count)
+        throw std::out_of_range("shared_string_segment::root");
+    return header_->roots[slot].load(std::memory_order_acquire);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_shared_string_table<Char, Traits, Alloc>::basic_shared_string_table(shared_string_segment const &segment, shared_string_table_ref ref)
+  : segment_(&segment), offset_(ref.offset)
+{
+    std::uint64_t count;
+    std::memcpy(&count, segment.at(offset_, sizeof(count)), sizeof(count));
+    if (count >= segment.capacity() / sizeof(std::uint64_t))
+        throw std::runtime_error("invalid shared_string_segment offset");
+    segment.at(offset_, (count + 1) * sizeof(std::uint64_t));
+    size_ = static_cast<size_type>(count);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_shared_string_table<Char, Traits, Alloc>::view_type
+basic_shared_string_table<Char, Traits, Alloc>::operator[](size_type index) const
+{
+    basic_shared_string_ref<Char> ref;
+    std::memcpy(&ref.offset, segment_->at(offset_ + (index + 1) * sizeof(std::uint64_t), sizeof(std::uint64_t)), sizeof(ref.offset));
+    return segment_->view<Char, Traits, Alloc>(ref);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_shared_string_table<Char, Traits, Alloc>::view_type
+basic_shared_string_table<Char, Traits, Alloc>::at(size_type index) const
+{
+    if (index >= size_)
+        throw std::out_of_range("basic_shared_string_table::at");
+    return (*this)[index];
+}
+
+}   // namespace cdmh
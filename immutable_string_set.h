@@ -0,0 +1,146 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cdmh {
+
+// an immutable sorted set of strings, built once from a range and then
+// queried, that takes a fraction of the memory of a std::set of immutable
+// strings. the strings are front coded: they are kept in order in one
+// array, in buckets of bucket_size, and each string after the first of its
+// bucket is stored as the length of the prefix it shares with the one
+// before and the characters that follow it. lower_bound() binary searches
+// the first strings of the buckets, which are stored whole, and decodes at
+// most one bucket. iteration decodes each string from the one before, and
+// makes an immutable string of it only when it is dereferenced
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_immutable_string_set
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc>      key_type;
+    typedef basic_immutable_string<Char, Traits, Alloc>      value_type;
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+    typedef std::size_t                                      size_type;
+    typedef std::ptrdiff_t                                   difference_type;
+
+    static size_type const bucket_size = 16;
+
+    class const_iterator
+    {
+      public:
+        typedef std::input_iterator_tag                         iterator_category;
+        typedef typename basic_immutable_string_set::value_type value_type;
+        typedef std::ptrdiff_t                                  difference_type;
+        typedef void                                            pointer;
+        typedef value_type                                      reference;
+
+        const_iterator() : set_(nullptr), index_(0), pos_(0) { }
+
+        value_type      operator*(void)                                                const { return value_type(key_); }
+        const_iterator &operator++(void);
+        const_iterator  operator++(int)                                                      { const_iterator result(*this); ++*this; return result; }
+
+        // the current string without copying it, valid until the iterator moves
+        view_type       view(void)                                                     const { return view_type(key_.data(), key_.size()); }
+        size_type const index(void)                                                    const { return index_; }
+
+        bool const operator==(const_iterator const &other)                             const { return index_ == other.index_; }
+        bool const operator!=(const_iterator const &other)                             const { return index_ != other.index_; }
+
+      private:
+        friend class basic_immutable_string_set;
+        const_iterator(basic_immutable_string_set const *set, size_type index);
+
+        void decode(void);
+
+        basic_immutable_string_set const     *set_;
+        size_type                             index_;
+        size_type                             pos_;    // the next string to decode in the set's characters
+        std::basic_string<Char, Traits, Alloc> key_;
+    };
+    typedef const_iterator iterator;
+
+    basic_immutable_string_set() noexcept : size_(0) { }
+
+    // the strings may be in any order, and duplicates are dropped. they need
+    // data() and size() members
+    template<typename ForwardIterator>
+    basic_immutable_string_set(ForwardIterator first, ForwardIterator last);
+#if HAS_INITIALIZER_LIST
+    basic_immutable_string_set(std::initializer_list<value_type> il) : basic_immutable_string_set(il.begin(), il.end()) { }
+#endif
+
+    // Iterators
+    const_iterator begin(void)                                                         const { return const_iterator(this, 0);     }
+    const_iterator end(void)                                                           const { return const_iterator(this, size_); }
+    const_iterator cbegin(void)                                                        const { return begin();                     }
+    const_iterator cend(void)                                                          const { return end();                       }
+
+    // Capacity
+    bool      const empty(void)                                                        const noexcept { return size_ == 0; }
+    size_type const size(void)                                                         const noexcept { return size_;      }
+
+    // Element access
+    value_type      operator[](size_type index)                                        const { return *const_iterator(this, index); }
+    value_type      at(size_type index)                                                const;
+
+    // Lookup
+    bool            const contains(view_type const &key)                               const { return find(key) != end(); }
+    const_iterator  find(view_type const &key)                                         const;
+    const_iterator  lower_bound(view_type const &key)                                  const;
+    const_iterator  upper_bound(view_type const &key)                                  const;
+
+    // the strings that begin with prefix
+    std::pair<const_iterator, const_iterator> prefix_range(view_type const &prefix)    const;
+
+    // the heap bytes held by the set
+    size_type const heap_bytes(void)                                                   const noexcept { return chars_.capacity() * sizeof(Char) + buckets_.capacity() * sizeof(size_type); }
+
+  private:
+    typedef typename std::make_unsigned<Char>::type unsigned_char;
+
+    static bool const starts_with(view_type const &str, view_type const &prefix);
+
+    void      write_length(size_type length);
+    size_type read_length(size_type &pos)                                              const;
+    view_type head(size_type bucket)                                                   const;
+    size_type last_bucket_before(view_type const &key, bool inclusive)                const;
+
+    std::vector<Char>      chars_;      // lengths, as seven bits a character, and characters
+    std::vector<size_type> buckets_;    // the offset of each bucket in chars_
+    size_type              size_;
+};
+
+typedef basic_immutable_string_set<char>    immutable_string_set;
+typedef basic_immutable_string_set<wchar_t> immutable_wstring_set;
+
+}   // namespace cdmh
+
+#include "immutable_string_set.inl"
@@ -0,0 +1,233 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename ForwardIterator>
+basic_immutable_string_set<Char, Traits, Alloc>::basic_immutable_string_set(ForwardIterator first, ForwardIterator last)
+  : size_(0)
+{
+    std::vector<view_type> keys;
+    keys.reserve(std::distance(first, last));
+    for (; first!=last; ++first)
+        keys.push_back(view_type(first->data(), first->size()));
+    std::sort(keys.begin(), keys.end(), [](view_type const &lhs, view_type const &rhs) { return lhs.compare(rhs) < 0; });
+    keys.erase(std::unique(keys.begin(), keys.end(), [](view_type const &lhs, view_type const &rhs) { return lhs.compare(rhs) == 0; }), keys.end());
+
+    buckets_.reserve((keys.size() + bucket_size - 1) / bucket_size);
+    for (size_type index=0; index<keys.size(); ++index)
+    {
+        view_type const &key = keys[index];
+        size_type shared = 0;
+        if (index % bucket_size == 0)
+            buckets_.push_back(chars_.size());
+        else
+        {
+            view_type const &previous = keys[index - 1];
+            size_type const limit = std::min(key.size(), previous.size());
+            while (shared < limit  &&  Traits::eq(key[shared], previous[shared]))
+                ++shared;
+            write_length(shared);
+        }
+        write_length(key.size() - shared);
+        chars_.insert(chars_.end(), key.begin() + shared, key.end());
+    }
+    chars_.shrink_to_fit();
+    size_ = keys.size();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::value_type
+basic_immutable_string_set<Char, Traits, Alloc>::at(size_type index) const
+{
+    if (index >= size_)
+        throw std::out_of_range("basic_immutable_string_set::at");
+    return (*this)[index];
+}
+
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_immutable_string_set<Char, Traits, Alloc>::starts_with(view_type const &str, view_type const &prefix)
+{
+    return str.size() >= prefix.size()  &&  (prefix.empty()  ||  Traits::compare(str.data(), prefix.data(), prefix.size()) == 0);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_immutable_string_set<Char, Traits, Alloc>::write_length(size_type length)
+{
+    while (length >= 0x80)
+    {
+        chars_.push_back(static_cast<Char>((length & 0x7f) | 0x80));
+        length >>= 7;
+    }
+    chars_.push_back(static_cast<Char>(length));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::size_type
+basic_immutable_string_set<Char, Traits, Alloc>::read_length(size_type &pos) const
+{
+    size_type length = 0;
+    for (unsigned shift=0;; shift+=7)
+    {
+        size_type const c = static_cast<unsigned_char>(chars_[pos++]);
+        length |= (c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return length;
+    }
+}
+
+// the first string of a bucket, in place
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::view_type
+basic_immutable_string_set<Char, Traits, Alloc>::head(size_type bucket) const
+{
+    size_type pos = buckets_[bucket];
+    size_type const length = read_length(pos);
+    return view_type(chars_.data() + pos, length);
+}
+
+// the last bucket whose first string is less than key, or not greater than
+// it if inclusive, or the first bucket if there is none
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::size_type
+basic_immutable_string_set<Char, Traits, Alloc>::last_bucket_before(view_type const &key, bool inclusive) const
+{
+    size_type low = 0, high = buckets_.size();
+    while (high - low > 1)
+    {
+        size_type const middle = low + (high - low) / 2;
+        int const result = head(middle).compare(key);
+        if (result < 0  ||  (inclusive  &&  result == 0))
+            low = middle;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator
+basic_immutable_string_set<Char, Traits, Alloc>::lower_bound(view_type const &key) const
+{
+    if (empty())
+        return end();
+
+    const_iterator it(this, last_bucket_before(key, false) * bucket_size);
+    while (it.index_ != size_  &&  it.view().compare(key) < 0)
+        ++it;
+    return it;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator
+basic_immutable_string_set<Char, Traits, Alloc>::upper_bound(view_type const &key) const
+{
+    if (empty())
+        return end();
+
+    const_iterator it(this, last_bucket_before(key, true) * bucket_size);
+    while (it.index_ != size_  &&  it.view().compare(key) <= 0)
+        ++it;
+    return it;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator
+basic_immutable_string_set<Char, Traits, Alloc>::find(view_type const &key) const
+{
+    const_iterator const it = lower_bound(key);
+    if (it.index_ != size_  &&  it.view().compare(key) == 0)
+        return it;
+    return end();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::pair<typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator,
+          typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator>
+basic_immutable_string_set<Char, Traits, Alloc>::prefix_range(view_type const &prefix) const
+{
+    const_iterator const first = lower_bound(prefix);
+    if (first.index_ == size_  ||  !starts_with(first.view(), prefix))
+        return std::make_pair(first, first);
+
+    // the strings with the prefix are together, so the last bucket that
+    // starts with one, or before them, holds the end of the range
+    size_type low = first.index_ / bucket_size, high = buckets_.size();
+    while (high - low > 1)
+    {
+        size_type const middle = low + (high - low) / 2;
+        if (starts_with(head(middle), prefix))
+            low = middle;
+        else
+            high = middle;
+    }
+
+    const_iterator last = (low * bucket_size > first.index_)? const_iterator(this, low * bucket_size) : first;
+    while (last.index_ != size_  &&  starts_with(last.view(), prefix))
+        ++last;
+    return std::make_pair(first, last);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_set<Char, Traits, Alloc>::const_iterator::const_iterator(basic_immutable_string_set const *set, size_type index)
+  : set_(set), index_(index), pos_(0)
+{
+    if (index_ >= set_->size_)
+    {
+        index_ = set_->size_;
+        return;
+    }
+
+    size_type const start = index_ - index_ % bucket_size;
+    pos_   = set_->buckets_[start / bucket_size];
+    index_ = start;
+    decode();
+    while (index_ != index)
+    {
+        ++index_;
+        decode();
+    }
+}
+
+// decodes the string at index_ from the one before it
+template<typename Char, typename Traits, typename Alloc>
+void basic_immutable_string_set<Char, Traits, Alloc>::const_iterator::decode(void)
+{
+    size_type const shared = (index_ % bucket_size == 0)? 0 : set_->read_length(pos_);
+    size_type const length = set_->read_length(pos_);
+    key_.resize(shared);
+    key_.append(set_->chars_.data() + pos_, length);
+    pos_ += length;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_set<Char, Traits, Alloc>::const_iterator &
+basic_immutable_string_set<Char, Traits, Alloc>::const_iterator::operator++(void)
+{
+    if (++index_ < set_->size_)
+        decode();
+    return *this;
+}
+
+}   // namespace cdmh
@@ -0,0 +1,138 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string_view.h"
+#include <ostream>
+
+namespace cdmh {
+
+namespace detail {
+
+// file layout, all fields in the byte order of the writer:
+//     header
+//     index   count x uint64, offset of each entry from the start of the blob
+//     hashes  count x uint64, std::hash of each string (optional)
+//     table   buckets x uint64, open addressed hash table of index + 1 (optional)
+//     blob    entries of uint64 length, the characters, a null terminator,
+//             padded to a multiple of 8 bytes
+struct snapshot_header
+{
+    char          magic[8];
+    std::uint32_t byte_order;       // snapshot_byte_order, as written
+    std::uint32_t version;
+    std::uint32_t char_size;        // sizeof(Char)
+    std::uint32_t hash_size;        // sizeof(std::size_t) of the writer, 0 if there are no hashes
+    std::uint64_t count;
+    std::uint64_t index_offset;
+    std::uint64_t hash_offset;
+    std::uint64_t table_offset;
+    std::uint64_t table_buckets;    // power of two, 0 if there are no hashes
+    std::uint64_t blob_offset;
+    std::uint64_t blob_size;
+};
+
+static char          const snapshot_magic[8]  = { 'c', 'd', 'm', 'h', 's', 'n', 'a', 'p' };
+static std::uint32_t const snapshot_byte_order = 0x01020304;
+static std::uint32_t const snapshot_version    = 1;
+
+// a read-only memory mapping of a whole file
+class file_mapping
+{
+  public:
+    explicit file_mapping(char const *path);
+    ~file_mapping();
+
+    void        const *data(void) const { return data_; }
+    std::size_t const  size(void) const { return size_; }
+
+  private:
+    file_mapping(file_mapping const &);
+    file_mapping &operator=(file_mapping const &);
+
+    void        *data_;
+    std::size_t  size_;
+#if defined(_WIN32)
+    void        *file_;
+    void        *mapping_;
+#endif
+};
+
+}   // namespace detail
+
+// writes the strings in [first, last) to a snapshot that can be loaded
+// with basic_immutable_string_snapshot. the range is traversed twice, and
+// the element type may be any string type with data() and size()
+template<typename ForwardIterator>
+void write_snapshot(std::ostream &os, ForwardIterator first, ForwardIterator last, bool with_hashes=true);
+
+// a table of strings loaded from a snapshot. the strings are views of the
+// mapped file or the memory buffer; nothing is copied or allocated per
+// string when the snapshot is loaded or read, and the views remain valid
+// for as long as the snapshot, or a copy of it, exists
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_immutable_string_snapshot
+{
+  public:
+    typedef basic_immutable_string_view<Char, Traits, Alloc> view_type;
+    typedef std::size_t                                      size_type;
+
+    static size_type const npos = (size_type)-1;
+
+    // maps the file into memory
+    static basic_immutable_string_snapshot map(char const *path);
+
+    // uses a snapshot already in memory. the caller retains ownership of the
+    // buffer, which must outlive the snapshot
+    basic_immutable_string_snapshot(void const *data, std::size_t size);
+
+    bool        const empty(void)                                                      const noexcept { return size() == 0;                          }
+    size_type   const size(void)                                                       const noexcept { return static_cast<size_type>(header_.count);}
+    bool        const has_hashes(void)                                                 const noexcept { return header_.hash_size == sizeof(std::size_t); }
+
+    view_type         operator[](size_type index)                                      const;
+    view_type         at(size_type index)                                              const;
+    std::size_t const hash(size_type index)                                            const;
+
+    // index of a string equal to str, or npos. uses the hash table when the
+    // snapshot has one, and otherwise scans the strings in order
+    size_type   const find(view_type const &str)                                       const;
+
+  private:
+    basic_immutable_string_snapshot(std::shared_ptr<detail::file_mapping const> const &mapping);
+    void                 open(void const *data, std::size_t size);
+    std::uint64_t const  read(std::uint64_t offset, size_type index)                   const;
+
+    std::shared_ptr<detail::file_mapping const> mapping_;
+    unsigned char const                        *data_;
+    std::size_t                                 size_;
+    detail::snapshot_header                     header_;
+};
+
+typedef basic_immutable_string_snapshot<char>    immutable_string_snapshot;
+typedef basic_immutable_string_snapshot<wchar_t> immutable_wstring_snapshot;
+
+}   // namespace cdmh
+
+#include "immutable_string_snapshot.inl"
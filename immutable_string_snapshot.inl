@@ -0,0 +1,312 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cdmh {
+
+namespace detail {
+
+#if defined(_WIN32)
+inline file_mapping::file_mapping(char const *path) : data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+{
+    file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("unable to open snapshot");
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size))
+    {
+        CloseHandle(file_);
+        throw std::runtime_error("unable to open snapshot");
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0)
+        return;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_)
+        data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (data_ == nullptr)
+    {
+        if (mapping_)
+            CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("unable to map snapshot");
+    }
+}
+
+inline file_mapping::~file_mapping()
+{
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+#else
+inline file_mapping::file_mapping(char const *path) : data_(nullptr), size_(0)
+{
+    int const fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("unable to open snapshot");
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("unable to open snapshot");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ != 0)
+    {
+        void *const data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+            data_ = data;
+    }
+    ::close(fd);        // the mapping holds its own reference to the file
+    if (size_ != 0  &&  data_ == nullptr)
+        throw std::runtime_error("unable to map snapshot");
+}
+
+inline file_mapping::~file_mapping()
+{
+    if (data_)
+        ::munmap(data_, size_);
+}
+#endif
+
+inline std::uint64_t const snapshot_entry_size(std::uint64_t bytes)
+{
+    return (sizeof(std::uint64_t) + bytes + 7) & ~std::uint64_t(7);
+}
+
+inline void write_snapshot_data(std::ostream &os, void const *data, std::size_t bytes)
+{
+    os.write(static_cast<char const *>(data), static_cast<std::streamsize>(bytes));
+}
+
+}   // namespace detail
+
+template<typename ForwardIterator>
+void write_snapshot(std::ostream &os, ForwardIterator first, ForwardIterator last, bool with_hashes)
+{
+    typedef typename std::iterator_traits<ForwardIterator>::value_type string_type;
+    typedef typename string_type::value_type                           Char;
+    typedef typename string_type::traits_type                          Traits;
+
+    std::vector<std::uint64_t> index;
+    std::vector<std::uint64_t> hashes;
+    std::uint64_t              blob_size = 0;
+    for (ForwardIterator it=first; it!=last; ++it)
+    {
+        index.push_back(blob_size);
+        if (with_hashes)
+            hashes.push_back(detail::string_hash<Traits>::hash(it->data(), it->size()));
+        blob_size += detail::snapshot_entry_size((it->size() + 1) * sizeof(Char));
+    }
+
+    // linear probing, with at least half of the buckets empty
+    std::vector<std::uint64_t> table;
+    if (with_hashes)
+    {
+        std::size_t buckets = 1;
+        while (buckets < index.size() * 2)
+            buckets <<= 1;
+        table.resize(buckets, 0);
+        for (std::size_t i=0; i<hashes.size(); ++i)
+        {
+            std::size_t slot = static_cast<std::size_t>(hashes[i]) & (buckets - 1);
+            while (table[slot] != 0)
+                slot = (slot + 1) & (buckets - 1);
+            table[slot] = i + 1;
+        }
+    }
+
+    detail::snapshot_header header;
+    std::memcpy(header.magic, detail::snapshot_magic, sizeof(header.magic));
+    header.byte_order    = detail::snapshot_byte_order;
+    header.version       = detail::snapshot_version;
+    header.char_size     = sizeof(Char);
+    header.hash_size     = with_hashes? sizeof(std::size_t) : 0;
+    header.count         = index.size();
+    header.index_offset  = sizeof(header);
+    header.hash_offset   = header.index_offset + index.size()  * sizeof(std::uint64_t);
+    header.table_offset  = header.hash_offset  + hashes.size() * sizeof(std::uint64_t);
+    header.table_buckets = table.size();
+    header.blob_offset   = header.table_offset + table.size()  * sizeof(std::uint64_t);
+    header.blob_size     = blob_size;
+
+    detail::write_snapshot_data(os, &header, sizeof(header));
+    detail::write_snapshot_data(os, index.data(),  index.size()  * sizeof(std::uint64_t));
+    detail::write_snapshot_data(os, hashes.data(), hashes.size() * sizeof(std::uint64_t));
+    detail::write_snapshot_data(os, table.data(),  table.size()  * sizeof(std::uint64_t));
+
+    static char const padding[8] = { 0 };
+    for (ForwardIterator it=first; it!=last; ++it)
+    {
+        std::uint64_t const length = it->size();
+        std::uint64_t const bytes  = (length + 1) * sizeof(Char);
+        Char          const terminator = Char();
+        detail::write_snapshot_data(os, &length, sizeof(length));
+        detail::write_snapshot_data(os, it->data(), static_cast<std::size_t>(length * sizeof(Char)));
+        detail::write_snapshot_data(os, &terminator, sizeof(terminator));
+        detail::write_snapshot_data(os, padding, static_cast<std::size_t>(detail::snapshot_entry_size(bytes) - sizeof(length) - bytes));
+    }
+
+    if (!os)
+        throw std::runtime_error("unable to write snapshot");
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_snapshot<Char, Traits, Alloc>
+basic_immutable_string_snapshot<Char, Traits, Alloc>::map(char const *path)
+{
+    return basic_immutable_string_snapshot(std::make_shared<detail::file_mapping const>(path));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_snapshot<Char, Traits, Alloc>::basic_immutable_string_snapshot(void const *data, std::size_t size)
+{
+    open(data, size);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_snapshot<Char, Traits, Alloc>::basic_immutable_string_snapshot(std::shared_ptr<detail::file_mapping const> const &mapping)
+  : mapping_(mapping)
+{
+    open(mapping->data(), mapping->size());
+}
+
+// only the header is validated here, so that opening a snapshot doesn't
+// touch every page of it; each entry is bounds checked when it is read
+template<typename Char, typename Traits, typename Alloc>
+void basic_immutable_string_snapshot<Char, Traits, Alloc>::open(void const *data, std::size_t size)
+{
+    data_ = static_cast<unsigned char const *>(data);
+    size_ = size;
+
+    std::uint64_t const words = size / sizeof(std::uint64_t);
+    if (data == nullptr  ||  size < sizeof(header_)  ||  reinterpret_cast<std::uintptr_t>(data) % sizeof(std::uint64_t) != 0)
+        throw std::runtime_error("invalid snapshot");
+    std::memcpy(&header_, data, sizeof(header_));
+    if (std::memcmp(header_.magic, detail::snapshot_magic, sizeof(header_.magic)) != 0
+    ||  header_.byte_order != detail::snapshot_byte_order
+    ||  header_.version    != detail::snapshot_version
+    ||  header_.char_size  != sizeof(Char)
+    ||  header_.count > words  ||  header_.table_buckets > words
+    ||  header_.index_offset > size  ||  header_.hash_offset > size  ||  header_.table_offset > size
+    ||  (header_.table_buckets & (header_.table_buckets - 1)) != 0
+    ||  header_.index_offset + header_.count * sizeof(std::uint64_t) > size
+    ||  (header_.hash_size != 0  &&  header_.hash_offset + header_.count * sizeof(std::uint64_t) > size)
+    ||  header_.table_offset + header_.table_buckets * sizeof(std::uint64_t) > size
+    ||  header_.blob_offset > size  ||  header_.blob_size > size - header_.blob_offset
+    ||  (header_.index_offset | header_.hash_offset | header_.table_offset | header_.blob_offset) % sizeof(std::uint64_t) != 0)
+    {
+        throw std::runtime_error("invalid snapshot");
+    }
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::uint64_t const basic_immutable_string_snapshot<Char, Traits, Alloc>::read(std::uint64_t offset, size_type index) const
+{
+    std::uint64_t value;
+    std::memcpy(&value, data_ + offset + index * sizeof(std::uint64_t), sizeof(value));
+    return value;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_snapshot<Char, Traits, Alloc>::view_type
+basic_immutable_string_snapshot<Char, Traits, Alloc>::operator[](size_type index) const
+{
+    std::uint64_t const offset = read(header_.index_offset, index);
+    if (header_.blob_size < sizeof(std::uint64_t)  ||  offset % sizeof(std::uint64_t) != 0  ||  offset > header_.blob_size - sizeof(std::uint64_t))
+        throw std::runtime_error("invalid snapshot");
+
+    unsigned char const *const entry  = data_ + header_.blob_offset + offset;
+    std::uint64_t        const length = read(header_.blob_offset + offset, 0);
+    if (length >= (header_.blob_size - offset - sizeof(std::uint64_t)) / sizeof(Char))
+        throw std::runtime_error("invalid snapshot");
+    return view_type(reinterpret_cast<Char const *>(entry + sizeof(std::uint64_t)), static_cast<size_type>(length));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_snapshot<Char, Traits, Alloc>::view_type
+basic_immutable_string_snapshot<Char, Traits, Alloc>::at(size_type index) const
+{
+    if (index >= size())
+        throw std::out_of_range("basic_immutable_string_snapshot::at");
+    return (*this)[index];
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::size_t const basic_immutable_string_snapshot<Char, Traits, Alloc>::hash(size_type index) const
+{
+    if (has_hashes())
+        return static_cast<std::size_t>(read(header_.hash_offset, index));
+    view_type const str = (*this)[index];
+    return detail::string_hash<Traits>::hash(str.data(), str.size());
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_snapshot<Char, Traits, Alloc>::size_type const
+basic_immutable_string_snapshot<Char, Traits, Alloc>::find(view_type const &str) const
+{
+    if (has_hashes()  &&  header_.table_buckets != 0)
+    {
+        std::size_t const hash = detail::string_hash<Traits>::hash(str.data(), str.size());
+        std::size_t const mask = static_cast<std::size_t>(header_.table_buckets - 1);
+        for (std::size_t slot = hash & mask, probes = 0; probes != header_.table_buckets; slot = (slot + 1) & mask, ++probes)
+        {
+            std::uint64_t const entry = read(header_.table_offset, slot);
+            if (entry == 0)
+                break;
+            size_type const index = static_cast<size_type>(entry - 1);
+            if (index < size()  &&  read(header_.hash_offset, index) == hash  &&  (*this)[index] == str)
+                return index;
+        }
+        return npos;
+    }
+
+    for (size_type index=0; index<size(); ++index)
+    {
+        if ((*this)[index] == str)
+            return index;
+    }
+    return npos;
+}
+
+}   // namespace cdmh
@@ -0,0 +1,52 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string_parallel.h"
+#include <iterator>
+
+namespace cdmh {
+
+// sorts a range of immutable strings into ascending order, using up to
+// threads threads, or one per processor if threads is zero. the sort is
+// not stable.
+//
+// the strings are sorted through an array of their prefix keys, so most
+// comparisons are between two integers in one contiguous array rather than
+// between the characters of two heap buffers. strings whose keys are equal
+// are sorted on the next characters in the same way, a radix sort with
+// eight byte digits. the range is sorted in chunks on separate threads,
+// which are then merged. immutable strings cannot be assigned, so the
+// strings are finally moved into their sorted positions in place. for
+// Traits without a prefix key the chunks are sorted by comparison
+template<typename RandomAccessIterator>
+void sort_strings(RandomAccessIterator first, RandomAccessIterator last, unsigned threads = 1);
+
+// sorts a range of immutable strings into the order of a locale. each
+// thread computes the collation keys of its chunk of the range, which the
+// strings cache, and sorts the chunk by comparing them
+template<typename RandomAccessIterator, typename Char, typename Traits, typename Alloc>
+void sort_strings(RandomAccessIterator first, RandomAccessIterator last, basic_collate_less<Char, Traits, Alloc> const &less, unsigned threads = 1);
+
+}   // namespace cdmh
+
+#include "immutable_string_sort.inl"
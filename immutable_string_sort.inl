@@ -0,0 +1,206 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+namespace cdmh {
+
+namespace detail {
+
+// a string being sorted, and its digit at the current depth
+struct string_sort_entry
+{
+    std::uint64_t key;      // the characters from the current depth
+    std::size_t   tail;     // the characters left from the depth, up to one more than the key holds
+    std::size_t   index;    // the position of the string in the range being sorted
+};
+
+// sorts the entries on their keys, then each run of strings with equal keys
+// that continue past them on the characters that follow. the runs still to
+// be sorted are kept on a stack of their own rather than sorted by
+// recursion, so that a long common prefix cannot exhaust the call stack
+template<typename RandomAccessIterator>
+void sort_by_keys(RandomAccessIterator strings, string_sort_entry *first, string_sort_entry *last, std::size_t depth)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type string_type;
+    typedef prefix_key<typename string_type::value_type, typename string_type::traits_type> key;
+
+    struct range
+    {
+        string_sort_entry *first;
+        string_sort_entry *last;
+        std::size_t        depth;
+    };
+
+    range const all = { first, last, depth };
+    std::vector<range> pending(1, all);
+    while (!pending.empty())
+    {
+        range current = pending.back();
+        pending.pop_back();
+
+        std::sort(current.first, current.last, [](string_sort_entry const &lhs, string_sort_entry const &rhs) {
+            return lhs.key < rhs.key  ||  (lhs.key == rhs.key  &&  lhs.tail < rhs.tail);
+        });
+
+        while (current.first != current.last)
+        {
+            string_sort_entry *run = current.first + 1;
+            while (run != current.last  &&  run->key == current.first->key  &&  run->tail == current.first->tail)
+                ++run;
+
+            if (run - current.first > 1  &&  current.first->tail > key::chars)
+            {
+                std::size_t const next = current.depth + key::chars;
+                for (string_sort_entry *entry=current.first; entry!=run; ++entry)
+                {
+                    string_type const &str = strings[entry->index];
+                    entry->key  = key::pack(str.data() + next, str.size() - next);
+                    entry->tail = std::min<std::size_t>(str.size() - next, key::chars + 1);
+                }
+                range const equal = { current.first, run, next };
+                pending.push_back(equal);
+            }
+            current.first = run;
+        }
+    }
+}
+
+// replaces target with source without assigning to it
+template<typename T>
+void rebuild(T &target, T &&source)
+{
+    target.~T();
+    ::new (static_cast<void *>(std::addressof(target))) T(std::move(source));
+}
+
+// moves each string to its position in the sorted order, following each
+// cycle of the permutation with one string held aside
+template<typename RandomAccessIterator>
+void apply_order(RandomAccessIterator first, std::vector<string_sort_entry> const &order)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type string_type;
+
+    std::vector<bool> placed(order.size());
+    for (std::size_t start=0; start<order.size(); ++start)
+    {
+        if (placed[start]  ||  order[start].index == start)
+            continue;
+
+        string_type held(std::move(first[start]));
+        for (std::size_t position=start;;)
+        {
+            std::size_t const source = order[position].index;
+            placed[position] = true;
+            if (source == start)
+            {
+                rebuild(first[position], std::move(held));
+                break;
+            }
+            rebuild(first[position], std::move(first[source]));
+            position = source;
+        }
+    }
+}
+
+// the order of a range of size strings, each chunk of which is sorted by
+// sort_chunk on its own thread and then merged with less
+template<typename SortChunk, typename Less>
+std::vector<string_sort_entry> sorted_order(std::size_t size, unsigned threads, SortChunk sort_chunk, Less less)
+{
+    // chunks are large enough that the merges cost less than they save
+    std::size_t const min_chunk = 16 * 1024;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t const chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / min_chunk));
+    auto const bound = [size, chunks](std::size_t chunk) { return size / chunks * chunk + std::min(chunk, size % chunks); };
+
+    std::vector<string_sort_entry> order(size);
+    run_parallel(chunks, threads, [&](std::size_t chunk) {
+        string_sort_entry *const begin = order.data() + bound(chunk);
+        string_sort_entry *const end   = order.data() + bound(chunk + 1);
+        for (string_sort_entry *entry=begin; entry!=end; ++entry)
+            entry->index = static_cast<std::size_t>(entry - order.data());
+        sort_chunk(begin, end);
+    });
+
+    for (std::size_t width=1; width<chunks; width*=2)
+    {
+        run_parallel((chunks + 2 * width - 1) / (2 * width), threads, [&](std::size_t pair) {
+            std::size_t const left = pair * 2 * width;
+            if (left + width < chunks)
+                std::inplace_merge(order.begin() + bound(left), order.begin() + bound(left + width), order.begin() + bound(std::min(left + 2 * width, chunks)), less);
+        });
+    }
+    return order;
+}
+
+}   // namespace detail
+
+template<typename RandomAccessIterator>
+void sort_strings(RandomAccessIterator first, RandomAccessIterator last, unsigned threads)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type string_type;
+    typedef detail::prefix_key<typename string_type::value_type, typename string_type::traits_type> key;
+
+    std::size_t const size = static_cast<std::size_t>(last - first);
+    if (size < 2)
+        return;
+
+    auto const less = [first](detail::string_sort_entry const &lhs, detail::string_sort_entry const &rhs) {
+        return detail::compare_ordered(first[lhs.index], first[rhs.index]) < 0;
+    };
+    auto const sort_chunk = [first, less](detail::string_sort_entry *begin, detail::string_sort_entry *end) {
+        for (detail::string_sort_entry *entry=begin; entry!=end; ++entry)
+        {
+            string_type const &str = first[entry->index];
+            entry->key  = str.prefix_key();
+            entry->tail = std::min<std::size_t>(str.size(), key::chars + 1);
+        }
+        if (key::enabled)
+            detail::sort_by_keys(first, begin, end, 0);
+        else
+            std::sort(begin, end, less);
+    };
+
+    detail::apply_order(first, detail::sorted_order(size, threads, sort_chunk, less));
+}
+
+template<typename RandomAccessIterator, typename Char, typename Traits, typename Alloc>
+void sort_strings(RandomAccessIterator first, RandomAccessIterator last, basic_collate_less<Char, Traits, Alloc> const &collate, unsigned threads)
+{
+    std::size_t const size = static_cast<std::size_t>(last - first);
+    if (size < 2)
+        return;
+
+    auto const less = [first, &collate](detail::string_sort_entry const &lhs, detail::string_sort_entry const &rhs) {
+        return collate(first[lhs.index], first[rhs.index]);
+    };
+    auto const sort_chunk = [first, &collate, less](detail::string_sort_entry *begin, detail::string_sort_entry *end) {
+        for (detail::string_sort_entry *entry=begin; entry!=end; ++entry)
+            first[entry->index].collation_key(collate.locale());
+        std::sort(begin, end, less);
+    };
+
+    detail::apply_order(first, detail::sorted_order(size, threads, sort_chunk, less));
+}
+
+}   // namespace cdmh
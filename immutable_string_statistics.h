@@ -0,0 +1,290 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// opt-in counters of the string buffers that immutable strings allocate,
+// free and copy. define IMMUTABLE_STRING_STATISTICS before including
+// immutable_string.h to enable them; otherwise the hooks compile away.
+//
+// each thread counts into its own block, written only by that thread with
+// relaxed atomics, so counting costs no more than an uncontended add. the
+// blocks are kept in a global registry and summed by collect(). a block is
+// reused by a new thread when its thread exits, so counts are never lost
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "immutable_string_config.h"
+
+namespace cdmh {
+
+namespace statistics {
+
+// the operation that produced a string. strings made by a constructor
+// called within another operation are counted against that operation
+enum operation
+{
+    construct,
+    copy_construct,
+    append,
+    insert,
+    replace,
+    erase,
+    substr,
+    destruct,
+    operation_count
+};
+
+inline char const *const name(operation op)
+{
+    static char const *const names[operation_count] = { "construct", "copy_construct", "append", "insert", "replace", "erase", "substr", "destruct" };
+    return names[op];
+}
+
+struct counters
+{
+    std::uint64_t allocations;
+    std::uint64_t deallocations;
+    std::uint64_t bytes_allocated;
+    std::uint64_t bytes_copied;
+};
+
+struct report
+{
+    counters operations[operation_count];
+
+    counters const total(void) const
+    {
+        counters result = { 0, 0, 0, 0 };
+        for (int op=0; op<operation_count; ++op)
+        {
+            result.allocations     += operations[op].allocations;
+            result.deallocations   += operations[op].deallocations;
+            result.bytes_allocated += operations[op].bytes_allocated;
+            result.bytes_copied    += operations[op].bytes_copied;
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+struct thread_counters
+{
+    enum { fields = 4 };
+
+    thread_counters() : current(operation_count), adopted(nullptr)
+    {
+        for (int op=0; op<operation_count; ++op)
+            for (int field=0; field<fields; ++field)
+                values[op][field].store(0, std::memory_order_relaxed);
+    }
+
+    // only the owning thread writes, so there's no need for a locked add
+    void add(operation op, int field, std::uint64_t n)
+    {
+        std::atomic<std::uint64_t> &value = values[op][field];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t> values[operation_count][fields];
+    operation                  current;    // innermost operation in progress, or operation_count
+    void const                *adopted;    // a buffer that it took over from a temporary, or nullptr
+};
+
+class registry
+{
+  public:
+    static registry &instance(void)
+    {
+        // never destroyed, as threads may still be counting during static destruction
+        static registry *const the_registry = new registry;
+        return *the_registry;
+    }
+
+    thread_counters *acquire(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty())
+        {
+            thread_counters *const block = free_.back();
+            free_.pop_back();
+            return block;
+        }
+        blocks_.push_back(new thread_counters);
+        return blocks_.back();
+    }
+
+    void release(thread_counters *block)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        block->current = operation_count;
+        free_.push_back(block);
+    }
+
+    report const collect(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        report result = sum();
+        for (int op=0; op<operation_count; ++op)
+        {
+            result.operations[op].allocations     -= baseline_.operations[op].allocations;
+            result.operations[op].deallocations   -= baseline_.operations[op].deallocations;
+            result.operations[op].bytes_allocated -= baseline_.operations[op].bytes_allocated;
+            result.operations[op].bytes_copied    -= baseline_.operations[op].bytes_copied;
+        }
+        return result;
+    }
+
+    // the blocks are written without synchronization, so a reset records a
+    // baseline to subtract rather than clearing them
+    void reset(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        baseline_ = sum();
+    }
+
+  private:
+    registry()
+    {
+        for (int op=0; op<operation_count; ++op)
+            baseline_.operations[op] = counters();
+    }
+
+    report const sum(void) const
+    {
+        report result;
+        for (int op=0; op<operation_count; ++op)
+        {
+            std::uint64_t totals[thread_counters::fields] = { 0 };
+            for (std::size_t i=0; i<blocks_.size(); ++i)
+                for (int field=0; field<thread_counters::fields; ++field)
+                    totals[field] += blocks_[i]->values[op][field].load(std::memory_order_relaxed);
+            counters const c = { totals[0], totals[1], totals[2], totals[3] };
+            result.operations[op] = c;
+        }
+        return result;
+    }
+
+    std::mutex                     mutex_;
+    std::vector<thread_counters *> blocks_;
+    std::vector<thread_counters *> free_;
+    report                         baseline_;
+};
+
+#if IMMUTABLE_STRING_HAS_THREAD_EXIT
+struct thread_slot
+{
+    thread_slot() : block(registry::instance().acquire()) { }
+    ~thread_slot()                                        { registry::instance().release(block); }
+
+    thread_counters *const block;
+};
+
+inline thread_counters &local(void)
+{
+    static thread_local thread_slot slot;
+    return *slot.block;
+}
+#else
+inline thread_counters &local(void)
+{
+    static IMMUTABLE_STRING_THREAD_LOCAL thread_counters *block = nullptr;
+    if (block == nullptr)
+        block = registry::instance().acquire();
+    return *block;
+}
+#endif
+
+// marks the operation in progress on this thread for the life of the scope
+class operation_scope
+{
+  public:
+    explicit operation_scope(operation op)
+      : counters_(local()), previous_(counters_.current), previous_adopted_(counters_.adopted) { counters_.current = op; counters_.adopted = nullptr; }
+    ~operation_scope()                                                                        { counters_.current = previous_; counters_.adopted = previous_adopted_; }
+
+  private:
+    operation_scope(operation_scope const &);
+    operation_scope &operator=(operation_scope const &);
+
+    thread_counters  &counters_;
+    operation const   previous_;
+    void const *const previous_adopted_;
+};
+
+// notes that the operation in progress took over the heap buffer of a
+// temporary to modify in place
+inline void record_adoption(void const *buffer)
+{
+    thread_counters &c = local();
+    if (c.current != operation_count)
+        c.adopted = buffer;
+}
+
+// a string that takes over a buffer built by an operation is counted as
+// that operation's allocation and copy, but one that takes over a buffer
+// from the caller, or the buffer of a temporary that the operation
+// modified in place, has allocated and copied nothing
+inline void record_allocation(operation op, std::uint64_t bytes_allocated, std::uint64_t bytes_copied, bool moved, void const *buffer)
+{
+    thread_counters &c = local();
+    if (moved  &&  buffer != nullptr  &&  buffer == c.adopted)
+        return;
+    if (c.current != operation_count)
+        op = c.current;
+    else if (moved)
+        bytes_copied = 0;
+    if (bytes_allocated != 0)
+    {
+        c.add(op, 0, 1);
+        c.add(op, 2, bytes_allocated);
+    }
+    c.add(op, 3, bytes_copied);
+}
+
+inline void record_deallocation(std::uint64_t bytes)
+{
+    if (bytes != 0)
+        local().add(destruct, 1, 1);
+}
+
+}   // namespace detail
+
+// the counts of all threads since the start of the process, or the last reset()
+inline report const collect(void) { return detail::registry::instance().collect(); }
+inline void         reset(void)   { detail::registry::instance().reset();          }
+
+}   // namespace statistics
+
+}   // namespace cdmh
+
+// the hooks are left to immutable_string.h's no-op definitions unless the
+// statistics are enabled, so this header can be included in either order
+#ifdef IMMUTABLE_STRING_STATISTICS
+#define IMMUTABLE_STRING_OPERATION(op)           cdmh::statistics::detail::operation_scope const statistics_scope(cdmh::statistics::op)
+#define IMMUTABLE_STRING_RECORD(op)              record_statistics(cdmh::statistics::op)
+#define IMMUTABLE_STRING_RECORD_MOVE(op)         record_statistics(cdmh::statistics::op, true)
+#define IMMUTABLE_STRING_RECORD_ADOPTION(buffer) cdmh::statistics::detail::record_adoption(buffer)
+#endif
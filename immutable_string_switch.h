@@ -0,0 +1,92 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string.h"
+
+namespace cdmh {
+
+// maps a string to its position in a fixed table of keys, for dispatching
+// on command or field names with a switch on the result instead of a chain
+// of comparisons:
+//
+//     static string_switch const commands = { "get", "set", "delete" };
+//     switch (commands.index(command))
+//     {
+//         case 0: ...
+//         case string_switch::npos: ...
+//
+// the table is a perfect hash built by hash and displace: the keys are
+// divided into small buckets by their hash, and the constructor finds for
+// each bucket, largest first, a displacement that moves its keys into free
+// slots of their own. the table has about two slots a key, so a lookup
+// costs one hash, which an immutable string caches, one displacement, one
+// slot and one comparison to confirm the match. the table is built when the
+// object is constructed, in time and memory proportional to the number of
+// keys; a static object builds it once
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_string_switch
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc> string_type;
+    typedef std::size_t                                 size_type;
+
+    static size_type const npos = (size_type)-1;
+
+    // the keys must be distinct, and convertible to string_type
+    template<typename ForwardIterator>
+    basic_string_switch(ForwardIterator first, ForwardIterator last);
+#if HAS_INITIALIZER_LIST
+    basic_string_switch(std::initializer_list<Char const *> il) : basic_string_switch(il.begin(), il.end()) { }
+#endif
+
+    size_type   const  size(void)                                                      const noexcept { return keys_.size(); }
+    string_type const &key(size_type index)                                            const          { return keys_.at(index); }
+
+    // the position of the key equal to the string, or npos
+    size_type const index(string_type const &str)                                      const noexcept { return lookup(str.hash(), str.data(), str.size()); }
+    size_type const index(Char const *s, size_type n)                                  const noexcept { return lookup(detail::string_hash<Traits>::hash(s, n), s, n); }
+    size_type const index(Char const *s)                                               const          { return index(s, Traits::length(s)); }
+
+  private:
+    bool      const place(std::vector<std::vector<size_type>> const &buckets);
+    size_type const bucket(std::size_t hash)                                           const noexcept;
+    size_type const slot(std::size_t hash, std::uint32_t displacement)                 const noexcept;
+    size_type const lookup(std::size_t hash, Char const *s, size_type n)               const noexcept;
+
+    std::vector<string_type>   keys_;
+    std::vector<std::size_t>   hashes_;         // the hash of each key
+    std::vector<std::uint32_t> displacements_;  // of each bucket
+    std::vector<size_type>     slots_;          // the position of the key in each slot, or npos
+    std::uint64_t              seed_;
+    unsigned                   bucket_shift_;
+    unsigned                   shift_;
+};
+
+typedef basic_string_switch<char>    string_switch;
+typedef basic_string_switch<wchar_t> wstring_switch;
+
+}   // namespace cdmh
+
+#include "immutable_string_switch.inl"
@@ -0,0 +1,147 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+template<typename ForwardIterator>
+basic_string_switch<Char, Traits, Alloc>::basic_string_switch(ForwardIterator first, ForwardIterator last)
+  : seed_(0), bucket_shift_(63), shift_(63)
+{
+    for (; first!=last; ++first)
+    {
+        keys_.push_back(string_type(*first));
+        hashes_.push_back(keys_.back().hash());
+    }
+
+    // keys with equal hashes can't be given slots of their own
+    std::vector<std::size_t> sorted(hashes_);
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        throw std::invalid_argument("basic_string_switch keys are not distinct");
+
+    // about four keys a bucket and two slots a key. a seed that leaves a
+    // bucket with no displacement that fits is very unlikely, and is
+    // replaced, with a table twice the size after every few
+    unsigned bucket_bits = 1;
+    while ((std::size_t(1) << bucket_bits) * 4 < keys_.size())
+        ++bucket_bits;
+    unsigned bits = 1;
+    while ((std::size_t(1) << bits) < keys_.size() * 2)
+        ++bits;
+
+    for (std::uint64_t attempt=1;; ++attempt)
+    {
+        if (attempt > 32)
+            throw std::length_error("basic_string_switch could not build a perfect hash");
+        if (attempt % 8 == 0)
+            ++bits;
+
+        seed_         = attempt * 0x9e3779b97f4a7c15ULL;
+        bucket_shift_ = 64 - bucket_bits;
+        shift_        = 64 - bits;
+
+        std::vector<std::vector<size_type>> buckets(std::size_t(1) << bucket_bits);
+        for (size_type index=0; index<keys_.size(); ++index)
+            buckets[bucket(hashes_[index])].push_back(index);
+        if (place(buckets))
+            break;
+    }
+}
+
+// places the buckets with the most keys first, while the table is emptiest
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_string_switch<Char, Traits, Alloc>::place(std::vector<std::vector<size_type>> const &buckets)
+{
+    std::uint32_t const max_displacement = 1u << 20;
+
+    std::vector<size_type> order(buckets.size());
+    for (size_type i=0; i<order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_type lhs, size_type rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    displacements_.assign(buckets.size(), 0);
+    slots_.assign(std::size_t(1) << (64 - shift_), size_type(npos));
+    std::vector<size_type> taken;
+    for (auto b : order)
+    {
+        if (buckets[b].empty())
+            break;
+
+        std::uint32_t displacement = 0;
+        for (;; ++displacement)
+        {
+            if (displacement == max_displacement)
+                return false;
+
+            taken.clear();
+            for (auto index : buckets[b])
+            {
+                size_type const s = slot(hashes_[index], displacement);
+                if (slots_[s] != npos)
+                    break;
+                slots_[s] = index;
+                taken.push_back(s);
+            }
+            if (taken.size() == buckets[b].size())
+                break;
+            for (auto s : taken)
+                slots_[s] = npos;
+        }
+        displacements_[b] = displacement;
+    }
+    return true;
+}
+
+// multiplicative hashes of the string's hash, which take the bucket and the
+// slot from the best mixed, most significant, bits
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_switch<Char, Traits, Alloc>::size_type const
+basic_string_switch<Char, Traits, Alloc>::bucket(std::size_t hash) const noexcept
+{
+    return static_cast<size_type>(((static_cast<std::uint64_t>(hash) ^ seed_) * 0xc4ceb9fe1a85ec53ULL) >> bucket_shift_);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_switch<Char, Traits, Alloc>::size_type const
+basic_string_switch<Char, Traits, Alloc>::slot(std::size_t hash, std::uint32_t displacement) const noexcept
+{
+    std::uint64_t const x = static_cast<std::uint64_t>(hash) ^ seed_ ^ (displacement * 0x9e3779b97f4a7c15ULL);
+    return static_cast<size_type>((x * 0xff51afd7ed558ccdULL) >> shift_);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_string_switch<Char, Traits, Alloc>::size_type const
+basic_string_switch<Char, Traits, Alloc>::lookup(std::size_t hash, Char const *s, size_type n) const noexcept
+{
+    size_type const index = slots_[slot(hash, displacements_[bucket(hash)])];
+    if (index == npos  ||  hashes_[index] != hash)
+        return npos;
+
+    string_type const &key = keys_[index];
+    return (key.size() == n  &&  (n == 0  ||  Traits::compare(key.data(), s, n) == 0))? index : npos;
+}
+
+}   // namespace cdmh
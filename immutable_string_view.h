@@ -0,0 +1,217 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "immutable_string.h"
+#include <ostream>
+
+namespace cdmh {
+
+// a read-only reference to characters owned by something else: a memory
+// mapped file, a shared memory segment or another string. the view does
+// not extend the lifetime of the characters; str() copies them into an
+// immutable string that does
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_immutable_string_view
+{
+  public:
+    typedef Traits                                      traits_type;
+    typedef Char                                        value_type;
+    typedef Char const                                 &const_reference;
+    typedef Char const                                 *const_pointer;
+    typedef Char const                                 *const_iterator;
+    typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+    typedef std::size_t                                 size_type;
+    typedef std::ptrdiff_t                              difference_type;
+    typedef basic_immutable_string<Char, Traits, Alloc> string_type;
+
+    static size_type const npos = (size_type)-1;
+
+    basic_immutable_string_view() noexcept : data_(nullptr), size_(0)                                                 { }
+    basic_immutable_string_view(Char const *s, size_type n) noexcept : data_(s), size_(n)                             { }
+    basic_immutable_string_view(Char const *s) : data_(s), size_(Traits::length(s))                                   { }
+    basic_immutable_string_view(string_type const &str) noexcept : data_(str.data()), size_(str.size())               { }
+
+    // Iterators
+    const_iterator         begin(void)                                                               const noexcept { return data_;                                  }
+    const_iterator         end(void)                                                                 const noexcept { return data_ + size_;                          }
+    const_iterator         cbegin(void)                                                              const noexcept { return begin();                                }
+    const_iterator         cend(void)                                                                const noexcept { return end();                                  }
+    const_reverse_iterator crbegin(void)                                                             const noexcept { return const_reverse_iterator(end());          }
+    const_reverse_iterator crend(void)                                                               const noexcept { return const_reverse_iterator(begin());        }
+
+    // Capacity
+    bool             const empty(void)                                                               const noexcept { return size_ == 0;                             }
+    size_type        const length(void)                                                              const noexcept { return size_;                                  }
+    size_type        const size(void)                                                                const noexcept { return size_;                                  }
+
+    // Element access
+    const_reference        operator[](size_type pos)                                                 const          { return data_[pos];                             }
+    const_reference        at(size_type pos)                                                         const;
+    Char            const &back(void)                                                                const          { return data_[size_ - 1];                       }
+    Char            const &front(void)                                                               const          { return data_[0];                               }
+    Char            const *data(void)                                                                const noexcept { return data_;                                  }
+
+    // Operations
+    string_type                 str(void)                                                            const          { return string_type(data_, size_);              }
+    basic_immutable_string_view substr(size_type pos=0, size_type len=npos)                          const;
+
+    int const compare(basic_immutable_string_view const &other)                                      const noexcept;
+
+    size_type const find(basic_immutable_string_view const &str, size_type pos=0)                    const noexcept;
+    size_type const find(Char c, size_type pos=0)                                                    const noexcept;
+
+  private:
+    Char const *data_;
+    size_type   size_;
+};
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_view<Char, Traits, Alloc>::const_reference
+basic_immutable_string_view<Char, Traits, Alloc>::at(size_type pos) const
+{
+    if (pos >= size_)
+        throw std::out_of_range("basic_immutable_string_view::at");
+    return data_[pos];
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_immutable_string_view<Char, Traits, Alloc>
+basic_immutable_string_view<Char, Traits, Alloc>::substr(size_type pos, size_type len) const
+{
+    if (pos > size_)
+        throw std::out_of_range("basic_immutable_string_view::substr");
+    return basic_immutable_string_view(data_ + pos, std::min(len, size_ - pos));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+int const basic_immutable_string_view<Char, Traits, Alloc>::compare(basic_immutable_string_view const &other) const noexcept
+{
+    int const result = (std::min(size_, other.size_) == 0)? 0 : Traits::compare(data_, other.data_, std::min(size_, other.size_));
+    if (result != 0)
+        return result;
+    return (size_ < other.size_)? -1 : (size_ > other.size_)? 1 : 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_view<Char, Traits, Alloc>::size_type const
+basic_immutable_string_view<Char, Traits, Alloc>::find(basic_immutable_string_view const &str, size_type pos) const noexcept
+{
+    if (pos > size_  ||  str.size_ > size_ - pos)
+        return npos;
+    if (str.empty())
+        return pos;
+
+    Char const *const last = data_ + size_ - str.size_;
+    for (Char const *p = data_ + pos; (p = Traits::find(p, last - p + 1, str.data_[0])) != nullptr; ++p)
+    {
+        if (Traits::compare(p + 1, str.data_ + 1, str.size_ - 1) == 0)
+            return p - data_;
+        if (p == last)
+            break;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_immutable_string_view<Char, Traits, Alloc>::size_type const
+basic_immutable_string_view<Char, Traits, Alloc>::find(Char c, size_type pos) const noexcept
+{
+    if (pos >= size_)
+        return npos;
+    Char const *const p = Traits::find(data_ + pos, size_ - pos, c);
+    return p? p - data_ : npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, basic_immutable_string_view<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.size() == rhs.size()  &&  lhs.compare(rhs) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs == basic_immutable_string_view<Char, Traits, Alloc>(rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string_view<Char, Traits, Alloc> const &rhs)
+{
+    return basic_immutable_string_view<Char, Traits, Alloc>(lhs) == rhs;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, Char const *rhs)
+{
+    return lhs == basic_immutable_string_view<Char, Traits, Alloc>(rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator!=(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, basic_immutable_string_view<Char, Traits, Alloc> const &rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator!=(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, Char const *rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator<(basic_immutable_string_view<Char, Traits, Alloc> const &lhs, basic_immutable_string_view<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+std::basic_ostream<Char, Traits> &operator<<(std::basic_ostream<Char, Traits> &os, basic_immutable_string_view<Char, Traits, Alloc> const &str)
+{
+    return os.write(str.data(), str.size());
+}
+
+typedef basic_immutable_string_view<char>     immutable_string_view;
+typedef basic_immutable_string_view<wchar_t>  immutable_wstring_view;
+typedef basic_immutable_string_view<char16_t> immutable_u16string_view;
+typedef basic_immutable_string_view<char32_t> immutable_u32string_view;
+
+}   // namespace cdmh
+
+namespace std {
+
+// hashes equal to those of the equivalent basic_immutable_string
+template<typename Char, typename Traits, typename Alloc>
+struct hash<cdmh::basic_immutable_string_view<Char, Traits, Alloc>>
+{
+    typedef cdmh::basic_immutable_string_view<Char, Traits, Alloc> argument_type;
+    typedef std::size_t                                            result_type;
+
+    result_type operator()(argument_type const &str) const
+    {
+        return cdmh::detail::string_hash<Traits>::hash(str.data(), str.size());
+    }
+};
+
+}   // namespace std
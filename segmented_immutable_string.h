@@ -0,0 +1,236 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+#include "immutable_string.h"
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cdmh {
+
+namespace detail {
+
+// the segments of a segmented string, shared by its copies. every segment
+// but the last holds segment_size characters, so a position is found by
+// division. the flattened copy is made once, when c_str() first needs it
+template<typename String>
+struct segmented_block
+{
+    std::vector<String>                   segments;
+    std::size_t                           segment_size;
+    std::size_t                           length;
+    mutable std::once_flag                flatten_once;
+    mutable std::unique_ptr<String const> flat;
+};
+
+}   // namespace detail
+
+// an immutable string held in fixed size segments rather than one buffer,
+// for very large strings read from a stream. a stream is read a segment at
+// a time, so the peak memory is the size of the string and one segment,
+// where reading into a std::basic_string may need three times the size of
+// the string as its capacity doubles. the find family, compare and
+// iteration work across segment boundaries; c_str() and data() flatten the
+// string into one buffer the first time that they are called
+template<typename Char,
+         typename Traits = std::char_traits<Char>,
+         typename Alloc = std::allocator<Char>>
+class basic_segmented_immutable_string
+{
+  public:
+    typedef basic_immutable_string<Char, Traits, Alloc> string_type;
+    typedef typename string_type::size_type             size_type;
+    typedef typename string_type::difference_type       difference_type;
+
+    static size_type const npos = string_type::npos;
+    enum { default_segment_size = 1024 * 1024 };   // characters
+
+    class const_iterator;
+    class builder;
+
+    explicit basic_segmented_immutable_string(string_type const &str, size_type segment_size = default_segment_size);
+    basic_segmented_immutable_string(basic_segmented_immutable_string const &other) : block_(other.block_)             { }
+    basic_segmented_immutable_string(basic_segmented_immutable_string &&other) noexcept : block_(empty_block())        { block_.swap(other.block_); }
+
+    // read the rest of a stream
+    static basic_segmented_immutable_string read(std::basic_istream<Char> &in, size_type segment_size = default_segment_size);
+
+    // Capacity
+    bool        const  empty(void)                                                                           const noexcept { return size() == 0;                      }
+    size_type   const  length(void)                                                                          const noexcept { return size();                           }
+    size_type   const  size(void)                                                                            const noexcept { return block_->length;                   }
+
+    // the segments, each an immutable string
+    size_type   const  segment_size(void)                                                                    const noexcept { return block_->segment_size;             }
+    size_type   const  segment_count(void)                                                                   const noexcept { return block_->segments.size();          }
+    string_type const &segment(size_type index)                                                              const          { return block_->segments.at(index);       }
+
+    // Iterators
+    const_iterator     begin(void)                                                                           const noexcept { return const_iterator(block_.get(), 0);      }
+    const_iterator     end(void)                                                                             const noexcept { return const_iterator(block_.get(), size()); }
+    const_iterator     cbegin(void)                                                                          const noexcept { return begin();                          }
+    const_iterator     cend(void)                                                                            const noexcept { return end();                            }
+
+    // Element access
+    Char        const &operator[](size_type pos)                                                             const          { return block_->segments[pos / segment_size()][pos % segment_size()]; }
+    Char        const &at(size_type pos)                                                                     const;
+
+    // one buffer holding the whole string. str() makes a new string each
+    // time; c_str() and data() make one, which is kept until the last copy
+    // of this string is destroyed
+    string_type        str(void)                                                                             const;
+    Char const * const c_str(void)                                                                           const          { return flatten().c_str();                }
+    Char const * const data(void)                                                                            const          { return flatten().data();                 }
+
+    int const compare(basic_segmented_immutable_string const &str)                                           const noexcept;
+    int const compare(string_type const &str)                                                                const noexcept { return compare(str.data(), str.size());  }
+    int const compare(Char const *s)                                                                         const          { return compare(s, Traits::length(s));    }
+    int const compare(Char const *s, size_type n)                                                            const noexcept;
+
+    size_type const find(string_type const &str, size_type pos=0)                                            const noexcept { return find(str.data(), pos, str.size()); }
+    size_type const find(Char const *s, size_type pos=0)                                                     const          { return find(s, pos, Traits::length(s));  }
+    size_type const find(Char const *s, size_type pos, size_type n)                                          const noexcept;
+    size_type const find(Char c, size_type pos=0)                                                            const noexcept;
+
+    size_type const rfind(string_type const &str, size_type pos=npos)                                        const noexcept { return rfind(str.data(), pos, str.size()); }
+    size_type const rfind(Char const *s, size_type pos=npos)                                                 const          { return rfind(s, pos, Traits::length(s)); }
+    size_type const rfind(Char const *s, size_type pos, size_type n)                                         const noexcept;
+    size_type const rfind(Char c, size_type pos=npos)                                                        const noexcept;
+
+    // each character is checked on its own, so a segment's own search finds
+    // every character that it holds
+    size_type const find_first_of(string_type const &str, size_type pos=0)                                   const noexcept { return find_first_of(str.data(), pos, str.size()); }
+    size_type const find_first_of(Char const *s, size_type pos=0)                                            const          { return find_first_of(s, pos, Traits::length(s)); }
+    size_type const find_first_of(Char const *s, size_type pos, size_type n)                                 const noexcept;
+    size_type const find_first_of(Char c, size_type pos=0)                                                   const noexcept { return find_first_of(&c, pos, 1); }
+
+    size_type const find_last_of(string_type const &str, size_type pos=npos)                                 const noexcept { return find_last_of(str.data(), pos, str.size()); }
+    size_type const find_last_of(Char const *s, size_type pos=npos)                                          const          { return find_last_of(s, pos, Traits::length(s)); }
+    size_type const find_last_of(Char const *s, size_type pos, size_type n)                                  const noexcept;
+    size_type const find_last_of(Char c, size_type pos=npos)                                                 const noexcept { return find_last_of(&c, pos, 1); }
+
+    size_type const find_first_not_of(string_type const &str, size_type pos=0)                               const noexcept { return find_first_not_of(str.data(), pos, str.size()); }
+    size_type const find_first_not_of(Char const *s, size_type pos=0)                                        const          { return find_first_not_of(s, pos, Traits::length(s)); }
+    size_type const find_first_not_of(Char const *s, size_type pos, size_type n)                             const noexcept;
+    size_type const find_first_not_of(Char c, size_type pos=0)                                               const noexcept { return find_first_not_of(&c, pos, 1); }
+
+    size_type const find_last_not_of(string_type const &str, size_type pos=npos)                             const noexcept { return find_last_not_of(str.data(), pos, str.size()); }
+    size_type const find_last_not_of(Char const *s, size_type pos=npos)                                      const          { return find_last_not_of(s, pos, Traits::length(s)); }
+    size_type const find_last_not_of(Char const *s, size_type pos, size_type n)                              const noexcept;
+    size_type const find_last_not_of(Char c, size_type pos=npos)                                             const noexcept { return find_last_not_of(&c, pos, 1); }
+
+  private:
+    typedef detail::segmented_block<string_type> block;
+
+    explicit basic_segmented_immutable_string(std::shared_ptr<block const> b) : block_(std::move(b))                   { }
+
+    static std::shared_ptr<block const> empty_block(void) noexcept;
+
+    string_type const &flatten(void)                                                                         const;
+    bool        const  matches(size_type pos, Char const *s, size_type n)                                    const noexcept;
+
+    std::shared_ptr<block const> block_;
+
+#if defined(_MSC_VER)  &&  _MSC_VER < 1800
+    basic_segmented_immutable_string &operator=(basic_segmented_immutable_string);
+#else
+    basic_segmented_immutable_string &operator=(basic_segmented_immutable_string) = delete;
+#endif
+};
+
+// a random access iterator over the characters of all of the segments
+template<typename Char, typename Traits, typename Alloc>
+class basic_segmented_immutable_string<Char, Traits, Alloc>::const_iterator
+{
+  public:
+    typedef std::random_access_iterator_tag       iterator_category;
+    typedef Char                                  value_type;
+    typedef typename string_type::difference_type difference_type;
+    typedef Char const                           *pointer;
+    typedef Char const                           &reference;
+
+    const_iterator(void) : block_(nullptr), pos_(0)                                                                     { }
+
+    reference       operator*(void)                                                                          const          { return block_->segments[pos_ / block_->segment_size][pos_ % block_->segment_size]; }
+    pointer         operator->(void)                                                                         const          { return &**this;                          }
+    reference       operator[](difference_type n)                                                            const          { return *(*this + n);                     }
+
+    const_iterator &operator++(void)                                                                                        { ++pos_; return *this;                    }
+    const_iterator  operator++(int)                                                                                         { const_iterator it(*this); ++pos_; return it; }
+    const_iterator &operator--(void)                                                                                        { --pos_; return *this;                    }
+    const_iterator  operator--(int)                                                                                         { const_iterator it(*this); --pos_; return it; }
+    const_iterator &operator+=(difference_type n)                                                                           { pos_ += n; return *this;                 }
+    const_iterator &operator-=(difference_type n)                                                                           { pos_ -= n; return *this;                 }
+    const_iterator  operator+(difference_type n)                                                             const          { return const_iterator(block_, pos_ + n); }
+    const_iterator  operator-(difference_type n)                                                             const          { return const_iterator(block_, pos_ - n); }
+    difference_type operator-(const_iterator const &other)                                                   const          { return difference_type(pos_ - other.pos_); }
+
+    bool const operator==(const_iterator const &other)                                                       const noexcept { return pos_ == other.pos_;               }
+    bool const operator!=(const_iterator const &other)                                                       const noexcept { return pos_ != other.pos_;               }
+    bool const operator<(const_iterator const &other)                                                        const noexcept { return pos_ <  other.pos_;               }
+    bool const operator<=(const_iterator const &other)                                                       const noexcept { return pos_ <= other.pos_;               }
+    bool const operator>(const_iterator const &other)                                                        const noexcept { return pos_ >  other.pos_;               }
+    bool const operator>=(const_iterator const &other)                                                       const noexcept { return pos_ >= other.pos_;               }
+
+  private:
+    friend class basic_segmented_immutable_string;
+    const_iterator(block const *b, size_type pos) : block_(b), pos_(pos)                                                { }
+
+    block const *block_;
+    size_type    pos_;
+};
+
+// builds a segmented string from pieces appended in turn, such as the
+// blocks of a file. a segment is allocated when the previous one is full,
+// and the characters are copied once
+template<typename Char, typename Traits, typename Alloc>
+class basic_segmented_immutable_string<Char, Traits, Alloc>::builder
+{
+  public:
+    explicit builder(size_type segment_size = default_segment_size);
+
+    builder &append(Char const *s, size_type n);
+    builder &append(string_type const &str)                                                                                 { return append(str.data(), str.size()); }
+    builder &append(Char c)                                                                                                 { return append(&c, 1);                  }
+
+    size_type const size(void)                                                                               const noexcept { return block_->length;                 }
+
+    // the string built so far. the builder is left empty
+    basic_segmented_immutable_string finish(void);
+
+  private:
+    void flush(void);
+
+    std::shared_ptr<block>                 block_;
+    std::basic_string<Char, Traits, Alloc> current_;     // the segment being filled
+};
+
+typedef basic_segmented_immutable_string<char>    segmented_immutable_string;
+typedef basic_segmented_immutable_string<wchar_t> segmented_immutable_wstring;
+
+}   // namespace cdmh
+
+#include "segmented_immutable_string.inl"
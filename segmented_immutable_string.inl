@@ -0,0 +1,444 @@
+// Copyright (c) 2013 Craig Henderson
+// https://github.com/cdmh/cpp_immutable_string
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#pragma once
+
+namespace cdmh {
+
+template<typename Char, typename Traits, typename Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>::basic_segmented_immutable_string(string_type const &str, size_type segment_size)
+{
+    if (segment_size == 0)
+        throw std::invalid_argument("segment size must not be zero");
+
+    auto b = std::make_shared<block>();
+    b->segment_size = segment_size;
+    b->length       = str.size();
+    if (str.size() <= segment_size)
+    {
+        if (!str.empty())
+            b->segments.push_back(str);
+    }
+    else
+    {
+        for (size_type pos=0; pos<str.size(); pos+=segment_size)
+            b->segments.push_back(str.substr(pos, segment_size));
+    }
+    block_ = b;
+}
+
+// each segment is read directly into its own buffer, which becomes the
+// immutable string without a copy. only a short final segment is copied,
+// to release the unused part of its buffer
+template<typename Char, typename Traits, typename Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>::read(std::basic_istream<Char> &in, size_type segment_size)
+{
+    if (segment_size == 0)
+        throw std::invalid_argument("segment size must not be zero");
+
+    auto b = std::make_shared<block>();
+    b->segment_size = segment_size;
+    b->length       = 0;
+    for (;;)
+    {
+        std::basic_string<Char, Traits, Alloc> buffer(segment_size, Char());
+        in.read(&buffer[0], static_cast<std::streamsize>(segment_size));
+        size_type const count = static_cast<size_type>(in.gcount());
+        if (count == 0)
+            break;
+
+        if (count < segment_size)
+        {
+            buffer.resize(count);
+            buffer.shrink_to_fit();
+        }
+        b->length += count;
+        b->segments.push_back(string_type(std::move(buffer)));
+        if (count < segment_size)
+            break;
+    }
+    return basic_segmented_immutable_string(std::move(b));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+Char const &basic_segmented_immutable_string<Char, Traits, Alloc>::at(size_type pos) const
+{
+    if (pos >= size())
+        throw std::out_of_range("basic_segmented_immutable_string::at");
+    return (*this)[pos];
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::string_type
+basic_segmented_immutable_string<Char, Traits, Alloc>::str(void) const
+{
+    if (segment_count() == 1)
+        return block_->segments.front();
+
+    std::basic_string<Char, Traits, Alloc> result;
+    result.reserve(size());
+    for (auto const &segment : block_->segments)
+        result.append(segment.data(), segment.size());
+    return string_type(std::move(result));
+}
+
+// the block left in a string that has been moved from. it is shared without
+// an owner, so handing it out neither allocates nor counts references
+template<typename Char, typename Traits, typename Alloc>
+std::shared_ptr<typename basic_segmented_immutable_string<Char, Traits, Alloc>::block const>
+basic_segmented_immutable_string<Char, Traits, Alloc>::empty_block(void) noexcept
+{
+    static block const empty = { std::vector<string_type>(), default_segment_size, 0, {}, nullptr };
+    return std::shared_ptr<block const>(std::shared_ptr<block const>(), &empty);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::string_type const &
+basic_segmented_immutable_string<Char, Traits, Alloc>::flatten(void) const
+{
+    std::call_once(block_->flatten_once, [this]{ block_->flat.reset(new string_type(str())); });
+    return *block_->flat;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+int const basic_segmented_immutable_string<Char, Traits, Alloc>::compare(basic_segmented_immutable_string const &str) const noexcept
+{
+    if (block_ == str.block_)
+        return 0;
+
+    // walk the segments of both strings together, comparing the characters
+    // that they have in common in turn
+    size_type remaining = std::min(size(), str.size());
+    size_type lhs = 0, lhs_pos = 0;
+    size_type rhs = 0, rhs_pos = 0;
+    while (remaining != 0)
+    {
+        string_type const &l = block_->segments[lhs];
+        string_type const &r = str.block_->segments[rhs];
+        size_type const n = std::min(remaining, std::min(l.size() - lhs_pos, r.size() - rhs_pos));
+        int const result = Traits::compare(l.data() + lhs_pos, r.data() + rhs_pos, n);
+        if (result != 0)
+            return result;
+
+        remaining -= n;
+        lhs_pos   += n;
+        rhs_pos   += n;
+        if (lhs_pos == l.size())
+        {
+            ++lhs;
+            lhs_pos = 0;
+        }
+        if (rhs_pos == r.size())
+        {
+            ++rhs;
+            rhs_pos = 0;
+        }
+    }
+    return (size() < str.size())? -1 : (size() > str.size())? 1 : 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+int const basic_segmented_immutable_string<Char, Traits, Alloc>::compare(Char const *s, size_type n) const noexcept
+{
+    size_type const common = std::min(size(), n);
+    size_type       done   = 0;
+    for (auto const &segment : block_->segments)
+    {
+        if (done == common)
+            break;
+
+        size_type const length = std::min(segment.size(), common - done);
+        int const result = Traits::compare(segment.data(), s + done, length);
+        if (result != 0)
+            return result;
+        done += length;
+    }
+    return (size() < n)? -1 : (size() > n)? 1 : 0;
+}
+
+// whether the n characters from pos, which may span segments, equal s. the
+// caller ensures that pos + n <= size()
+template<typename Char, typename Traits, typename Alloc>
+bool const basic_segmented_immutable_string<Char, Traits, Alloc>::matches(size_type pos, Char const *s, size_type n) const noexcept
+{
+    size_type index  = pos / segment_size();
+    size_type offset = pos % segment_size();
+    while (n != 0)
+    {
+        string_type const &segment = block_->segments[index++];
+        size_type const length = std::min(n, segment.size() - offset);
+        if (Traits::compare(segment.data() + offset, s, length) != 0)
+            return false;
+        s     += length;
+        n     -= length;
+        offset = 0;
+    }
+    return true;
+}
+
+// a match lies either within a segment, where the segment's own find()
+// finds it, or starts in one segment and ends in a later one. the first
+// match within a segment starts before any match that crosses its end
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find(Char const *s, size_type pos, size_type n) const noexcept
+{
+    if (n == 0)
+        return (pos <= size())? pos : npos;
+    else if (pos >= size()  ||  n > size() - pos)
+        return npos;
+
+    for (size_type index=pos / segment_size(); index<segment_count(); ++index)
+    {
+        string_type const &segment = block_->segments[index];
+        size_type   const  base    = index * segment_size();
+        size_type   const  found   = segment.find(s, (pos > base)? pos - base : 0, n);
+        if (found != npos)
+            return base + found;
+
+        size_type const end = base + segment.size();
+        for (size_type start=std::max(pos, (end > n - 1)? end - (n - 1) : 0); start < end  &&  start + n <= size(); ++start)
+        {
+            if (Traits::eq(segment[start - base], *s)  &&  matches(start, s, n))
+                return start;
+        }
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find(Char c, size_type pos) const noexcept
+{
+    for (size_type index=pos / segment_size(); index<segment_count(); ++index)
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].find(c, (pos > base)? pos - base : 0);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+// the mirror of find(): within each segment, working backwards, a match
+// that crosses the end of the segment starts after any match within it
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::rfind(Char const *s, size_type pos, size_type n) const noexcept
+{
+    if (n > size())
+        return npos;
+
+    size_type const last = std::min(pos, size() - n);   // the last position that a match may start
+    if (n == 0)
+        return last;
+
+    for (size_type index=last / segment_size() + 1; index-- != 0; )
+    {
+        string_type const &segment = block_->segments[index];
+        size_type   const  base    = index * segment_size();
+        size_type   const  end     = base + segment.size();
+        size_type   const  first   = std::max(base, (end > n - 1)? end - (n - 1) : 0);
+        for (size_type start=std::min(last, end - 1) + 1; start-- > first; )
+        {
+            if (Traits::eq(segment[start - base], *s)  &&  matches(start, s, n))
+                return start;
+        }
+
+        size_type const found = segment.rfind(s, last - base, n);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::rfind(Char c, size_type pos) const noexcept
+{
+    if (empty())
+        return npos;
+
+    size_type const last = std::min(pos, size() - 1);
+    for (size_type index=last / segment_size() + 1; index-- != 0; )
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].rfind(c, last - base);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+// the segments are searched in turn, each from the position in it that
+// pos falls at or before
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find_first_of(Char const *s, size_type pos, size_type n) const noexcept
+{
+    for (size_type index=pos / segment_size(); index<segment_count(); ++index)
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].find_first_of(s, (pos > base)? pos - base : 0, n);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find_last_of(Char const *s, size_type pos, size_type n) const noexcept
+{
+    if (empty())
+        return npos;
+
+    size_type const last = std::min(pos, size() - 1);
+    for (size_type index=last / segment_size() + 1; index-- != 0; )
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].find_last_of(s, last - base, n);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find_first_not_of(Char const *s, size_type pos, size_type n) const noexcept
+{
+    for (size_type index=pos / segment_size(); index<segment_count(); ++index)
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].find_first_not_of(s, (pos > base)? pos - base : 0, n);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::size_type const
+basic_segmented_immutable_string<Char, Traits, Alloc>::find_last_not_of(Char const *s, size_type pos, size_type n) const noexcept
+{
+    if (empty())
+        return npos;
+
+    size_type const last = std::min(pos, size() - 1);
+    for (size_type index=last / segment_size() + 1; index-- != 0; )
+    {
+        size_type const base  = index * segment_size();
+        size_type const found = block_->segments[index].find_last_not_of(s, last - base, n);
+        if (found != npos)
+            return base + found;
+    }
+    return npos;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>::builder::builder(size_type segment_size)
+  : block_(std::make_shared<block>())
+{
+    if (segment_size == 0)
+        throw std::invalid_argument("segment size must not be zero");
+    block_->segment_size = segment_size;
+    block_->length       = 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+typename basic_segmented_immutable_string<Char, Traits, Alloc>::builder &
+basic_segmented_immutable_string<Char, Traits, Alloc>::builder::append(Char const *s, size_type n)
+{
+    size_type const segment_size = block_->segment_size;
+    while (n != 0)
+    {
+        if (current_.empty())
+            current_.reserve(segment_size);
+
+        size_type const length = std::min(n, segment_size - current_.size());
+        current_.append(s, length);
+        block_->length += length;
+        s += length;
+        n -= length;
+        if (current_.size() == segment_size)
+            flush();
+    }
+    return *this;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+void basic_segmented_immutable_string<Char, Traits, Alloc>::builder::flush(void)
+{
+    if (current_.empty())
+        return;
+
+    block_->segments.push_back(string_type(std::move(current_)));
+    current_.clear();
+}
+
+template<typename Char, typename Traits, typename Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>
+basic_segmented_immutable_string<Char, Traits, Alloc>::builder::finish(void)
+{
+    current_.shrink_to_fit();
+    flush();
+
+    auto b = std::make_shared<block>();
+    b->segment_size = block_->segment_size;
+    b->length       = 0;
+    std::swap(b, block_);
+    return basic_segmented_immutable_string(std::move(b));
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_segmented_immutable_string<Char, Traits, Alloc> const &lhs, basic_segmented_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.size() == rhs.size()  &&  lhs.compare(rhs) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator!=(basic_segmented_immutable_string<Char, Traits, Alloc> const &lhs, basic_segmented_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator<(basic_segmented_immutable_string<Char, Traits, Alloc> const &lhs, basic_segmented_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_segmented_immutable_string<Char, Traits, Alloc> const &lhs, basic_immutable_string<Char, Traits, Alloc> const &rhs)
+{
+    return lhs.size() == rhs.size()  &&  lhs.compare(rhs) == 0;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+inline bool const operator==(basic_segmented_immutable_string<Char, Traits, Alloc> const &lhs, Char const *rhs)
+{
+    return lhs.compare(rhs) == 0;
+}
+
+}   // namespace cdmh